@@ -9,10 +9,14 @@
 #include "mbed.h"
 
 #include <bitset>
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
 
+#include "l86_kalman.h"
 #include "minmea.h"
 
 #define MBED_CONF_L86_SPEED_UNIT SpeedUnit::KMH
@@ -25,6 +29,121 @@
 #define MBED_CONF_L86_SPEED_UNIT SpeedUnit::KNOTS
 #endif
 
+/* Defaults of the mbed_lib.json options, for builds without the Mbed configuration */
+#ifndef MBED_CONF_L86_RX_BUFFER_SIZE
+#define MBED_CONF_L86_RX_BUFFER_SIZE 256 //!< Receive ring size used when parsing is deferred
+#endif
+
+#ifndef MBED_CONF_L86_TX_BUFFER_SIZE
+#define MBED_CONF_L86_TX_BUFFER_SIZE 128 //!< Transmit ring size, at least one PMTK sentence
+#endif
+
+#ifndef MBED_CONF_L86_COMMAND_QUEUE_SIZE
+#define MBED_CONF_L86_COMMAND_QUEUE_SIZE 8 //!< Max number of queued PMTK commands, up to 31
+#endif
+
+#ifndef MBED_CONF_L86_PMTK_ACK_TIMEOUT
+#define MBED_CONF_L86_PMTK_ACK_TIMEOUT 500 //!< PMTK acknowledge timeout, in ms
+#endif
+
+#ifndef MBED_CONF_L86_PMTK_MAX_ATTEMPTS
+#define MBED_CONF_L86_PMTK_MAX_ATTEMPTS 5 //!< PMTK command transmissions before a timeout
+#endif
+
+#ifndef MBED_CONF_L86_STATS_ENABLED
+#define MBED_CONF_L86_STATS_ENABLED 0 //!< Record driver statistics, see L86::stats()
+#endif
+
+#ifndef MBED_CONF_L86_LATENCY_TRACE_ENABLED
+#define MBED_CONF_L86_LATENCY_TRACE_ENABLED 0 //!< Record sentence latencies, see L86::latency()
+#endif
+
+#ifndef MBED_CONF_L86_PPS_HOLDOVER
+#define MBED_CONF_L86_PPS_HOLDOVER 10 //!< Seconds without 1PPS pairing before losing the sync
+#endif
+
+#ifndef MBED_CONF_L86_UERE
+#define MBED_CONF_L86_UERE 5.0f //!< User equivalent range error, in m
+#endif
+
+#ifndef MBED_CONF_L86_PREDICTION_MAX_AGE
+#define MBED_CONF_L86_PREDICTION_MAX_AGE 2000 //!< Max extrapolation duration, in ms
+#endif
+
+#ifndef MBED_CONF_L86_PREDICTION_SPEED_ERROR
+#define MBED_CONF_L86_PREDICTION_SPEED_ERROR 0.5f //!< Speed error bound, in m/s
+#endif
+
+#ifndef MBED_CONF_L86_PREDICTION_MAX_ACCELERATION
+#define MBED_CONF_L86_PREDICTION_MAX_ACCELERATION 2.0f //!< Acceleration bound, in m/s^2
+#endif
+
+#ifndef MBED_CONF_L86_KALMAN_ENABLED
+#define MBED_CONF_L86_KALMAN_ENABLED 0 //!< Smooth fixes, see L86::smoothed_latitude()
+#endif
+
+#ifndef MBED_CONF_L86_KALMAN_FIXED_POINT
+#define MBED_CONF_L86_KALMAN_FIXED_POINT 0 //!< Q16.16 Kalman filter, for targets without FPU
+#endif
+
+#ifndef MBED_CONF_L86_KALMAN_PROCESS_NOISE
+#define MBED_CONF_L86_KALMAN_PROCESS_NOISE 0.5f //!< Acceleration noise density, in m^2/s^3
+#endif
+
+#ifndef MBED_CONF_L86_KALMAN_RESET_INTERVAL
+#define MBED_CONF_L86_KALMAN_RESET_INTERVAL 10 //!< Seconds without fix before a filter reset
+#endif
+
+#ifndef MBED_CONF_L86_PERSISTENCE_ENABLED
+#define MBED_CONF_L86_PERSISTENCE_ENABLED 0 //!< Save the last fix, see L86::save_state()
+#endif
+
+#ifndef MBED_CONF_L86_PERSISTENCE_KEY
+#define MBED_CONF_L86_PERSISTENCE_KEY "/kv/l86_state" //!< KVStore key of the saved state
+#endif
+
+#ifndef MBED_CONF_L86_PERSISTENCE_INTERVAL
+#define MBED_CONF_L86_PERSISTENCE_INTERVAL 300 //!< Min interval between automatic saves, in s
+#endif
+
+#ifndef MBED_CONF_L86_PERSISTENCE_MAX_AGE
+#define MBED_CONF_L86_PERSISTENCE_MAX_AGE 604800 //!< Older saved states are not injected, in s
+#endif
+
+#ifndef MBED_CONF_L86_MAX_FIX_CALLBACKS
+#define MBED_CONF_L86_MAX_FIX_CALLBACKS 4 //!< Max number of fix output callbacks
+#endif
+
+#ifndef MBED_CONF_L86_MAX_NMEA_SINKS
+#define MBED_CONF_L86_MAX_NMEA_SINKS 2 //!< Max number of raw sentence sinks
+#endif
+
+#ifndef MBED_CONF_L86_RMC_ENABLED
+#define MBED_CONF_L86_RMC_ENABLED 1 //!< Decode RMC sentences
+#endif
+
+#ifndef MBED_CONF_L86_GGA_ENABLED
+#define MBED_CONF_L86_GGA_ENABLED 1 //!< Decode GGA sentences
+#endif
+
+#ifndef MBED_CONF_L86_GSA_ENABLED
+#define MBED_CONF_L86_GSA_ENABLED 1 //!< Decode GSA sentences
+#endif
+
+#ifndef MBED_CONF_L86_GSV_ENABLED
+#define MBED_CONF_L86_GSV_ENABLED 1 //!< Decode GSV sentences
+#endif
+
+#ifndef MBED_CONF_L86_VTG_ENABLED
+#define MBED_CONF_L86_VTG_ENABLED 1 //!< Decode VTG sentences
+#endif
+
+#ifndef MBED_CONF_L86_GLL_ENABLED
+#define MBED_CONF_L86_GLL_ENABLED 1 //!< Decode GLL sentences
+#endif
+
+class L86ParserService;
+
 class L86 {
 
 public:
@@ -80,6 +199,7 @@ public:
         tm time;
         PositionningMode positionning_mode;
         FixStatusGGA fix_status;
+        int satellites_used; //!< Satellites used in the fix (GGA)
     } Informations;
 
     constexpr static int MAX_SATELLITES
@@ -98,6 +218,47 @@ public:
         float vertical;
     } DilutionOfPrecision;
 
+    typedef struct {
+        float north; //!< North position variance, in m^2
+        float east; //!< East position variance, in m^2
+        float vertical; //!< Vertical position variance, in m^2
+    } PositionCovariance;
+
+    typedef struct {
+        std::chrono::microseconds time; //!< UTC time of the fix, since the UNIX epoch
+        float latitude;
+        float longitude;
+        float altitude;
+        float speed_knots;
+        float course_over_ground;
+        DilutionOfPrecision dilution_of_precision;
+        FixStatusGGA fix_status;
+        int satellites_used; //!< Satellites used in the fix, 0 if unknown
+    } Fix;
+
+    constexpr static int MAX_FIX_CALLBACKS = MBED_CONF_L86_MAX_FIX_CALLBACKS;
+
+    constexpr static int MAX_NMEA_SINKS = MBED_CONF_L86_MAX_NMEA_SINKS;
+
+    /* Sentence types, indexed by minmea_sentence_id (MINMEA_UNKNOWN for the other sentences) */
+    typedef std::bitset<MINMEA_SENTENCE_COUNT> SentenceTypes;
+
+    /* Raw sentence sink, returns false if it dropped the sentence */
+    typedef Callback<bool(const char *sentence, size_t length)> NmeaSink;
+
+    typedef struct {
+        uint32_t forwarded; //!< Sentences taken by the sink
+        uint32_t dropped; //!< Sentences refused by the sink
+    } NmeaSinkStats;
+
+    typedef struct {
+        float latitude;
+        float longitude;
+        std::chrono::microseconds age; //!< Extrapolation duration since the last fix
+        float uncertainty; //!< Horizontal uncertainty bound, in m
+        bool valid; //!< False without fix or if the fix is older than the max prediction age
+    } Prediction;
+
     /* Start mode*/
     enum class StartMode {
         FULL_COLD_START,
@@ -105,6 +266,7 @@ public:
         WARM_START,
         HOT_START
     };
+#define START_MODES_COUNT 4
 
     /* Satellite system */
     enum class SatelliteSystem : size_t {
@@ -126,6 +288,38 @@ public:
         AL_BACKUP_MODE = 9
     };
 
+    /* Periodic mode timings, in ms */
+    typedef struct {
+        uint32_t run_time; //!< Full power period, 1000 to 518400000 ms
+        uint32_t sleep_time; //!< Standby/backup period, 1000 to 518400000 ms
+        uint32_t second_run_time; //!< Run time when no fix was obtained, 0 or >= run_time
+        uint32_t second_sleep_time; //!< Sleep time when no fix was obtained, 0 or >= 1000 ms
+    } PeriodicParameters;
+
+    /* Startup timings from start(), or from the driver construction, 0 when not reached */
+    typedef struct {
+        StartMode start_mode; //!< Mode of the last start(), if started
+        bool started; //!< false when measured from the driver construction (power-up)
+        std::chrono::milliseconds first_sentence; //!< First valid NMEA sentence
+        std::chrono::milliseconds first_valid_rmc; //!< First RMC with valid status
+        std::chrono::milliseconds first_fix_2d; //!< First GSA with a 2D or 3D fix
+        std::chrono::milliseconds first_fix_3d; //!< First GSA with a 3D fix
+        uint32_t fix_losses; //!< GSA fix lost after the first fix
+        uint32_t reacquisitions;
+        std::chrono::milliseconds last_reacquisition; //!< Duration of the last fix loss
+        std::chrono::milliseconds max_reacquisition;
+        std::chrono::milliseconds total_reacquisition;
+    } TtffReport;
+
+    /* EPO data stored in the module, GPS times of the sets validity */
+    typedef struct {
+        int sets; //!< Number of stored 6 hours sets, 0 when no EPO data is available
+        int first_week; //!< GPS week of the first set
+        int first_tow; //!< GPS time of week of the first set, in s
+        int last_week; //!< GPS week of the last set
+        int last_tow; //!< GPS time of week of the last set, in s
+    } EpoInfo;
+
     /* NMEA commande types */
     enum class NmeaCommandType : size_t {
         RMC,
@@ -163,6 +357,159 @@ public:
 
     typedef std::bitset<NMEA_COMMANDS_COUNT> NmeaCommands;
 
+    /* Sentence output rates configured in the module */
+    typedef struct {
+        uint8_t frequencies[NMEA_COMMANDS_COUNT]; //!< Fixes per sentence, 0 if disabled, by type
+    } NmeaOutput;
+
+    /* Module firmware release */
+    typedef struct {
+        char release[MINMEA_PMTK_RELEASE_MAX_LENGTH]; //!< Firmware release string
+        char build_id[MINMEA_PMTK_RELEASE_MAX_LENGTH];
+        char product_model[MINMEA_PMTK_RELEASE_MAX_LENGTH];
+    } FirmwareRelease;
+
+    /* Module configuration handled by apply() */
+    typedef struct {
+        SatelliteSystems satellite_systems;
+        NmeaOutput nmea_output;
+        NavigationMode navigation_mode;
+        uint16_t fix_interval; //!< Position fix interval, in ms
+    } Configuration;
+
+    /* Configuration fields */
+    enum class ConfigurationField : size_t {
+        SATELLITE_SYSTEMS,
+        NMEA_OUTPUT,
+        NAVIGATION_MODE,
+        FIX_INTERVAL
+    };
+#define CONFIGURATION_FIELDS_COUNT 4
+
+    typedef std::bitset<CONFIGURATION_FIELDS_COUNT> ConfigurationFields;
+
+    /* Driver statistics */
+    typedef struct {
+        uint32_t sentences[NMEA_COMMANDS_COUNT]; //!< Parsed sentences, indexed by NmeaCommandType
+        uint32_t pmtk_acks;
+        uint32_t checksum_failures; //!< Invalid sentences (bad checksum or malformed)
+        uint32_t framing_overflows;
+        uint32_t framing_errors; //!< Sentences dropped on a non-printable or misplaced byte
+        uint32_t resynchronizations; //!< Sentences interrupted by the '$' of a new one
+        uint32_t recovered_sentences; //!< Valid sentences that interrupted a previous one
+        uint32_t unknown_sentences;
+        uint32_t pmtk_retries;
+        uint32_t pmtk_timeouts;
+        uint64_t receive_cycles; //!< CPU cycles spent receiving, see stats()
+        uint64_t parse_cycles; //!< CPU cycles spent parsing, see stats()
+    } Stats;
+
+    /* Latency tracing stages */
+    enum class LatencyStage : size_t {
+        RECEPTION, //!< From the sentence '$' to its '\n'
+        PARSING, //!< From the sentence '\n' to the parse completion
+        PUBLICATION, //!< From the parse completion to the fix publication
+        TOTAL //!< From the sentence '$' to the fix publication
+    };
+#define LATENCY_STAGES_COUNT 4
+
+    constexpr static int LATENCY_BUCKETS = 24; //!< Log-scale buckets, up to 2^24 us
+
+    typedef struct {
+        uint32_t buckets[LATENCY_BUCKETS]; //!< Bucket n counts latencies in [2^n, 2^(n+1)[ us
+        uint32_t count;
+        uint32_t min_us;
+        uint32_t max_us;
+        uint64_t total_us;
+    } LatencyHistogram;
+
+    /* Queued PMTK command handle, 0 is never a valid handle */
+    typedef uint32_t CommandHandle;
+
+    /* Queued PMTK command status */
+    enum class CommandStatus {
+        QUEUED, //!< Waiting for the previous commands
+        PENDING, //!< Being sent, or waiting for its acknowledge
+        SUCCEEDED, //!< Acknowledged, or sent if no acknowledge is expected
+        FAILED, //!< Acknowledged with the failure flag
+        UNSUPPORTED, //!< Acknowledged with the unsupported flag
+        INVALID, //!< Acknowledged with the invalid command flag
+        TIMEOUT, //!< Not acknowledged after MBED_CONF_L86_PMTK_MAX_ATTEMPTS transmissions
+        UNKNOWN //!< Invalid handle, or command too old to be tracked
+    };
+
+    /* Result of L86::restore_state() */
+    enum class RestoreResult {
+        RESTORED, //!< Saved fix injected as reference location
+        NO_STATE, //!< No saved state, or persistence disabled
+        UNKNOWN_TIME, //!< Current UTC time unknown, or behind the saved fix
+        TOO_OLD, //!< Saved fix older than MBED_CONF_L86_PERSISTENCE_MAX_AGE
+        FAILED //!< Reference location not acknowledged by the module
+    };
+
+    /*!
+     *  Result of an asynchronous configuration method, completed by the module acknowledge
+     *
+     *  With C++20 coroutines, it can be awaited for the acknowledge flag. The coroutine is
+     *  resumed from the context completing the command (parsing context, or interrupt on
+     *  timeout), like the then() functions, so it must not block before moving to a thread.
+     */
+    class CommandFuture {
+    public:
+        CommandFuture();
+
+        CommandFuture(L86 *l86, CommandHandle handle);
+
+        /*!
+         *  Check if the command was queued
+         */
+        bool valid() const;
+
+        /*!
+         *  Check if the command completed, without blocking
+         */
+        bool ready() const;
+
+        CommandStatus status() const;
+
+        /*!
+         *  Wait for the command completion, do not call from an interrupt
+         *
+         *  \return acknowledge flag, MINMEA_PMTK_FLAG_INVALID on timeout or invalid future
+         */
+        enum minmea_pmtk_flag get();
+
+        /*!
+         *  Call a function on completion, from interrupt or parsing context
+         *
+         *  \param done completion function
+         *
+         *  \return true on success, false if the command already completed
+         */
+        bool then(Callback<void(CommandStatus)> done);
+
+#if defined(__cpp_impl_coroutine)
+        bool await_ready() const
+        {
+            return !valid() || ready();
+        }
+
+        bool await_suspend(std::coroutine_handle<> coroutine)
+        {
+            return then([coroutine](CommandStatus) { coroutine.resume(); });
+        }
+
+        enum minmea_pmtk_flag await_resume() const
+        {
+            return L86::command_flag(status());
+        }
+#endif
+
+    private:
+        L86 *_l86;
+        CommandHandle _handle;
+    };
+
     /*!
      *  Default L86 constructor
      *
@@ -177,6 +524,11 @@ public:
      */
     bool set_satellite_system(SatelliteSystems satellite_system);
 
+    /*!
+     *  Non-blocking set_satellite_system()
+     */
+    CommandFuture set_satellite_system_async(SatelliteSystems satellite_system);
+
     /*!
      *  Select NMEA output frequencies
      *
@@ -185,6 +537,24 @@ public:
      */
     bool set_nmea_output_frequency(NmeaCommands nmea_commands, NmeaFrequency frequency);
 
+    /*!
+     *  Non-blocking set_nmea_output_frequency()
+     */
+    CommandFuture set_nmea_output_frequency_async(
+            NmeaCommands nmea_commands, NmeaFrequency frequency);
+
+    /*!
+     *  Select the output frequency of each NMEA sentence
+     *
+     *  \param output fixes per sentence, 0 to disable it, by sentence type
+     */
+    bool set_nmea_output(const NmeaOutput &output);
+
+    /*!
+     *  Non-blocking set_nmea_output()
+     */
+    CommandFuture set_nmea_output_async(const NmeaOutput &output);
+
     /*!
      *  Select navigation mode
      *
@@ -192,6 +562,11 @@ public:
      */
     bool set_navigation_mode(NavigationMode navigation_mode);
 
+    /*!
+     *  Non-blocking set_navigation_mode()
+     */
+    CommandFuture set_navigation_mode_async(NavigationMode navigation_mode);
+
     /*!
      *  Set position fix interval
      *
@@ -199,6 +574,40 @@ public:
      */
     bool set_position_fix_interval(uint16_t interval);
 
+    /*!
+     *  Non-blocking set_position_fix_interval()
+     */
+    CommandFuture set_position_fix_interval_async(uint16_t interval);
+
+    /*!
+     *  Configure the module, sending only the settings which differ from its known configuration
+     *
+     *  The driver keeps the configuration confirmed by the module (acknowledged settings and
+     *  query replies), until the module restarts (PMTK010 startup message). Settings not known
+     *  are always sent, so applying an unchanged configuration costs no command.
+     *
+     *  \param configuration module configuration
+     *  \param fields configuration fields to apply, all by default
+     *
+     *  \return true on success, false if a setting was not acknowledged
+     */
+    bool apply(const Configuration &configuration,
+            ConfigurationFields fields = ConfigurationFields().set());
+
+    /*!
+     *  Get the configuration confirmed by the module
+     *
+     *  \param configuration filled with the known configuration fields
+     *
+     *  \return known configuration fields
+     */
+    ConfigurationFields known_configuration(Configuration *configuration);
+
+    /*!
+     *  Forget the known configuration, for instance after a module power cycle
+     */
+    void invalidate_configuration();
+
     /*!
      *  Start the L86 module in the specified mode
      *
@@ -206,6 +615,77 @@ public:
      */
     bool start(StartMode start_mode);
 
+    /*!
+     *  Non-blocking start(), completed once the command is sent
+     */
+    CommandFuture start_async(StartMode start_mode);
+
+    /*!
+     *  Time to first fix measured after the last start in the given mode
+     *
+     *  The time is measured from start() to the first valid position.
+     *
+     *  \param start_mode (full cold, cold, warm, hot)
+     *
+     *  \return time to first fix, 0 if not measured yet
+     */
+    std::chrono::milliseconds time_to_first_fix(StartMode start_mode);
+
+    /*!
+     *  Get the startup and reacquisition timings since the last start()
+     */
+    TtffReport ttff_report();
+
+    /*!
+     *  Print the startup and reacquisition timings
+     *
+     *  \param stream output stream
+     */
+    void dump_ttff_report(FILE *stream = stdout);
+
+    /*!
+     *  Give an approximate position and the current time to the module (PMTK741)
+     *
+     *  The module narrows its satellite search with them, use it before start().
+     *
+     *  \param latitude reference latitude, in degrees
+     *  \param longitude reference longitude, in degrees
+     *  \param altitude reference altitude, in m
+     *  \param utc_time current UTC time
+     */
+    bool set_reference_location(float latitude, float longitude, float altitude, time_t utc_time);
+
+    /*!
+     *  Save the last valid fix in the KVStore
+     *
+     *  Needs MBED_CONF_L86_PERSISTENCE_ENABLED. Writes flash: do not call from an interrupt.
+     *
+     *  \return true on success, false without valid fix or on KVStore error
+     */
+    bool save_state();
+
+    /*!
+     *  Inject the saved fix as reference location, see set_reference_location()
+     *
+     *  Needs MBED_CONF_L86_PERSISTENCE_ENABLED. States older than
+     *  MBED_CONF_L86_PERSISTENCE_MAX_AGE are not injected. The RTC is not kept across a power
+     *  cycle on most targets: without backup domain, set it with set_time() or pass the time.
+     *
+     *  \param utc_time current UTC time, 0 to use the RTC
+     *
+     *  \return RestoreResult::UNKNOWN_TIME if the time is unset or behind the saved fix
+     */
+    RestoreResult restore_state(time_t utc_time = 0);
+
+    /*!
+     *  Save the fix automatically, at most every MBED_CONF_L86_PERSISTENCE_INTERVAL seconds
+     *
+     *  Needs MBED_CONF_L86_PERSISTENCE_ENABLED.
+     *
+     *  \param queue event queue calling save_state(), NULL to stop saving
+     */
+    void enable_persistence(EventQueue *queue);
+
     /*!
      *  Put the module in periodic standby mode
      *
@@ -214,6 +694,142 @@ public:
      */
     bool standby_mode(StandbyMode standby_mode);
 
+    /*!
+     *  Non-blocking standby_mode()
+     */
+    CommandFuture standby_mode_async(StandbyMode standby_mode);
+
+    /*!
+     *  Put the module in a periodic standby or backup mode with its timings
+     *
+     *  \param standby_mode (periodic backup, periodic standby)
+     *  \param parameters run and sleep times
+     */
+    bool standby_mode(StandbyMode standby_mode, const PeriodicParameters &parameters);
+
+    /*!
+     *  Non-blocking standby_mode() with timings
+     */
+    CommandFuture standby_mode_async(
+            StandbyMode standby_mode, const PeriodicParameters &parameters);
+
+    /*!
+     *  Query the EPO data stored in the module (PMTK607)
+     *
+     *  \param info filled with the stored sets on success
+     *
+     *  \return true on success, false if the module did not answer
+     */
+    bool epo_info(EpoInfo *info);
+
+    /*!
+     *  Non-blocking epo_info()
+     *
+     *  \param info filled with the stored sets when the query succeeds, must stay valid until
+     *  the query completes
+     */
+    CommandFuture epo_info_async(EpoInfo *info);
+
+    /*!
+     *  Query the module firmware release (PMTK605)
+     *
+     *  \param release filled with the firmware release on success
+     *
+     *  \return true on success, false if the module did not answer
+     */
+    bool firmware_release(FirmwareRelease *release);
+
+    /*!
+     *  Non-blocking firmware_release()
+     *
+     *  \param release filled with the firmware release when the query succeeds, must stay
+     *  valid until the query completes
+     */
+    CommandFuture firmware_release_async(FirmwareRelease *release);
+
+    /*!
+     *  Query the sentence output rates (PMTK414)
+     *
+     *  \param output filled with the output rates on success
+     *
+     *  \return true on success, false if the module did not answer
+     */
+    bool nmea_output(NmeaOutput *output);
+
+    /*!
+     *  Non-blocking nmea_output()
+     *
+     *  \param output filled with the output rates when the query succeeds, must stay valid
+     *  until the query completes
+     */
+    CommandFuture nmea_output_async(NmeaOutput *output);
+
+    /*!
+     *  Query the position fix interval (PMTK400)
+     *
+     *  \param interval filled with the fix interval in ms on success
+     *
+     *  \return true on success, false if the module did not answer
+     */
+    bool position_fix_interval(uint16_t *interval);
+
+    /*!
+     *  Non-blocking position_fix_interval()
+     *
+     *  \param interval filled with the fix interval in ms when the query succeeds, must stay
+     *  valid until the query completes
+     */
+    CommandFuture position_fix_interval_async(uint16_t *interval);
+
+    /*!
+     *  Queue a PMTK command, without blocking
+     *
+     *  Commands are sent one at a time by the serial transmit interrupt, each one waiting for
+     *  its acknowledge (if expected) before the next one. Can be called from any thread or
+     *  from an interrupt.
+     *
+     *  \param message PMTK command
+     *  \param done function called from interrupt or parsing context when the command
+     *  completes, may be NULL
+     *
+     *  \return command handle, 0 if the queue is full
+     */
+    CommandHandle send_command(const minmea_sentence_pmtk &message,
+            Callback<void(CommandStatus)> done = nullptr);
+
+    /*!
+     *  Get the status of a queued command
+     *
+     *  \param handle command handle
+     */
+    CommandStatus command_status(CommandHandle handle);
+
+    /*!
+     *  Wait for the completion of a queued command, do not call from an interrupt
+     *
+     *  \param handle command handle
+     *
+     *  \return command final status
+     */
+    CommandStatus wait_command(CommandHandle handle);
+
+    /*!
+     *  Replace the completion function of a queued command
+     *
+     *  \param handle command handle
+     *  \param done function called from interrupt or parsing context on completion
+     *
+     *  \return true on success, false if the command already completed
+     */
+    bool attach_command_callback(CommandHandle handle, Callback<void(CommandStatus)> done);
+
+    /*!
+     *  Acknowledge flag corresponding to a command status
+     *
+     *  \param status command status
+     */
+    static enum minmea_pmtk_flag command_flag(CommandStatus status);
+
     /*!
      *  Start receiving message from L86 module
      *
@@ -225,6 +841,24 @@ public:
      */
     void stop_receive();
 
+    /*!
+     *  Hand the serial link over to another protocol, such as the EPO binary mode
+     *
+     *  Waits for the queued commands to complete and for their characters to be sent, then
+     *  detaches the reception and transmission interrupts. Commands sent while the I/O is
+     *  suspended are queued until resume_io(). Do not call from an interrupt.
+     *
+     *  \param timeout max wait for the command queue to be idle
+     *
+     *  \return serial link, NULL on timeout
+     */
+    FileHandle *suspend_io(std::chrono::milliseconds timeout);
+
+    /*!
+     *  Take the serial link back after suspend_io(), and send the commands queued meanwhile
+     */
+    void resume_io();
+
     Satellite *satellites();
 
     float latitude();
@@ -233,6 +867,22 @@ public:
 
     double altitude();
 
+    /*!
+     *  Kalman-smoothed position, raw position if MBED_CONF_L86_KALMAN_ENABLED is not set
+     *
+     *  Without fix, the last estimate is kept, and the filter restarts on the next fix.
+     */
+    float smoothed_latitude();
+
+    float smoothed_longitude();
+
+    double smoothed_altitude();
+
+    /*!
+     *  Covariance of the smoothed position, zeroed if MBED_CONF_L86_KALMAN_ENABLED is not set
+     */
+    PositionCovariance smoothed_covariance();
+
     double speed(SpeedUnit unit);
 
     double speed();
@@ -253,11 +903,289 @@ public:
 
     int registered_satellite_count();
 
+    /*!
+     *  Get a snapshot of the driver statistics
+     *
+     *  Cycles are counted with the DWT cycle counter on Cortex-M3 and above, in microseconds
+     *  (us ticker) on Cortex-M0/M0+, and in nanoseconds on host builds.
+     *
+     *  \return statistics, always zeroed if MBED_CONF_L86_STATS_ENABLED is not set
+     */
+    Stats stats();
+
+    /*!
+     *  Reset the driver statistics
+     */
+    void reset_stats();
+
+    /*!
+     *  Get the driver monotonic clock, used to timestamp received sentences
+     *
+     *  \return time elapsed since the driver creation
+     */
+    std::chrono::microseconds now();
+
+    /*!
+     *  Get a snapshot of a latency histogram
+     *
+     *  \param stage traced stage
+     *
+     *  \return histogram, always empty if MBED_CONF_L86_LATENCY_TRACE_ENABLED is not set
+     */
+    LatencyHistogram latency(LatencyStage stage);
+
+    /*!
+     *  Reset all latency histograms
+     */
+    void reset_latency();
+
+    /*!
+     *  Print all latency histograms
+     *
+     *  \param stream output stream
+     */
+    void dump_latency(FILE *stream = stdout);
+
+    /*!
+     *  Discipline the UTC clock with the module 1PPS output
+     *
+     *  \param pps interrupt connected to the module 1PPS pin
+     */
+    void enable_pps(InterruptIn *pps);
+
+    /*!
+     *  Notify a 1PPS rising edge, the edge is paired with the next RMC time
+     *  Called by the 1PPS interrupt, may also be called by an external or fake 1PPS source
+     *
+     *  \param edge_time edge capture time in the driver monotonic clock
+     */
+    void pps_edge(std::chrono::microseconds edge_time);
+
+    /*!
+     *  Get the current UTC time, without blocking
+     *
+     *  \return microseconds since the UNIX epoch, 0 until a 1PPS edge has been paired
+     */
+    std::chrono::microseconds utc_now();
+
+    /*!
+     *  Check that a 1PPS edge has recently been paired with a RMC time
+     *
+     *  \return true if the last pairing is less than MBED_CONF_L86_PPS_HOLDOVER seconds old
+     */
+    bool pps_synchronized();
+
+    /*!
+     *  Get the measured drift of the driver clock against GPS time
+     *
+     *  \return drift in ppm, positive if the driver clock runs fast
+     */
+    float clock_drift_ppm();
+
+    /*!
+     *  Extrapolate the position from the last fix with its speed and course over ground
+     *
+     *  \param at_time prediction time in the driver monotonic clock (see now())
+     *
+     *  \return predicted position
+     */
+    Prediction predict(std::chrono::microseconds at_time);
+
+    /*!
+     *  Get the last published fix
+     */
+    Fix fix();
+
+    /*!
+     *  Attach a function to the fix output
+     *
+     *  The function is called from the parsing context (the serial interrupt unless a
+     *  L86ParserService is used) for each received RMC, GGA or GLL position, so it must not
+     *  block. Sentences of a same epoch publish fixes with the same time.
+     *
+     *  \param func function called with each published fix
+     *
+     *  \return true on success, false if MAX_FIX_CALLBACKS functions are already attached
+     */
+    bool attach_fix_callback(Callback<void(const Fix &)> func);
+
+    /*!
+     *  Attach a sink to the raw sentence output
+     *
+     *  Each sentence with a valid checksum is handed to the sinks before being parsed, as a
+     *  span of the driver framing buffer: from its '$' to its "\r\n", not null terminated and
+     *  only valid during the call. Sinks are called from the parsing context, so they must not
+     *  block: a sink that cannot take a sentence returns false and the sentence is counted as
+     *  dropped for this sink only. See L86NmeaBuffer for a buffered sink with drop policies.
+     *
+     *  \param sink function called with each forwarded sentence
+     *  \param types sentence types forwarded to the sink, all by default
+     *
+     *  \return sink index, or -1 if MAX_NMEA_SINKS sinks are already attached
+     */
+    int attach_nmea_sink(NmeaSink sink, SentenceTypes types = SentenceTypes().set());
+
+    /*!
+     *  Get the forwarding counters of a sink
+     *
+     *  \param sink sink index, as returned by attach_nmea_sink()
+     */
+    NmeaSinkStats nmea_sink_stats(int sink);
+
 private:
+    friend class L86ParserService;
+
     UnbufferedSerial *_uart;
-    minmea_sentence_pmtk _current_pmtk_message;
+    /* Queued PMTK command */
+    typedef struct {
+        CommandHandle handle;
+        CommandStatus status;
+        enum minmea_pmtk_packet_type type;
+        bool ack_expected;
+        uint8_t attempts;
+        char sentence[MINMEA_PMTK_MAX_LENGTH];
+        Callback<void(CommandStatus)> done;
+        enum minmea_sentence_id reply; // reply completing a query, MINMEA_UNKNOWN otherwise
+        void *reply_data; // decoded reply destination
+    } Command;
+
+    Command _commands[MBED_CONF_L86_COMMAND_QUEUE_SIZE];
+    Configuration _configuration; // confirmed by the module, for the _configuration_known fields
+    ConfigurationFields _configuration_known;
+    Configuration _pending_configuration; // sent, waiting for _configuration_commands
+    CommandHandle _configuration_commands[CONFIGURATION_FIELDS_COUNT];
+    CircularBuffer<uint8_t, MBED_CONF_L86_COMMAND_QUEUE_SIZE> _command_queue; // slots to send
+    int _active_command; // slot being sent or waiting for its acknowledge, -1 if none
+    bool _io_suspended; // the serial link is handed over, queued commands wait
+    int _next_command_slot;
+    uint32_t _command_sequence;
+    EventFlags _command_flags; // one flag per slot, set on completion
+    Timeout _command_timeout;
+    CircularBuffer<char, MBED_CONF_L86_TX_BUFFER_SIZE> _tx_buffer;
     int _registered_satellite_count;
     char _received_message[MINMEA_MAX_LENGTH];
+    int _message_len;
+    /* Decoded sentence, shared by all the sentence types */
+    union {
+        struct minmea_sentence_pmtk_ack pmtk_ack;
+        struct minmea_sentence_pmtk_epo_info pmtk_epo_info;
+        struct minmea_sentence_pmtk_fix_ctl pmtk_fix_ctl;
+        struct minmea_sentence_pmtk_nmea_output pmtk_nmea_output;
+        struct minmea_sentence_pmtk_release pmtk_release;
+        struct minmea_sentence_pmtk_system_message pmtk_system_message;
+#if MBED_CONF_L86_RMC_ENABLED
+        struct minmea_sentence_rmc rmc;
+#endif
+#if MBED_CONF_L86_VTG_ENABLED
+        struct minmea_sentence_vtg vtg;
+#endif
+#if MBED_CONF_L86_GGA_ENABLED
+        struct minmea_sentence_gga gga;
+#endif
+#if MBED_CONF_L86_GSA_ENABLED
+        struct minmea_sentence_gsa gsa;
+#endif
+#if MBED_CONF_L86_GSV_ENABLED
+        struct minmea_sentence_gsv gsv;
+#endif
+#if MBED_CONF_L86_GLL_ENABLED
+        struct minmea_sentence_gll gll;
+#endif
+    } _frame;
+    /* Sentence framing state */
+    enum class FramingState {
+        HUNT, //!< Waiting for a '$'
+        BODY, //!< Between the '$' and the '*'
+        CHECKSUM_HIGH,
+        CHECKSUM_LOW,
+        END //!< Waiting for the '\n'
+    };
+    FramingState _framing_state;
+    uint8_t _framing_checksum; // XOR of the body bytes received so far
+    int _received_checksum; // -1 if the sentence has no checksum field
+    bool _framing_recovering; // the current sentence interrupted the previous one
+    L86ParserService *_parser_service;
+    CircularBuffer<char, MBED_CONF_L86_RX_BUFFER_SIZE> _rx_buffer;
+    uint32_t _rx_overflows;
+#if MBED_CONF_L86_STATS_ENABLED
+    Stats _stats;
+#endif
+    Timer _timer;
+    InterruptIn *_pps;
+    std::chrono::microseconds _pps_edge_time;
+    bool _pps_edge_pending;
+    bool _pps_paired;
+    std::chrono::microseconds _sync_local_time; // driver clock at the last paired edge
+    time_t _sync_utc_time; // UTC second of the last paired edge
+    float _clock_drift; // driver clock drift, relative
+    int32_t _utc_days; // days since the UNIX epoch, from the last RMC date
+    int32_t _utc_seconds_of_day;
+    time_t _utc_time; // cached UNIX time, updated with the date and time fields
+    int32_t _utc_microseconds;
+    bool _fix_available;
+    std::chrono::microseconds _fix_local_time; // driver clock at the last fix epoch
+    float _fix_latitude;
+    float _fix_longitude;
+    float _latitude_rate; // deg/s
+    float _longitude_rate; // deg/s
+    float _fix_uncertainty; // m
+    Fix _fix;
+    Callback<void(const Fix &)> _fix_callbacks[MAX_FIX_CALLBACKS];
+    /* Raw sentence sink */
+    typedef struct {
+        NmeaSink sink;
+        SentenceTypes types;
+        NmeaSinkStats stats;
+    } NmeaSinkSlot;
+
+    NmeaSinkSlot _nmea_sinks[MAX_NMEA_SINKS];
+    StartMode _start_mode;
+    std::chrono::microseconds _start_time;
+    bool _ttff_pending; // no valid fix since the last start()
+    std::chrono::milliseconds _ttff[START_MODES_COUNT];
+    TtffReport _ttff_report;
+    bool _fix_lost;
+    std::chrono::microseconds _fix_lost_time;
+#if MBED_CONF_L86_PERSISTENCE_ENABLED
+    /* Saved state, the version changes with the layout */
+    typedef struct {
+        uint32_t version;
+        float latitude;
+        float longitude;
+        float altitude;
+        int64_t utc_time;
+    } PersistentState;
+
+    EventQueue *_persistence_queue;
+    bool _state_saved;
+    std::chrono::microseconds _saved_fix_time; // UTC time of the last saved fix
+#endif
+#if MBED_CONF_L86_KALMAN_ENABLED
+#if MBED_CONF_L86_KALMAN_FIXED_POINT
+    typedef L86Fixed KalmanScalar;
+#else
+    typedef float KalmanScalar;
+#endif
+    L86KalmanAxis<KalmanScalar> _kalman_north;
+    L86KalmanAxis<KalmanScalar> _kalman_east;
+    L86KalmanAxis<KalmanScalar> _kalman_vertical;
+    bool _kalman_initialized;
+    bool _kalman_outage; // fixless sentences since the last filtered fix, reseed on the next fix
+    bool _kalman_altitude_pending; // a GGA altitude has not been filtered yet
+    int64_t _kalman_epoch; // UTC time of the last filtered fix, in us
+    std::chrono::microseconds _kalman_time; // driver clock of the last filtered fix
+    float _kalman_origin_latitude;
+    float _kalman_origin_longitude;
+    float _kalman_meters_per_longitude_degree;
+#endif
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+    LatencyHistogram _latency[LATENCY_STAGES_COUNT];
+    CircularBuffer<uint32_t, 16> _arrival_times; // '$' and '\n' arrival times of buffered bytes
+    uint32_t _arrival_times_missing; // delimiters buffered after _arrival_times, without time
+    uint32_t _sentence_start_time;
+    uint32_t _sentence_end_time;
+    uint32_t _sentence_parsed_time;
+#endif
     Position _position_informations;
     Movement _movement_informations;
     Informations _global_informations;
@@ -281,6 +1209,38 @@ private:
      */
     void get_received_message();
 
+    /*!
+     *  Callback called when the serial RX state changes and parsing is deferred to a
+     *  L86ParserService: only move received characters to the receive ring
+     */
+    void buffer_received_message();
+
+    /*!
+     *  Parse at most max_bytes characters from the receive ring
+     *
+     *  \param max_bytes maximum number of characters to consume
+     *  \param sentences incremented for each completed sentence
+     *
+     *  \return number of characters consumed
+     */
+    size_t process_received_bytes(size_t max_bytes, uint32_t *sentences);
+
+    /*!
+     *  Add a character to the received message buffer
+     *  And parse the received message when it's completed
+     *
+     *  Every '$' starts a new sentence, non-printable bytes drop the current one, and the
+     *  checksum is computed as the bytes arrive.
+     *
+     *  \return true if a complete message has been parsed
+     */
+    bool receive_character(char c);
+
+    /*!
+     *  Drop the sentence being received, wait for the next '$'
+     */
+    void reset_framing();
+
     void set_positionning_mode(char c_positionning_mode);
 
     void set_fix_status(int c_fix_status);
@@ -297,7 +1257,175 @@ private:
 
     void set_latitude(minmea_float latitude);
 
-    void parse_message(char *message);
+    /*!
+     *  Parse a complete sentence and publish the fix if it holds a position
+     *
+     *  Each sentence type has its handler and is decoded in the shared _frame union, so
+     *  that only one decoded sentence is alive at a time and none is on the stack.
+     *
+     *  Worst-case stack use, from the stack_report target of the host tests (GCC -Os
+     *  -fstack-usage, x86-64, 32 bit targets use less): parse_message() 48 + handle_gsv() 32 +
+     *  minmea_parse_gsv() 160 + minmea_scan() 192 + minmea_isfield() 16 = 448 bytes. The
+     *  publication path (publish_fix() 80 bytes) and the acknowledge path (acknowledge_command()
+     *  80 + complete_command() 112 bytes) are shallower, the fix and command callbacks attached
+     *  by the application come on top.
+     */
+    void parse_message(char *message, size_t length);
+
+    /*!
+     *  Hand a sentence to the attached sinks
+     *
+     *  \param sentence_id sentence type
+     *  \param sentence sentence, from its '$' to its "\r\n"
+     *  \param length sentence length
+     */
+    void forward_sentence(enum minmea_sentence_id sentence_id, const char *sentence, size_t length);
+
+    /* Sentence handlers, return true if the sentence updated the position */
+    typedef bool (L86::*SentenceHandler)(const char *message);
+
+    bool handle_pmtk_ack(const char *message);
+
+    bool handle_pmtk_epo_info(const char *message);
+
+    bool handle_pmtk_fix_ctl(const char *message);
+
+    bool handle_pmtk_nmea_output(const char *message);
+
+    bool handle_pmtk_release(const char *message);
+
+    bool handle_pmtk_system_message(const char *message);
+
+#if MBED_CONF_L86_RMC_ENABLED
+    bool handle_rmc(const char *message);
+#endif
+
+#if MBED_CONF_L86_VTG_ENABLED
+    bool handle_vtg(const char *message);
+#endif
+
+#if MBED_CONF_L86_GGA_ENABLED
+    bool handle_gga(const char *message);
+#endif
+
+#if MBED_CONF_L86_GSA_ENABLED
+    bool handle_gsa(const char *message);
+#endif
+
+#if MBED_CONF_L86_GSV_ENABLED
+    bool handle_gsv(const char *message);
+#endif
+
+#if MBED_CONF_L86_GLL_ENABLED
+    bool handle_gll(const char *message);
+#endif
+
+    static const SentenceHandler _sentence_handlers[MINMEA_SENTENCE_COUNT]; // by sentence id
+
+    /*!
+     *  Called when a new position has been decoded from the current sentence
+     */
+    void publish_fix();
+
+    /*!
+     *  Copy the next queued command to the transmit ring, called with interrupts disabled
+     */
+    void start_next_command();
+
+    /*!
+     *  Copy the active command to the transmit ring and start its acknowledge timeout
+     */
+    void transmit_command();
+
+    /*!
+     *  Serial transmit interrupt: write the transmit ring content
+     */
+    void transmit_buffered_characters();
+
+    void command_timeout();
+
+    /*!
+     *  Match a PMTK acknowledge with the active command
+     *
+     *  \param type acknowledged command type
+     *  \param flag acknowledge result
+     */
+    void acknowledge_command(int type, int flag);
+
+    /*!
+     *  Match a query reply with the active command and decode it to the query destination
+     *
+     *  \param reply reply sentence type, decoded in _frame
+     */
+    void answer_query(enum minmea_sentence_id reply);
+
+    /*!
+     *  Queue a PMTK query, completed by its reply sentence instead of its acknowledge
+     *
+     *  \param type query command type
+     *  \param reply reply sentence type
+     *  \param data decoded reply destination
+     *
+     *  \return command handle, 0 if the queue is full
+     */
+    CommandHandle send_query(
+            enum minmea_pmtk_packet_type type, enum minmea_sentence_id reply, void *data);
+
+    /*!
+     *  Complete the active command and start the next one, called with interrupts disabled
+     *
+     *  \param status command final status
+     *  \param done filled with the command completion function, to call with interrupts enabled
+     */
+    void complete_command(CommandStatus status, Callback<void(CommandStatus)> *done);
+
+    /*!
+     *  Queue a configuration command and record the setting it carries
+     *
+     *  \param message PMTK command
+     *  \param field configuration field of the command, updated in _pending_configuration
+     */
+    CommandFuture send_configuration(const minmea_sentence_pmtk &message, ConfigurationField field);
+
+    /*!
+     *  Update the known configuration on a command completion, called with interrupts disabled
+     *
+     *  \param command completed command
+     *  \param status command final status
+     */
+    void update_configuration(const Command &command, CommandStatus status);
+
+    /*!
+     *  Record the startup and reacquisition events of a new GSA fix status
+     */
+    void track_fix_status();
+
+    /*!
+     *  Arrival time in us, in the driver monotonic clock, of the current '$' or '\n' character
+     *
+     *  To be called once for each '$' and '\n' character, whatever the framing state, so that
+     *  buffered times stay paired with their characters. Characters buffered without time get
+     *  the current time.
+     */
+    uint32_t arrival_time();
+
+    void record_latency(LatencyStage stage, uint32_t start, uint32_t end);
+
+    /*!
+     *  Feed the Kalman filter with the last fix
+     *
+     *  \param fix_local_time local time of the fix epoch
+     *  \param speed speed over ground, in m/s
+     *  \param course course over ground, in rad
+     */
+    void smooth_fix(std::chrono::microseconds fix_local_time, float speed, float course);
+
+    void pps_rise();
+
+    /*!
+     *  Pair the pending 1PPS edge with the time of the current RMC sentence
+     */
+    void pair_pps_edge(minmea_time time);
 };
 
 #endif /* CATIE_SIXTRON_L86_H_ */
\ No newline at end of file
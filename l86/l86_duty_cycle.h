@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CATIE_SIXTRON_L86_DUTY_CYCLE_H_
+#define CATIE_SIXTRON_L86_DUTY_CYCLE_H_
+
+#include "mbed.h"
+
+#include "l86.h"
+
+#ifndef MBED_CONF_L86_DUTY_CYCLE_MOVING_SPEED
+#define MBED_CONF_L86_DUTY_CYCLE_MOVING_SPEED 2.0f //!< Speed going back to continuous, in knots
+#endif
+
+#ifndef MBED_CONF_L86_DUTY_CYCLE_STATIONARY_SPEED
+#define MBED_CONF_L86_DUTY_CYCLE_STATIONARY_SPEED 0.5f //!< Speed considered as parked, in knots
+#endif
+
+#ifndef MBED_CONF_L86_DUTY_CYCLE_STATIONARY_FIXES
+#define MBED_CONF_L86_DUTY_CYCLE_STATIONARY_FIXES 10 //!< Parked fixes before going periodic
+#endif
+
+#ifndef MBED_CONF_L86_DUTY_CYCLE_MAX_HDOP
+#define MBED_CONF_L86_DUTY_CYCLE_MAX_HDOP 5.0f //!< Worse fixes keep the module continuous
+#endif
+
+#ifndef MBED_CONF_L86_DUTY_CYCLE_RUN_TIME
+#define MBED_CONF_L86_DUTY_CYCLE_RUN_TIME 10000 //!< Periodic run time, in ms
+#endif
+
+#ifndef MBED_CONF_L86_DUTY_CYCLE_MIN_SLEEP_TIME
+#define MBED_CONF_L86_DUTY_CYCLE_MIN_SLEEP_TIME 10000 //!< First periodic sleep time, in ms
+#endif
+
+#ifndef MBED_CONF_L86_DUTY_CYCLE_MAX_SLEEP_TIME
+#define MBED_CONF_L86_DUTY_CYCLE_MAX_SLEEP_TIME 300000 //!< Longest periodic sleep time, in ms
+#endif
+
+#ifndef MBED_CONF_L86_DUTY_CYCLE_WAKE_UP_GUARD
+#define MBED_CONF_L86_DUTY_CYCLE_WAKE_UP_GUARD 500 //!< Receive restarted before the run, in ms
+#endif
+
+static_assert(MBED_CONF_L86_DUTY_CYCLE_MIN_SLEEP_TIME > MBED_CONF_L86_DUTY_CYCLE_WAKE_UP_GUARD,
+        "the receive must restart within the module sleep time");
+
+/*!
+ *  Adaptive periodic mode scheduling, fed by the driver fix output
+ *
+ *  The module runs continuously while moving or without a good fix. After
+ *  MBED_CONF_L86_DUTY_CYCLE_STATIONARY_FIXES parked fixes, it is put in periodic standby mode
+ *  and the sleep time is doubled after each parked run, up to
+ *  MBED_CONF_L86_DUTY_CYCLE_MAX_SLEEP_TIME. Reception is stopped while the module sleeps so
+ *  that the MCU does not wake up on serial activity.
+ *
+ *  The receive windows follow the module cycle rather than free-running timers: a window opens
+ *  MBED_CONF_L86_DUTY_CYCLE_WAKE_UP_GUARD before the expected run, and closes
+ *  MBED_CONF_L86_DUTY_CYCLE_RUN_TIME after the first fix output of the run. Without output, it
+ *  stays open for a whole module cycle, so that a drifted run is caught again.
+ *
+ *  PMTK commands block, so they are sent from the given event queue.
+ */
+class L86DutyCycleScheduler {
+
+public:
+    /*!
+     *  Default L86DutyCycleScheduler constructor
+     *
+     *  \param l86 driver instance
+     *  \param queue event queue used to configure the module and time the receive windows
+     */
+    L86DutyCycleScheduler(L86 *l86, EventQueue *queue);
+
+    /*!
+     *  Evaluate a fix, to be attached to the driver fix output
+     *
+     *  \param fix published fix
+     */
+    void process(const L86::Fix &fix);
+
+    /*!
+     *  Check if the module is in periodic mode
+     */
+    bool periodic();
+
+    /*!
+     *  Current periodic sleep time, in ms
+     */
+    uint32_t sleep_time();
+
+private:
+    enum class State {
+        CONTINUOUS,
+        PERIODIC
+    };
+
+    L86 *_l86;
+    EventQueue *_queue;
+    State _state;
+    State _target;
+    bool _reschedule_pending;
+    int _stationary_fixes;
+    std::chrono::microseconds _last_fix_time; // time of the last counted fix
+    bool _run_stationary; // a parked fix was received during the current periodic run
+    uint32_t _sleep_time;
+    int _window_event;
+    bool _window_anchored; // the current receive window is aligned on the module run
+
+    void request(State target);
+
+    void reschedule();
+
+    bool configure_periodic();
+
+    /*!
+     *  End of a periodic run: stretch the sleep time if parked and stop receiving
+     */
+    void close_window();
+
+    /*!
+     *  Start of a periodic run: receive again until the run output
+     */
+    void open_window();
+
+    /*!
+     *  First output of a periodic run: close the window at the end of the run
+     */
+    void anchor_window();
+};
+
+#endif /* CATIE_SIXTRON_L86_DUTY_CYCLE_H_ */
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CATIE_SIXTRON_L86_EPO_H_
+#define CATIE_SIXTRON_L86_EPO_H_
+
+#include "mbed.h"
+
+#include "l86.h"
+
+#ifndef MBED_CONF_L86_EPO_WINDOW
+#define MBED_CONF_L86_EPO_WINDOW 4 //!< EPO packets sent ahead of their acknowledge
+#endif
+
+#ifndef MBED_CONF_L86_EPO_ACK_TIMEOUT
+#define MBED_CONF_L86_EPO_ACK_TIMEOUT 1000 //!< EPO packet acknowledge timeout, in ms
+#endif
+
+#ifndef MBED_CONF_L86_EPO_MAX_RETRIES
+#define MBED_CONF_L86_EPO_MAX_RETRIES 3 //!< Retransmissions of a window before giving up
+#endif
+
+#ifndef MBED_CONF_L86_EPO_BAUDRATE
+#define MBED_CONF_L86_EPO_BAUDRATE 9600 //!< Link baudrate given back to the module in NMEA mode
+#endif
+
+/*!
+ *  EPO (Extended Prediction Orbit) data upload
+ *
+ *  The EPO file (MTK14.EPO, 1920 bytes per 6 hours set) is sent to the module as MTK binary
+ *  packets of three 60 bytes satellite records. Up to MBED_CONF_L86_EPO_WINDOW packets are
+ *  sent before waiting for their acknowledge, so that the serial line is not idle during the
+ *  module flash writes; a missing or negative acknowledge resends the window from the first
+ *  unacknowledged packet. A window of 1 gives the stop-and-wait exchange of the reference
+ *  tools.
+ *
+ *  The module is switched to binary mode for the upload and back to NMEA afterwards.
+ */
+class L86EpoUploader {
+
+public:
+    constexpr static size_t SV_RECORD_SIZE = 60; //!< Size of a satellite record, in bytes
+    constexpr static size_t SV_RECORDS_PER_PACKET = 3;
+    constexpr static size_t PACKET_DATA_SIZE = SV_RECORD_SIZE * SV_RECORDS_PER_PACKET;
+
+    enum class Result {
+        SUCCESS,
+        SOURCE_ERROR, //!< The EPO data could not be read or is not a whole number of records
+        LINK_ERROR, //!< The serial link failed
+        TIMEOUT, //!< A packet was not acknowledged after MBED_CONF_L86_EPO_MAX_RETRIES
+        REJECTED //!< The module rejected the data, or has no valid EPO data afterwards
+    };
+
+    /* Upload report */
+    typedef struct {
+        uint32_t bytes; //!< EPO bytes sent
+        uint32_t packets; //!< Data packets sent, retransmissions included
+        uint32_t retransmissions;
+        std::chrono::milliseconds duration;
+        uint32_t throughput; //!< EPO bytes per second
+        L86::EpoInfo info; //!< EPO data stored in the module, only filled with a driver
+    } Report;
+
+    /*!
+     *  L86EpoUploader constructor for a module driven by the L86 driver
+     *
+     *  The driver I/O is suspended during the upload, once its queued commands are sent (see
+     *  L86::suspend_io()), and the stored data is checked with L86::epo_info() afterwards.
+     *
+     *  \param l86 driver instance
+     *  \param window packets sent ahead of their acknowledge, 1 to MBED_CONF_L86_EPO_WINDOW
+     */
+    L86EpoUploader(L86 *l86, uint8_t window = MBED_CONF_L86_EPO_WINDOW);
+
+    /*!
+     *  L86EpoUploader constructor for a raw serial link to the module
+     *
+     *  \param link serial link, the module must be in NMEA mode
+     *  \param window packets sent ahead of their acknowledge, 1 to MBED_CONF_L86_EPO_WINDOW
+     */
+    L86EpoUploader(FileHandle *link, uint8_t window = MBED_CONF_L86_EPO_WINDOW);
+
+    /*!
+     *  Upload an EPO file
+     *
+     *  \param file EPO file, read from its current position to its end
+     *  \param report filled with the upload statistics, may be NULL
+     */
+    Result upload(FileHandle *file, Report *report = nullptr);
+
+    /*!
+     *  Upload EPO data stored in a block device
+     *
+     *  \param block_device block device, its read size must divide SV_RECORD_SIZE
+     *  \param address address of the EPO data
+     *  \param size size of the EPO data, a multiple of SV_RECORD_SIZE
+     *  \param report filled with the upload statistics, may be NULL
+     */
+    Result upload(BlockDevice *block_device,
+            bd_addr_t address,
+            bd_size_t size,
+            Report *report = nullptr);
+
+private:
+    /* Reads up to size bytes of EPO data, returns the number of read bytes or a negative error */
+    typedef Callback<ssize_t(uint8_t *buffer, size_t size)> Source;
+
+    /* Binary packet reception state */
+    enum class RxState {
+        PREAMBLE_1,
+        PREAMBLE_2,
+        PAYLOAD,
+    };
+
+    L86 *_l86;
+    FileHandle *_link;
+    uint8_t _window;
+    uint8_t _packets[MBED_CONF_L86_EPO_WINDOW][PACKET_DATA_SIZE]; // unacknowledged packets data
+    RxState _rx_state;
+    uint8_t _rx_packet[16];
+    size_t _rx_len;
+    FileHandle *_file;
+    BlockDevice *_block_device;
+    bd_addr_t _block_address;
+    bd_size_t _block_remaining;
+
+    Result run(Source source, Report *report);
+
+    Result transfer(Source source, Report *report);
+
+    ssize_t read_file(uint8_t *buffer, size_t size);
+
+    ssize_t read_block_device(uint8_t *buffer, size_t size);
+
+    /*!
+     *  Send a binary packet
+     *
+     *  \param command MTK binary command
+     *  \param payload command payload
+     *  \param size payload size
+     */
+    bool send_packet(uint16_t command, const uint8_t *payload, size_t size);
+
+    bool send_data_packet(uint16_t sequence, const uint8_t *data);
+
+    /*!
+     *  Wait for an EPO data acknowledge
+     *
+     *  \param sequence filled with the acknowledged packet sequence number
+     *  \param success filled with the acknowledge result
+     *  \param timeout max waiting time
+     *
+     *  \return true if an acknowledge was received
+     */
+    bool wait_ack(uint16_t *sequence, bool *success, std::chrono::milliseconds timeout);
+};
+
+#endif /* CATIE_SIXTRON_L86_EPO_H_ */
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CATIE_SIXTRON_L86_FIX_HISTORY_H_
+#define CATIE_SIXTRON_L86_FIX_HISTORY_H_
+
+#include <atomic>
+#include <cmath>
+
+#include "l86.h"
+
+/*!
+ *  Fixed-capacity history of published fixes, with time-indexed queries
+ *
+ *  Attach it to the fix output of a driver:
+ *  \code
+ *  L86FixHistory<64> history;
+ *  l86.attach_fix_callback(callback(&history, &L86FixHistory<64>::append));
+ *  \endcode
+ *
+ *  There is a single writer, the driver parsing context. Readers never lock: they retry when
+ *  the writer updated the ring during the read and give up after MAX_READ_ATTEMPTS attempts.
+ *
+ *  Fixes without position (invalid status, or NaN latitude/longitude) are not stored. They
+ *  mark a gap, which is not interpolated across: a time between the last fix before an outage
+ *  and the first fix after it is not found.
+ *
+ *  \tparam N history length, in fixes
+ */
+template <size_t N> class L86FixHistory {
+
+public:
+    static_assert(N >= 2, "history must hold at least two fixes");
+
+    enum class Interpolation {
+        LINEAR,
+        GREAT_CIRCLE
+    };
+
+    constexpr static int MAX_READ_ATTEMPTS = 4;
+
+    L86FixHistory(): _head(0), _count(0), _outage(false), _sequence(0)
+    {
+    }
+
+    /*!
+     *  Append a fix, a fix with the same time as the latest one replaces it
+     *
+     *  \param fix published fix, ignored without position
+     */
+    void append(const L86::Fix &fix)
+    {
+        if (fix.fix_status == L86::FixStatusGGA::INVALID || !std::isfinite(fix.latitude)
+                || !std::isfinite(fix.longitude)) {
+            _outage = true;
+            return;
+        }
+        begin_write();
+        if (_count > 0 && _fixes[index(_count - 1)].time == fix.time) {
+            _fixes[index(_count - 1)] = fix;
+        } else if (_count == 0 || fix.time > _fixes[index(_count - 1)].time) {
+            _fixes[_head] = fix;
+            _gaps[_head] = _outage;
+            _outage = false;
+            _head = (_head + 1) % N;
+            if (_count < N) {
+                _count++;
+            }
+        }
+        end_write();
+    }
+
+    /*!
+     *  Remove all fixes
+     */
+    void clear()
+    {
+        begin_write();
+        _head = 0;
+        _count = 0;
+        end_write();
+    }
+
+    size_t size() const
+    {
+        return _count;
+    }
+
+    /*!
+     *  Get the fix at a given time, interpolated between its two neighbours
+     *
+     *  \param time UTC time since the UNIX epoch
+     *  \param fix interpolated fix
+     *  \param interpolation latitude/longitude interpolation method
+     *
+     *  \return false if the time is out of the history range or the read could not complete
+     */
+    bool at(std::chrono::microseconds time,
+            L86::Fix *fix,
+            Interpolation interpolation = Interpolation::LINEAR) const
+    {
+        L86::Fix before, after;
+        bool found = false;
+        for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+            uint32_t sequence = _sequence.load(std::memory_order_acquire);
+            if (sequence & 1) {
+                continue;
+            }
+            found = find(time, &before, &after);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_sequence.load(std::memory_order_relaxed) == sequence) {
+                if (!found) {
+                    return false;
+                }
+                interpolate(before, after, time, fix, interpolation);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*!
+     *  Get the latest fix
+     *
+     *  \param fix latest fix
+     *
+     *  \return false if the history is empty or the read could not complete
+     */
+    bool latest(L86::Fix *fix) const
+    {
+        for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+            uint32_t sequence = _sequence.load(std::memory_order_acquire);
+            if (sequence & 1) {
+                continue;
+            }
+            size_t count = _count;
+            if (count > 0) {
+                *fix = _fixes[index(count - 1)];
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_sequence.load(std::memory_order_relaxed) == sequence) {
+                return count > 0;
+            }
+        }
+        return false;
+    }
+
+private:
+    L86::Fix _fixes[N];
+    bool _gaps[N]; // an outage precedes the fix
+    size_t _head; // next write position
+    size_t _count;
+    bool _outage; // fixes without position since the latest stored fix, writer only
+    std::atomic<uint32_t> _sequence; // odd while the writer updates the ring
+
+    size_t index(size_t position) const
+    {
+        return (_head + N - _count + position) % N;
+    }
+
+    void begin_write()
+    {
+        _sequence.store(_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void end_write()
+    {
+        _sequence.store(_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /*!
+     *  Binary search of the two fixes surrounding a time
+     *
+     *  \return false if the time is out of the history range or within a gap
+     */
+    bool find(std::chrono::microseconds time, L86::Fix *before, L86::Fix *after) const
+    {
+        size_t count = _count;
+        if (count == 0 || time < _fixes[index(0)].time || time > _fixes[index(count - 1)].time) {
+            return false;
+        }
+        size_t low = 0;
+        size_t high = count - 1;
+        while (high - low > 1) {
+            size_t middle = low + (high - low) / 2;
+            if (_fixes[index(middle)].time <= time) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        *before = _fixes[index(low)];
+        *after = _fixes[index(high)];
+        return high == low || !_gaps[index(high)] || time == before->time;
+    }
+
+    static float lerp(float a, float b, float ratio)
+    {
+        return a + (b - a) * ratio;
+    }
+
+    /*!
+     *  Interpolate an angle in degrees along the shortest arc
+     */
+    static float lerp_angle(float a, float b, float ratio)
+    {
+        float delta = b - a;
+        if (delta > 180.0f) {
+            delta -= 360.0f;
+        } else if (delta < -180.0f) {
+            delta += 360.0f;
+        }
+        float angle = a + delta * ratio;
+        if (angle > 180.0f) {
+            angle -= 360.0f;
+        } else if (angle <= -180.0f) {
+            angle += 360.0f;
+        }
+        return angle;
+    }
+
+    static void interpolate(const L86::Fix &before,
+            const L86::Fix &after,
+            std::chrono::microseconds time,
+            L86::Fix *fix,
+            Interpolation interpolation)
+    {
+        int64_t span = (after.time - before.time).count();
+        float ratio = span > 0 ? static_cast<float>((time - before.time).count()) / span : 0.0f;
+
+        *fix = ratio < 0.5f ? before : after;
+        fix->time = time;
+        fix->altitude = lerp(before.altitude, after.altitude, ratio);
+        fix->speed_knots = lerp(before.speed_knots, after.speed_knots, ratio);
+        fix->course_over_ground = fmodf(
+                lerp_angle(before.course_over_ground, after.course_over_ground, ratio) + 360.0f,
+                360.0f);
+        fix->dilution_of_precision.positional = lerp(before.dilution_of_precision.positional,
+                after.dilution_of_precision.positional,
+                ratio);
+        fix->dilution_of_precision.horizontal = lerp(before.dilution_of_precision.horizontal,
+                after.dilution_of_precision.horizontal,
+                ratio);
+        fix->dilution_of_precision.vertical = lerp(
+                before.dilution_of_precision.vertical, after.dilution_of_precision.vertical, ratio);
+
+        if (interpolation == Interpolation::LINEAR) {
+            fix->latitude = lerp(before.latitude, after.latitude, ratio);
+            fix->longitude = lerp_angle(before.longitude, after.longitude, ratio);
+        } else {
+            great_circle(before, after, ratio, fix);
+        }
+    }
+
+    /*!
+     *  Spherical linear interpolation of the position
+     */
+    static void great_circle(
+            const L86::Fix &before, const L86::Fix &after, float ratio, L86::Fix *fix)
+    {
+        constexpr float DEGREES_TO_RADIANS = 0.0174532925f;
+        float latitude_a = before.latitude * DEGREES_TO_RADIANS;
+        float longitude_a = before.longitude * DEGREES_TO_RADIANS;
+        float latitude_b = after.latitude * DEGREES_TO_RADIANS;
+        float longitude_b = after.longitude * DEGREES_TO_RADIANS;
+        float a[3] = { cosf(latitude_a) * cosf(longitude_a),
+            cosf(latitude_a) * sinf(longitude_a),
+            sinf(latitude_a) };
+        float b[3] = { cosf(latitude_b) * cosf(longitude_b),
+            cosf(latitude_b) * sinf(longitude_b),
+            sinf(latitude_b) };
+        float cosine = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+        float angle = acosf(fminf(fmaxf(cosine, -1.0f), 1.0f));
+        float weight_a = 1.0f - ratio;
+        float weight_b = ratio;
+        if (angle > 1e-6f) {
+            weight_a = sinf((1.0f - ratio) * angle) / sinf(angle);
+            weight_b = sinf(ratio * angle) / sinf(angle);
+        }
+        float p[3];
+        for (int i = 0; i < 3; i++) {
+            p[i] = weight_a * a[i] + weight_b * b[i];
+        }
+        fix->latitude = atan2f(p[2], sqrtf(p[0] * p[0] + p[1] * p[1])) / DEGREES_TO_RADIANS;
+        fix->longitude = atan2f(p[1], p[0]) / DEGREES_TO_RADIANS;
+    }
+};
+
+#endif /* CATIE_SIXTRON_L86_FIX_HISTORY_H_ */
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CATIE_SIXTRON_L86_FUSION_H_
+#define CATIE_SIXTRON_L86_FUSION_H_
+
+#include "mbed.h"
+
+#include "l86.h"
+
+#ifndef MBED_CONF_L86_FUSION_MAX_RECEIVERS
+#define MBED_CONF_L86_FUSION_MAX_RECEIVERS 3 //!< Max number of fused receivers
+#endif
+
+#ifndef MBED_CONF_L86_FUSION_EPOCH_TOLERANCE
+#define MBED_CONF_L86_FUSION_EPOCH_TOLERANCE 50 //!< Max time offset in a same epoch, in ms
+#endif
+
+#ifndef MBED_CONF_L86_FUSION_MAX_HDOP
+#define MBED_CONF_L86_FUSION_MAX_HDOP 10.0f //!< Fixes with a larger HDOP are not fused
+#endif
+
+#ifndef MBED_CONF_L86_FUSION_SATELLITES
+#define MBED_CONF_L86_FUSION_SATELLITES 6 //!< Satellites used giving a fix its full weight
+#endif
+
+#ifndef MBED_CONF_L86_FUSION_OUTLIER_THRESHOLD
+#define MBED_CONF_L86_FUSION_OUTLIER_THRESHOLD 3.0f //!< Outlier distance, in standard deviations
+#endif
+
+#ifndef MBED_CONF_L86_FUSION_OUTLIER_MIN_DISTANCE
+#define MBED_CONF_L86_FUSION_OUTLIER_MIN_DISTANCE 10.0f //!< Distance never rejected, in m
+#endif
+
+/*!
+ *  Fusion of the fixes of several receivers into one fix per epoch
+ *
+ *  Each receiver feeds its fixes, from its driver fix output or from a replayed stream. Fixes
+ *  within MBED_CONF_L86_FUSION_EPOCH_TOLERANCE of each other make an epoch, which is fused when
+ *  the first fix of the next epoch arrives, so that it holds every sentence of the epoch.
+ *
+ *  A fix is weighted by the inverse of its position variance: (HDOP * UERE)^2, lowered for a
+ *  differential fix, raised for an estimated fix or with fewer satellites used than
+ *  MBED_CONF_L86_FUSION_SATELLITES. Invalid fixes and fixes above MBED_CONF_L86_FUSION_MAX_HDOP
+ *  are not fused.
+ *
+ *  The fix agreeing with most of the others (and with the previous fused fix, extrapolated to
+ *  the epoch) is the reference, and fixes farther from it than
+ *  MBED_CONF_L86_FUSION_OUTLIER_THRESHOLD standard deviations are rejected. Memory is static and
+ *  the work per epoch only depends on MBED_CONF_L86_FUSION_MAX_RECEIVERS.
+ */
+class L86FixFusion {
+
+public:
+    constexpr static int MAX_RECEIVERS = MBED_CONF_L86_FUSION_MAX_RECEIVERS;
+
+    enum class Health {
+        UNKNOWN, //!< No epoch fused yet
+        MISSING, //!< No fix in the last epoch
+        NO_FIX, //!< Invalid fix, or HDOP above MBED_CONF_L86_FUSION_MAX_HDOP
+        OUTLIER, //!< Fix rejected, inconsistent with the reference
+        USED //!< Fix fused
+    };
+
+    typedef struct {
+        Health health; //!< Health in the last epoch
+        float weight; //!< Share of the receiver in the last fused fix, from 0 to 1
+        float offset; //!< Distance to the last fused position, in m, NAN if unknown
+        uint32_t used; //!< Epochs fused
+        uint32_t rejected; //!< Epochs rejected as outlier
+        uint32_t missed; //!< Epochs without fix, or with an unusable fix
+    } ReceiverHealth;
+
+    /*!
+     *  Default L86FixFusion constructor
+     */
+    L86FixFusion();
+
+    /*!
+     *  Add a receiver
+     *
+     *  \param l86 driver instance whose fix output feeds the receiver, or NULL to feed it with
+     *  process()
+     *
+     *  \return receiver index, -1 if MAX_RECEIVERS receivers are already added or if the driver
+     *  fix output is full
+     */
+    int add_receiver(L86 *l86 = nullptr);
+
+    /*!
+     *  Attach a function called with each fused fix, from the fix output context of the
+     *  receiver starting the next epoch
+     *
+     *  Without any usable fix, the fused fix is published with an invalid status.
+     */
+    void attach(Callback<void(const L86::Fix &)> func);
+
+    /*!
+     *  Feed a fix of a receiver, from its fix output context or a replayed stream
+     *
+     *  \param receiver receiver index
+     *  \param fix received fix
+     */
+    void process(int receiver, const L86::Fix &fix);
+
+    /*!
+     *  Fuse and publish the pending epoch, at the end of a replayed stream
+     */
+    void flush();
+
+    /*!
+     *  Get the health of a receiver
+     *
+     *  \param receiver receiver index
+     */
+    ReceiverHealth health(int receiver);
+
+private:
+    typedef struct {
+        L86FixFusion *fusion;
+        int index;
+        bool pending; // fix received in the open epoch
+        L86::Fix fix;
+        float variance; // m^2, NAN if unusable
+        ReceiverHealth health;
+
+        void process(const L86::Fix &fix)
+        {
+            fusion->process(index, fix);
+        }
+    } Receiver;
+
+    Receiver _receivers[MAX_RECEIVERS];
+    int _receiver_count;
+    Callback<void(const L86::Fix &)> _callback;
+    bool _epoch_open;
+    std::chrono::microseconds _epoch; // time of the first fix of the open epoch
+    std::chrono::microseconds _last_epoch; // last fused epoch, 0 if none
+    bool _fused_valid;
+    L86::Fix _fused;
+    float _fused_variance; // m^2
+
+    /*!
+     *  Fuse the open epoch
+     *
+     *  \param fused filled with the fused fix
+     */
+    void fuse(L86::Fix *fused);
+
+    /*!
+     *  Select the reference fix among the usable ones
+     *
+     *  \return reference receiver index
+     */
+    int reference(const int *candidates, int count);
+
+    /*!
+     *  Check that two positions agree within their uncertainty
+     */
+    static bool consistent(float distance, float variance_a, float variance_b);
+
+    /*!
+     *  Position variance of a fix, from its HDOP, status and satellites used
+     *
+     *  \return variance in m^2, NAN if the fix is not usable
+     */
+    static float variance(const L86::Fix &fix);
+
+    /*!
+     *  North and east offsets of a position from a reference position, in m
+     */
+    static void offset(const L86::Fix &reference,
+            float latitude,
+            float longitude,
+            float *north,
+            float *east);
+};
+
+#endif /* CATIE_SIXTRON_L86_FUSION_H_ */
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CATIE_SIXTRON_L86_GEOFENCE_H_
+#define CATIE_SIXTRON_L86_GEOFENCE_H_
+
+#include "mbed.h"
+
+#include "l86.h"
+
+#ifndef MBED_CONF_L86_GEOFENCE_MAX_INSIDE
+#define MBED_CONF_L86_GEOFENCE_MAX_INSIDE 16 //!< Max number of fences containing a same fix
+#endif
+
+/*!
+ *  Polygon geofencing engine, fed by the driver fix output
+ *
+ *  Fences are compiled once into a uniform grid: each cell lists the fences overlapping it,
+ *  whether the cell center is inside each of them and the fence edges crossing the cell. A fix
+ *  is then located by toggling the center state for each edge crossed by the segment from the
+ *  cell center to the fix, so only the few edges of its cell are tested.
+ *
+ *  The compiled Index only holds pointers to plain arrays: it may be compiled offline and
+ *  stored in flash, or compiled at startup in RAM with compile().
+ *
+ *  Fences crossing the antimeridian are not supported.
+ */
+class L86Geofence {
+
+public:
+    constexpr static int MAX_INSIDE = MBED_CONF_L86_GEOFENCE_MAX_INSIDE;
+
+    typedef struct {
+        int32_t latitude; //!< Latitude, in microdegrees
+        int32_t longitude; //!< Longitude, in microdegrees
+    } Vertex;
+
+    typedef struct {
+        const Vertex *vertices;
+        uint16_t vertex_count;
+        uint16_t dwell_time; //!< Seconds inside before a DWELL event, 0 to disable it
+    } Polygon;
+
+    typedef struct {
+        uint16_t fence;
+        uint16_t center_inside; //!< 1 if the cell center is inside the fence
+        uint32_t first_edge; //!< First edge in Index::edges
+        uint32_t edge_count;
+    } CellEntry;
+
+    typedef struct {
+        int32_t min_latitude; //!< Grid origin, in microdegrees
+        int32_t min_longitude;
+        int32_t cell_height; //!< Cell size, in microdegrees
+        int32_t cell_width;
+        uint16_t rows;
+        uint16_t columns;
+        const uint32_t *cell_offsets; //!< rows * columns + 1 offsets in entries
+        const CellEntry *entries;
+        const uint16_t *edges; //!< Fence edges, as the index of their first vertex
+        const Polygon *polygons;
+        uint16_t polygon_count;
+        uint32_t entry_count;
+        uint32_t edge_count;
+    } Index;
+
+    typedef struct {
+        uint32_t *cell_offsets; //!< rows * columns + 1 offsets
+        CellEntry *entries;
+        uint32_t max_entries;
+        uint16_t *edges;
+        uint32_t max_edges;
+    } Buffers;
+
+    enum class EventType {
+        ENTER,
+        EXIT,
+        DWELL
+    };
+
+    typedef struct {
+        EventType type;
+        uint16_t fence;
+        std::chrono::microseconds time; //!< UTC time of the fix which triggered the event
+    } Event;
+
+    /*!
+     *  Compile fences into a grid index
+     *
+     *  \param polygons fences, must outlive the index
+     *  \param polygon_count number of fences
+     *  \param rows number of grid rows
+     *  \param columns number of grid columns
+     *  \param buffers index storage
+     *  \param index compiled index, entry_count and edge_count give the needed storage even
+     *  when the buffers are too small
+     *
+     *  \return true on success, false if the buffers are too small
+     */
+    static bool compile(const Polygon *polygons,
+            uint16_t polygon_count,
+            uint16_t rows,
+            uint16_t columns,
+            const Buffers &buffers,
+            Index *index);
+
+    /*!
+     *  Default L86Geofence constructor
+     *
+     *  \param index compiled fences
+     */
+    L86Geofence(const Index *index);
+
+    /*!
+     *  Attach a function called for each geofence event, from the fix output context
+     */
+    void attach(Callback<void(const Event &)> func);
+
+    /*!
+     *  Evaluate a fix, to be attached to the driver fix output
+     *
+     *  \param fix published fix, ignored without valid position
+     */
+    void process(const L86::Fix &fix);
+
+    /*!
+     *  Check if the last fix is inside a fence
+     */
+    bool inside(uint16_t fence);
+
+    /*!
+     *  Number of fences which could not be tracked, MAX_INSIDE fences already containing the fix
+     */
+    uint32_t overflows();
+
+private:
+    typedef struct {
+        uint16_t fence;
+        bool dwell_reported;
+        std::chrono::microseconds enter_time;
+    } Presence;
+
+    const Index *_index;
+    Callback<void(const Event &)> _callback;
+    Presence _presences[MAX_INSIDE];
+    int _presence_count;
+    int32_t _last_cell;
+    uint32_t _overflows;
+
+    int32_t locate(int32_t latitude, int32_t longitude);
+
+    bool cell_has_edges(int32_t cell);
+
+    void emit(EventType type, uint16_t fence, std::chrono::microseconds time);
+
+    void check_dwell(std::chrono::microseconds time);
+};
+
+#endif /* CATIE_SIXTRON_L86_GEOFENCE_H_ */
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CATIE_SIXTRON_L86_KALMAN_H_
+#define CATIE_SIXTRON_L86_KALMAN_H_
+
+#include <cstdint>
+
+/*!
+ *  Q16.16 fixed-point number, for Kalman filtering on targets without FPU
+ *
+ *  Conversions from float saturate to +/-MAX, and NaN converts to 0.
+ */
+class L86Fixed {
+
+public:
+    constexpr static int FRACTIONAL_BITS = 16;
+    constexpr static float MAX = 32767.0f; //!< Largest converted magnitude
+
+    constexpr L86Fixed(): _raw(0)
+    {
+    }
+
+    L86Fixed(float value): _raw(saturate(value))
+    {
+    }
+
+    float to_float() const
+    {
+        return static_cast<float>(_raw) / (1 << FRACTIONAL_BITS);
+    }
+
+    L86Fixed operator+(L86Fixed other) const
+    {
+        return from_raw(_raw + other._raw);
+    }
+
+    L86Fixed operator-(L86Fixed other) const
+    {
+        return from_raw(_raw - other._raw);
+    }
+
+    L86Fixed operator*(L86Fixed other) const
+    {
+        return from_raw(static_cast<int32_t>(
+                (static_cast<int64_t>(_raw) * other._raw) >> FRACTIONAL_BITS));
+    }
+
+    L86Fixed operator/(L86Fixed other) const
+    {
+        if (other._raw == 0) {
+            return from_raw(0);
+        }
+        return from_raw(static_cast<int32_t>(
+                (static_cast<int64_t>(_raw) * (1 << FRACTIONAL_BITS)) / other._raw));
+    }
+
+    L86Fixed &operator+=(L86Fixed other)
+    {
+        _raw += other._raw;
+        return *this;
+    }
+
+    L86Fixed &operator-=(L86Fixed other)
+    {
+        _raw -= other._raw;
+        return *this;
+    }
+
+private:
+    int32_t _raw;
+
+    static int32_t saturate(float value)
+    {
+        if (value != value) {
+            return 0;
+        }
+        if (value > MAX) {
+            value = MAX;
+        } else if (value < -MAX) {
+            value = -MAX;
+        }
+        return static_cast<int32_t>(value * (1 << FRACTIONAL_BITS));
+    }
+
+    static L86Fixed from_raw(int32_t raw)
+    {
+        L86Fixed value;
+        value._raw = raw;
+        return value;
+    }
+};
+
+inline float l86_to_float(float value)
+{
+    return value;
+}
+
+inline float l86_to_float(L86Fixed value)
+{
+    return value.to_float();
+}
+
+/*!
+ *  Constant-velocity Kalman filter along one axis
+ *
+ *  The state is [position, velocity] with a white acceleration process noise. With independent
+ *  noises on each axis, the 3D constant-velocity filter splits exactly into one such filter per
+ *  axis, so only 2x2 matrices are needed, with no dynamic allocation.
+ *
+ *  \tparam T scalar type, float or L86Fixed
+ */
+template <typename T> class L86KalmanAxis {
+
+public:
+    /*!
+     *  Reset the filter state
+     *
+     *  \param position initial position, in m
+     *  \param position_variance initial position variance, in m^2
+     *  \param velocity initial velocity, in m/s
+     *  \param velocity_variance initial velocity variance, in m^2/s^2
+     */
+    void reset(T position, T position_variance, T velocity, T velocity_variance)
+    {
+        _position = position;
+        _velocity = velocity;
+        _p00 = position_variance;
+        _p01 = T(0.0f);
+        _p11 = velocity_variance;
+    }
+
+    /*!
+     *  Propagate the state
+     *
+     *  \param dt elapsed time, in s
+     *  \param q process noise spectral density, in m^2/s^3
+     */
+    void predict(T dt, T q)
+    {
+        T q_dt = q * dt;
+        T q_dt2 = q_dt * dt;
+        _position += _velocity * dt;
+        _p00 += dt * (_p01 + _p01 + dt * _p11) + q_dt2 * dt * T(1.0f / 3.0f);
+        _p01 += dt * _p11 + q_dt2 * T(0.5f);
+        _p11 += q_dt;
+    }
+
+    /*!
+     *  Correct the state with a position measurement
+     *
+     *  \param position measured position, in m
+     *  \param variance measurement variance, in m^2
+     */
+    void update_position(T position, T variance)
+    {
+        T innovation_variance = _p00 + variance;
+        T k0 = _p00 / innovation_variance;
+        T k1 = _p01 / innovation_variance;
+        T innovation = position - _position;
+        _position += k0 * innovation;
+        _velocity += k1 * innovation;
+        _p11 -= k1 * _p01;
+        _p00 -= k0 * _p00;
+        _p01 -= k0 * _p01;
+    }
+
+    /*!
+     *  Correct the state with a velocity measurement
+     *
+     *  \param velocity measured velocity, in m/s
+     *  \param variance measurement variance, in m^2/s^2
+     */
+    void update_velocity(T velocity, T variance)
+    {
+        T innovation_variance = _p11 + variance;
+        T k0 = _p01 / innovation_variance;
+        T k1 = _p11 / innovation_variance;
+        T innovation = velocity - _velocity;
+        _position += k0 * innovation;
+        _velocity += k1 * innovation;
+        _p00 -= k0 * _p01;
+        _p01 -= k1 * _p01;
+        _p11 -= k1 * _p11;
+    }
+
+    /*!
+     *  Move the position origin, to keep fixed-point positions in range
+     *
+     *  \param offset origin displacement, in m
+     */
+    void shift(T offset)
+    {
+        _position -= offset;
+    }
+
+    T position() const
+    {
+        return _position;
+    }
+
+    T velocity() const
+    {
+        return _velocity;
+    }
+
+    T position_variance() const
+    {
+        return _p00;
+    }
+
+private:
+    T _position;
+    T _velocity;
+    T _p00;
+    T _p01;
+    T _p11;
+};
+
+#endif /* CATIE_SIXTRON_L86_KALMAN_H_ */
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CATIE_SIXTRON_L86_NMEA_BUFFER_H_
+#define CATIE_SIXTRON_L86_NMEA_BUFFER_H_
+
+#include "mbed.h"
+
+#include "l86.h"
+
+/*!
+ *  Sentence buffer between the driver raw sentence output and a slow consumer
+ *
+ *  Attach it as a sink of a driver, and drain it from the consumer context (a logging thread,
+ *  a USB serial forwarding task...):
+ *  \code
+ *  L86NmeaBuffer<1024> buffer(L86NmeaBuffer<1024>::Policy::DROP_OLDEST);
+ *  l86.attach_nmea_sink(callback(&buffer, &L86NmeaBuffer<1024>::write));
+ *  \endcode
+ *
+ *  The buffer only holds whole sentences. When it is full, the policy chooses between the
+ *  incoming sentence and the oldest buffered ones, so the parsing context never waits for the
+ *  consumer.
+ *
+ *  \tparam N buffer size, in bytes
+ */
+template <size_t N> class L86NmeaBuffer {
+
+public:
+    static_assert(N >= MINMEA_MAX_LENGTH, "buffer must hold at least one sentence");
+
+    /* Full buffer policy */
+    enum class Policy {
+        DROP_NEWEST, //!< Drop the incoming sentence, for an exact record up to the overflow
+        DROP_OLDEST //!< Drop the oldest sentences, for a live output
+    };
+
+    /*!
+     *  L86NmeaBuffer constructor
+     *
+     *  \param policy full buffer policy
+     *  \param notify function called from the parsing context after each buffered sentence,
+     *  to wake up the consumer, may be NULL
+     */
+    L86NmeaBuffer(Policy policy = Policy::DROP_NEWEST, Callback<void()> notify = nullptr):
+            _policy(policy), _notify(notify), _head(0), _count(0), _dropped(0)
+    {
+    }
+
+    /*!
+     *  Buffer a sentence, from the driver parsing context
+     *
+     *  \param sentence sentence, from its '$' to its end of line
+     *  \param length sentence length
+     *
+     *  \return false if the sentence was dropped
+     */
+    bool write(const char *sentence, size_t length)
+    {
+        {
+            CriticalSectionLock lock;
+            if (length > N || (N - _count < length && _policy == Policy::DROP_NEWEST)) {
+                _dropped++;
+                return false;
+            }
+            while (N - _count < length) {
+                drop_oldest();
+                _dropped++;
+            }
+            size_t tail = (_head + _count) % N;
+            size_t first = length < N - tail ? length : N - tail;
+            memcpy(_data + tail, sentence, first);
+            memcpy(_data, sentence + first, length - first);
+            _count += length;
+        }
+        if (_notify) {
+            _notify();
+        }
+        return true;
+    }
+
+    /*!
+     *  Get buffered sentences, from the consumer context
+     *
+     *  \param buffer filled with whole sentences, not null terminated
+     *  \param size buffer size, at least MINMEA_MAX_LENGTH to take any sentence
+     *
+     *  \return number of bytes copied to the buffer
+     */
+    size_t read(char *buffer, size_t size)
+    {
+        CriticalSectionLock lock;
+        size_t length = 0;
+        while (length < _count) {
+            size_t end = sentence_length(length);
+            if (end > size) {
+                break;
+            }
+            length = end;
+        }
+        size_t first = length < N - _head ? length : N - _head;
+        memcpy(buffer, _data + _head, first);
+        memcpy(buffer + first, _data, length - first);
+        _head = (_head + length) % N;
+        _count -= length;
+        return length;
+    }
+
+    bool empty() const
+    {
+        return _count == 0;
+    }
+
+    /*!
+     *  Get the number of sentences dropped on a full buffer
+     */
+    uint32_t dropped() const
+    {
+        return _dropped;
+    }
+
+private:
+    char _data[N];
+    Policy _policy;
+    Callback<void()> _notify;
+    size_t _head; // first byte of the oldest sentence
+    size_t _count;
+    volatile uint32_t _dropped;
+
+    /*!
+     *  Get the end of the sentence starting at an offset from the head
+     *
+     *  \return offset of the next sentence
+     */
+    size_t sentence_length(size_t offset) const
+    {
+        while (offset < _count) {
+            if (_data[(_head + offset++) % N] == '\n') {
+                break;
+            }
+        }
+        return offset;
+    }
+
+    void drop_oldest()
+    {
+        size_t length = sentence_length(0);
+        _head = (_head + length) % N;
+        _count -= length;
+    }
+};
+
+#endif /* CATIE_SIXTRON_L86_NMEA_BUFFER_H_ */
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CATIE_SIXTRON_L86_ODOMETER_H_
+#define CATIE_SIXTRON_L86_ODOMETER_H_
+
+#include "l86.h"
+
+#ifndef MBED_CONF_L86_ODOMETER_MIN_SPEED
+#define MBED_CONF_L86_ODOMETER_MIN_SPEED 1.0f //!< Below this speed, in knots, no distance is added
+#endif
+
+#ifndef MBED_CONF_L86_ODOMETER_MAX_HDOP
+#define MBED_CONF_L86_ODOMETER_MAX_HDOP 5.0f //!< Fixes with a larger HDOP are ignored
+#endif
+
+/*!
+ *  Fixed-point odometer, fed by the driver fix output
+ *
+ *  Distances between accepted fixes use an equirectangular approximation in integer
+ *  microdegrees, with the longitude scaled by the cosine of the mean latitude taken from a
+ *  one-degree Q15 lookup table. Stationary fixes (speed below MBED_CONF_L86_ODOMETER_MIN_SPEED)
+ *  and imprecise fixes (HDOP above MBED_CONF_L86_ODOMETER_MAX_HDOP) are not accumulated, so
+ *  position jitter is not integrated while parked.
+ */
+class L86Odometer {
+
+public:
+    /*!
+     *  Default L86Odometer constructor
+     *
+     *  \param min_speed minimum speed to accumulate distance, in knots
+     *  \param max_hdop maximum HDOP to accept a fix
+     */
+    L86Odometer(float min_speed = MBED_CONF_L86_ODOMETER_MIN_SPEED,
+            float max_hdop = MBED_CONF_L86_ODOMETER_MAX_HDOP);
+
+    /*!
+     *  Accumulate a fix, to be attached to the driver fix output
+     *
+     *  \param fix published fix
+     */
+    void process(const L86::Fix &fix);
+
+    /*!
+     *  Total distance since the odometer creation, in m
+     */
+    uint32_t total_distance();
+
+    /*!
+     *  Distance since the last trip reset, in m
+     */
+    uint32_t trip_distance();
+
+    /*!
+     *  Restart the trip counter
+     */
+    void reset_trip();
+
+    /*!
+     *  Distance between two points, in mm
+     *
+     *  \param latitude_a latitude of the first point, in microdegrees
+     *  \param longitude_a longitude of the first point, in microdegrees
+     *  \param latitude_b latitude of the second point, in microdegrees
+     *  \param longitude_b longitude of the second point, in microdegrees
+     */
+    static uint32_t distance(
+            int32_t latitude_a, int32_t longitude_a, int32_t latitude_b, int32_t longitude_b);
+
+private:
+    float _min_speed;
+    float _max_hdop;
+    bool _anchored;
+    int32_t _anchor_latitude; // last accumulated point, in microdegrees
+    int32_t _anchor_longitude;
+    uint64_t _total; // mm
+    uint64_t _trip; // mm
+};
+
+#endif /* CATIE_SIXTRON_L86_ODOMETER_H_ */
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CATIE_SIXTRON_L86_PARSER_SERVICE_H_
+#define CATIE_SIXTRON_L86_PARSER_SERVICE_H_
+
+#include "mbed.h"
+
+#include "l86.h"
+
+#ifndef MBED_CONF_L86_PARSER_SERVICE_MAX_INSTANCES
+#define MBED_CONF_L86_PARSER_SERVICE_MAX_INSTANCES 4
+#endif
+
+#ifndef MBED_CONF_L86_PARSER_SERVICE_QUANTUM
+#define MBED_CONF_L86_PARSER_SERVICE_QUANTUM 32
+#endif
+
+#ifndef MBED_CONF_L86_PARSER_SERVICE_STACK_SIZE
+#define MBED_CONF_L86_PARSER_SERVICE_STACK_SIZE 2048
+#endif
+
+/*!
+ *  Shared parser worker for several L86 modules
+ *
+ *  Registered drivers only buffer received characters from their serial interrupt, one
+ *  worker thread then drains and parses the receive rings of all of them in a round robin
+ *  manner, at most MBED_CONF_L86_PARSER_SERVICE_QUANTUM characters per module and per round.
+ */
+class L86ParserService {
+
+public:
+    constexpr static int MAX_INSTANCES
+            = MBED_CONF_L86_PARSER_SERVICE_MAX_INSTANCES; //!< Max number of registered modules
+
+    typedef struct {
+        uint32_t bytes_parsed;
+        uint32_t sentences_parsed;
+        uint32_t rx_overflows;
+        uint32_t max_backlog;
+    } InstanceStats;
+
+    /*!
+     *  Default L86ParserService constructor
+     *
+     *  \param priority worker thread priority
+     *  \param stack_size worker thread stack size
+     */
+    L86ParserService(osPriority priority = osPriorityAboveNormal,
+            uint32_t stack_size = MBED_CONF_L86_PARSER_SERVICE_STACK_SIZE);
+
+    /*!
+     *  Start the worker thread
+     *
+     *  \return true on success
+     */
+    bool start();
+
+    /*!
+     *  Defer the parsing of a L86 module to this service
+     *
+     *  \param l86 driver instance
+     *
+     *  \return true on success, false if no slot is available
+     */
+    bool add(L86 *l86);
+
+    /*!
+     *  Give back the parsing of a L86 module to its serial interrupt
+     *
+     *  \param l86 driver instance
+     *
+     *  \return true on success, false if the instance is not registered
+     */
+    bool remove(L86 *l86);
+
+    /*!
+     *  Get parsing statistics of a registered module
+     *
+     *  \param l86 driver instance
+     *
+     *  \return statistics snapshot, zeroed if the instance is not registered
+     */
+    InstanceStats stats(L86 *l86);
+
+    /*!
+     *  Wake up the worker thread, may be called from interrupt context
+     */
+    void notify();
+
+private:
+    constexpr static uint32_t DATA_AVAILABLE_FLAG = 0x01;
+
+    Thread _thread;
+    EventFlags _flags;
+    Mutex _mutex;
+    L86 *_instances[MAX_INSTANCES];
+    InstanceStats _stats[MAX_INSTANCES];
+    int _next_instance;
+
+    int find(L86 *l86);
+
+    /*!
+     *  Drain all registered receive rings, one quantum per module and per round
+     */
+    void drain();
+
+    void run();
+};
+
+#endif /* CATIE_SIXTRON_L86_PARSER_SERVICE_H_ */
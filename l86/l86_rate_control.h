@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CATIE_SIXTRON_L86_RATE_CONTROL_H_
+#define CATIE_SIXTRON_L86_RATE_CONTROL_H_
+
+#include "mbed.h"
+
+#include "l86.h"
+
+#ifndef MBED_CONF_L86_RATE_FAST_INTERVAL
+#define MBED_CONF_L86_RATE_FAST_INTERVAL 100 //!< Fix interval while moving fast, in ms
+#endif
+
+#ifndef MBED_CONF_L86_RATE_NORMAL_INTERVAL
+#define MBED_CONF_L86_RATE_NORMAL_INTERVAL 1000 //!< Fix interval while moving slowly, in ms
+#endif
+
+#ifndef MBED_CONF_L86_RATE_STATIONARY_INTERVAL
+#define MBED_CONF_L86_RATE_STATIONARY_INTERVAL 5000 //!< Fix interval while parked, in ms
+#endif
+
+#ifndef MBED_CONF_L86_RATE_BAUDRATE
+#define MBED_CONF_L86_RATE_BAUDRATE 9600 //!< Default serial link baudrate, in bauds
+#endif
+
+#ifndef MBED_CONF_L86_RATE_FAST_SPEED
+#define MBED_CONF_L86_RATE_FAST_SPEED 10.0f //!< Speed entering the fast rate, in knots
+#endif
+
+#ifndef MBED_CONF_L86_RATE_SLOW_SPEED
+#define MBED_CONF_L86_RATE_SLOW_SPEED 6.0f //!< Speed leaving the fast rate, in knots
+#endif
+
+#ifndef MBED_CONF_L86_RATE_FAST_COURSE_RATE
+#define MBED_CONF_L86_RATE_FAST_COURSE_RATE 10.0f //!< Turn rate entering the fast rate, in deg/s
+#endif
+
+#ifndef MBED_CONF_L86_RATE_SLOW_COURSE_RATE
+#define MBED_CONF_L86_RATE_SLOW_COURSE_RATE 5.0f //!< Turn rate leaving the fast rate, in deg/s
+#endif
+
+#ifndef MBED_CONF_L86_RATE_MOVING_SPEED
+#define MBED_CONF_L86_RATE_MOVING_SPEED 2.0f //!< Speed leaving the parked rate, in knots
+#endif
+
+#ifndef MBED_CONF_L86_RATE_STATIONARY_SPEED
+#define MBED_CONF_L86_RATE_STATIONARY_SPEED 0.5f //!< Speed considered as parked, in knots
+#endif
+
+#ifndef MBED_CONF_L86_RATE_HOLD_TIME
+#define MBED_CONF_L86_RATE_HOLD_TIME 3000 //!< Slow fixes before leaving the fast rate, in ms
+#endif
+
+#ifndef MBED_CONF_L86_RATE_STATIONARY_TIME
+#define MBED_CONF_L86_RATE_STATIONARY_TIME 10000 //!< Parked fixes before the parked rate, in ms
+#endif
+
+#ifndef MBED_CONF_L86_RATE_THROTTLED_FREQUENCY
+#define MBED_CONF_L86_RATE_THROTTLED_FREQUENCY 5 //!< Fixes per throttled GSA/GSV sentence
+#endif
+
+/*!
+ *  Motion-adaptive fix rate and NMEA output, fed by the driver fix output
+ *
+ *  The fix interval follows the observed dynamics:
+ *  - MBED_CONF_L86_RATE_FAST_INTERVAL as soon as the speed or the course change rate exceeds
+ *    its fast threshold, until both stay below their slow threshold for
+ *    MBED_CONF_L86_RATE_HOLD_TIME
+ *  - MBED_CONF_L86_RATE_STATIONARY_INTERVAL once parked for MBED_CONF_L86_RATE_STATIONARY_TIME,
+ *    until the speed exceeds MBED_CONF_L86_RATE_MOVING_SPEED
+ *  - MBED_CONF_L86_RATE_NORMAL_INTERVAL otherwise, or without fix
+ *
+ *  The position sentences keep the configured output. The satellite sentences, which make
+ *  most of the serial traffic, are throttled to MBED_CONF_L86_RATE_THROTTLED_FREQUENCY: GSA and
+ *  GSV at the fast rate, GSV at the parked rate. The fast interval is lengthened to the
+ *  shortest one the serial link carries with the throttled output: MBED_CONF_L86_RATE_FAST_INTERVAL
+ *  needs 38400 bauds or more for RMC and GGA at 10 Hz, a 9600 bauds link gets about 3 Hz.
+ *
+ *  The module is reconfigured with the non-blocking driver commands, directly from the fix
+ *  output context.
+ */
+class L86RateController {
+
+public:
+    enum class Level {
+        STATIONARY,
+        NORMAL,
+        FAST
+    };
+
+    /*!
+     *  Default L86RateController constructor
+     *
+     *  \param l86 driver instance
+     *  \param output sentence output rates at the normal fix rate
+     *  \param baudrate serial link baudrate, bounding the fast rate
+     */
+    L86RateController(L86 *l86,
+            const L86::NmeaOutput &output,
+            int baudrate = MBED_CONF_L86_RATE_BAUDRATE);
+
+    /*!
+     *  Evaluate a fix, to be attached to the driver fix output
+     *
+     *  \param fix published fix
+     */
+    void process(const L86::Fix &fix);
+
+    /*!
+     *  Get the level configured in the module
+     */
+    Level level();
+
+    /*!
+     *  Get the number of level changes configured in the module
+     */
+    uint32_t switches();
+
+    /*!
+     *  Get the fix interval of the fast level, bounded by the link baudrate, in ms
+     */
+    uint16_t fast_interval();
+
+private:
+    L86 *_l86;
+    L86::NmeaOutput _output;
+    uint16_t _fast_interval; // ms
+    Level _level; // configured in the module
+    Level _pending_level; // being configured
+    bool _switching;
+    bool _dirty; // the module may hold a mix of two levels, both settings must be sent
+    L86::CommandFuture _interval_future;
+    L86::CommandFuture _output_future;
+    uint32_t _switches;
+    std::chrono::microseconds _last_fix_time;
+    float _last_course; // deg, NAN if unknown
+    std::chrono::microseconds _slow_since; // first fix below the slow thresholds, 0 if none
+    std::chrono::microseconds _stationary_since; // first parked fix, 0 if none
+
+    /*!
+     *  Compute the level wanted for a fix, with hysteresis on the current level
+     *
+     *  \param fix published fix
+     *  \param course_rate course change rate since the previous fix, in deg/s
+     */
+    Level evaluate(const L86::Fix &fix, float course_rate);
+
+    /*!
+     *  Complete the level change once both commands completed
+     */
+    void update();
+
+    /*!
+     *  Queue the fix interval and output commands of a level
+     */
+    void configure(Level level);
+
+    /*!
+     *  Apply the satellite sentence throttling of a level to an output
+     */
+    static void throttle(Level level, L86::NmeaOutput *output);
+
+    uint16_t interval(Level level);
+};
+
+#endif /* CATIE_SIXTRON_L86_RATE_CONTROL_H_ */
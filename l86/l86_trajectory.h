@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CATIE_SIXTRON_L86_TRAJECTORY_H_
+#define CATIE_SIXTRON_L86_TRAJECTORY_H_
+
+#include "mbed.h"
+
+#include "l86.h"
+
+#ifndef MBED_CONF_L86_TRAJECTORY_MAX_ERROR
+#define MBED_CONF_L86_TRAJECTORY_MAX_ERROR 5.0f //!< Max distance of a dropped fix to the track, in m
+#endif
+
+#ifndef MBED_CONF_L86_TRAJECTORY_MAX_COURSE_CHANGE
+#define MBED_CONF_L86_TRAJECTORY_MAX_COURSE_CHANGE 30.0f //!< Course change keeping a fix, in deg
+#endif
+
+#ifndef MBED_CONF_L86_TRAJECTORY_MAX_SPEED_CHANGE
+#define MBED_CONF_L86_TRAJECTORY_MAX_SPEED_CHANGE 5.0f //!< Speed change keeping a fix, in knots
+#endif
+
+/*!
+ *  Online trajectory simplification, fed by the driver fix output
+ *
+ *  Each fix received after the last kept fix (the anchor) constrains the direction of the next
+ *  kept segment to a cone of half-angle asin(max_error / distance). A fix is kept, and becomes
+ *  the new anchor, when the following fix falls outside the intersection of the cones, gets
+ *  closer to the anchor than a previous fix, or when the course or speed changed too much.
+ *  Every dropped fix is thus within max_error of the simplified track, with O(1) memory and
+ *  work per fix.
+ */
+class L86TrajectoryCompressor {
+
+public:
+    /*!
+     *  Default L86TrajectoryCompressor constructor
+     *
+     *  \param max_error max distance of a dropped fix to the simplified track, in m
+     *  \param max_course_change course change between kept fixes, in degrees
+     *  \param max_speed_change speed change between kept fixes, in knots
+     */
+    L86TrajectoryCompressor(float max_error = MBED_CONF_L86_TRAJECTORY_MAX_ERROR,
+            float max_course_change = MBED_CONF_L86_TRAJECTORY_MAX_COURSE_CHANGE,
+            float max_speed_change = MBED_CONF_L86_TRAJECTORY_MAX_SPEED_CHANGE);
+
+    /*!
+     *  Attach a function called with each kept fix, from the fix output context
+     */
+    void attach(Callback<void(const L86::Fix &)> func);
+
+    /*!
+     *  Simplify a fix, to be attached to the driver fix output
+     *
+     *  \param fix published fix
+     */
+    void process(const L86::Fix &fix);
+
+    /*!
+     *  Keep the last received fix, at the end of a track
+     */
+    void flush();
+
+    /*!
+     *  Number of processed fixes
+     */
+    uint32_t processed_count();
+
+    /*!
+     *  Number of kept fixes
+     */
+    uint32_t kept_count();
+
+private:
+    Callback<void(const L86::Fix &)> _callback;
+    float _max_error;
+    float _max_course_change;
+    float _max_speed_change;
+    bool _anchored;
+    bool _has_candidate;
+    L86::Fix _anchor;
+    L86::Fix _candidate; // farthest fix which can end the current segment
+    float _meters_per_longitude_degree; // at the anchor latitude
+    bool _cone_set;
+    bool _cone_empty;
+    float _lower_x; // cone bounds, as unit vectors in the anchor local frame
+    float _lower_y;
+    float _upper_x;
+    float _upper_y;
+    float _max_distance;
+    uint32_t _processed_count;
+    uint32_t _kept_count;
+
+    void keep(const L86::Fix &fix);
+
+    bool extends_segment(const L86::Fix &fix);
+};
+
+#endif /* CATIE_SIXTRON_L86_TRAJECTORY_H_ */
@@ -37,6 +37,8 @@ extern "C" {
 #define MINMEA_PMTK_MAX_LENGTH 100 //!< Maximal Pmtk packet length
 #define MINMEA_PMTK_PACKET_DATA_MAX_LENGTH 96 //!< Max PMTK packet data length
 #define MINMEA_MAX_LENGTH 120 //!< Maximal nmea packet length
+#define MINMEA_PMTK_RELEASE_MAX_LENGTH 32 //!< Max firmware release string length, with its null
+#define MINMEA_PMTK_NMEA_OUTPUT_COUNT 6 //!< Output rates decoded from PMTK514 (GLL to GSV)
 
 enum minmea_sentence_id {
     MINMEA_INVALID = -1,
@@ -50,20 +52,37 @@ enum minmea_sentence_id {
     MINMEA_SENTENCE_VTG,
     MINMEA_SENTENCE_ZDA,
     // MINMEA_SENTENCE_GPTXT, // Not implemented
-    MINMEA_SENTENCE_PMTK_ACK
+    MINMEA_SENTENCE_PMTK_ACK,
+    MINMEA_SENTENCE_PMTK_EPO_INFO,
+    MINMEA_SENTENCE_PMTK_FIX_CTL,
+    MINMEA_SENTENCE_PMTK_NMEA_OUTPUT,
+    MINMEA_SENTENCE_PMTK_RELEASE,
+    MINMEA_SENTENCE_PMTK_SYSTEM_MESSAGE,
+    MINMEA_SENTENCE_COUNT // Number of sentence identifiers, not a sentence
 };
 
 // MTK NMEA Packet Protocol (extension messages of the NMEA packet protocol)
 enum minmea_pmtk_packet_type {
     MINMEA_PMTK_UNKNOWN = 0,
+    MINMEA_PMTK_SYS_MSG = 10,
     MINMEA_PMTK_CMD_HOT_START = 101,
     MINMEA_PMTK_CMD_WARM_START = 102,
     MINMEA_PMTK_CMD_COLD_START = 103,
     MINMEA_PMTK_CMD_FULL_COLD_START = 104,
     MINMEA_PMTK_API_SET_POS_FIX = 220,
     MINMEA_PMTK_API_SET_PERIODIC_MODE = 225,
+    MINMEA_PMTK_SET_OUTPUT_FORMAT = 253,
     MINMEA_PMTK_API_SET_NMEA_OUTPUT = 314,
     MINMEA_PMTK_API_SET_GNSS_SEARCH_MODE = 353,
+    MINMEA_PMTK_API_Q_FIX_CTL = 400,
+    MINMEA_PMTK_API_Q_NMEA_OUTPUT = 414,
+    MINMEA_PMTK_DT_FIX_CTL = 500,
+    MINMEA_PMTK_DT_NMEA_OUTPUT = 514,
+    MINMEA_PMTK_Q_RELEASE = 605,
+    MINMEA_PMTK_Q_EPO_INFO = 607,
+    MINMEA_PMTK_DT_RELEASE = 705,
+    MINMEA_PMTK_DT_EPO_INFO = 707,
+    MINMEA_PMTK_API_SET_REFERENCE_LOCATION = 741,
     MINMEA_PMTK_FR_MODE = 886,
 };
 
@@ -105,6 +124,43 @@ struct minmea_sentence_pmtk_ack {
     enum minmea_pmtk_flag flag;
 };
 
+struct minmea_sentence_pmtk_epo_info {
+    int sets; // number of EPO sets stored in the module
+    int first_week; // GPS week and time of week of the first set
+    int first_tow;
+    int last_week; // GPS week and time of week of the last set
+    int last_tow;
+    int first_current_week; // GPS week and time of week of the first current set
+    int first_current_tow;
+    int last_current_week; // GPS week and time of week of the last current set
+    int last_current_tow;
+};
+
+enum minmea_pmtk_system_message_type {
+    MINMEA_PMTK_SYSTEM_MESSAGE_UNKNOWN = 0,
+    MINMEA_PMTK_SYSTEM_MESSAGE_STARTUP = 1, // the module restarted with its default settings
+    MINMEA_PMTK_SYSTEM_MESSAGE_EPO_REQUEST = 2, // EPO data should be updated
+    MINMEA_PMTK_SYSTEM_MESSAGE_NORMAL_MODE = 3, // back to normal mode
+};
+
+struct minmea_sentence_pmtk_system_message {
+    enum minmea_pmtk_system_message_type message;
+};
+
+struct minmea_sentence_pmtk_fix_ctl {
+    int fix_interval; // position fix interval, in ms
+};
+
+struct minmea_sentence_pmtk_nmea_output {
+    int frequencies[MINMEA_PMTK_NMEA_OUTPUT_COUNT]; // by frequency parameter index, 0 if disabled
+};
+
+struct minmea_sentence_pmtk_release {
+    char release[MINMEA_PMTK_RELEASE_MAX_LENGTH]; // firmware release string
+    char build_id[MINMEA_PMTK_RELEASE_MAX_LENGTH];
+    char product_model[MINMEA_PMTK_RELEASE_MAX_LENGTH];
+};
+
 struct minmea_sentence_rmc {
     struct minmea_time time;
     bool valid;
@@ -251,6 +307,11 @@ bool minmea_talker_id(char talker[3], const char *sentence);
  */
 enum minmea_sentence_id minmea_sentence_id(const char *sentence, bool strict);
 
+/**
+ * Determine sentence identifier, without checking the sentence integrity.
+ */
+enum minmea_sentence_id minmea_sentence_type(const char *sentence);
+
 /**
  * Scanf-like processor for NMEA sentences. Supports the following formats:
  * c - single character (char *)
@@ -268,6 +329,13 @@ bool minmea_scan(const char *sentence, const char *format, ...);
  * Parse a specific type of sentence. Return true on success.
  */
 bool minmea_parse_pmtk_ack(struct minmea_sentence_pmtk_ack *frame, const char *sentence);
+bool minmea_parse_pmtk_epo_info(struct minmea_sentence_pmtk_epo_info *frame, const char *sentence);
+bool minmea_parse_pmtk_fix_ctl(struct minmea_sentence_pmtk_fix_ctl *frame, const char *sentence);
+bool minmea_parse_pmtk_nmea_output(
+        struct minmea_sentence_pmtk_nmea_output *frame, const char *sentence);
+bool minmea_parse_pmtk_release(struct minmea_sentence_pmtk_release *frame, const char *sentence);
+bool minmea_parse_pmtk_system_message(
+        struct minmea_sentence_pmtk_system_message *frame, const char *sentence);
 bool minmea_parse_rmc(struct minmea_sentence_rmc *frame, const char *sentence);
 bool minmea_parse_gga(struct minmea_sentence_gga *frame, const char *sentence);
 bool minmea_parse_gsa(struct minmea_sentence_gsa *frame, const char *sentence);
@@ -282,6 +350,24 @@ bool minmea_parse_zda(struct minmea_sentence_zda *frame, const char *sentence);
  */
 void minmea_serialize_pmtk(struct minmea_sentence_pmtk pmtk_message, char *message);
 
+/**
+ * Append an integer, zero padded to width digits, to a string.
+ * Returns a pointer to the terminating null character.
+ */
+char *minmea_format_int(char *buffer, long value, int width);
+
+/**
+ * Append a fixed-point number with the given number of decimals (at most 6) to a string.
+ * Returns a pointer to the terminating null character.
+ */
+char *minmea_format_float(char *buffer, float value, int decimals);
+
+/**
+ * Number of days between the UNIX epoch and a proleptic Gregorian calendar date,
+ * for a full year and a month from 1 to 12.
+ */
+long minmea_days_from_civil(long year, unsigned month, unsigned day);
+
 /**
  * Convert GPS UTC date/time representation to a UNIX timestamp.
  */
@@ -4,331 +4,2070 @@
  */
 
 #include "l86.h"
+#include "l86_parser_service.h"
+
+#if MBED_CONF_L86_PERSISTENCE_ENABLED
+#include "kvstore_global_api.h"
+#endif
+
+#if MBED_CONF_L86_STATS_ENABLED && defined(__MBED__)
+#include "hal/us_ticker_api.h"
+#endif
 
 namespace {
-constexpr int LIMIT_SATELLITES = 4; //!< Max number of satellites in a view
+constexpr int LIMIT_SATELLITES = 4; //!< Max number of satellites in a GSV sentence
+constexpr float PPS_DRIFT_GAIN = 0.125f; //!< Drift estimation filter gain
+constexpr float PPS_MAX_DRIFT = 500e-6f; //!< Larger drifts are considered as missed edges
+constexpr time_t PPS_MAX_DRIFT_PERIOD = 60; //!< Max interval between drift measurements, in s
+constexpr int32_t SECONDS_PER_DAY = 86400;
+constexpr float METERS_PER_DEGREE = 111195.0f; //!< Mean length of a latitude degree
+constexpr float METERS_PER_SECOND_PER_KNOT = 0.514444f;
+constexpr float DEGREES_TO_RADIANS = 0.0174532925f;
+
+int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+// PMTK314/PMTK514 frequency parameter index of each NmeaCommandType
+constexpr int NMEA_FREQUENCY_INDEXES[NMEA_COMMANDS_COUNT] = { MINMEA_RMC_FREQUENCY,
+    MINMEA_VTG_FREQUENCY,
+    MINMEA_GGA_FREQUENCY,
+    MINMEA_GSA_FREQUENCY,
+    MINMEA_GSV_FREQUENCY,
+    MINMEA_GLL_FREQUENCY };
+
+constexpr int COMMAND_SLOT_BITS = 5; //!< Low bits of a command handle, holding its slot
+constexpr L86::CommandHandle COMMAND_SLOT_MASK = (1UL << COMMAND_SLOT_BITS) - 1;
+
+// One event flag per command slot, the top flag is reserved by RTX
+static_assert(MBED_CONF_L86_COMMAND_QUEUE_SIZE <= 31, "too many command slots");
+static_assert(MBED_CONF_L86_TX_BUFFER_SIZE >= MINMEA_PMTK_MAX_LENGTH, "transmit ring too small");
+
+/*!
+ *  Proleptic Gregorian calendar date of a number of days since the UNIX epoch
+ *
+ *  \param days days since the UNIX epoch
+ *  \param year filled with the full year
+ *  \param month filled with the month, from 1 to 12
+ *  \param day filled with the day of the month, from 1 to 31
+ */
+void civil_from_days(int32_t days, int32_t *year, uint32_t *month, uint32_t *day)
+{
+    days += 719468;
+    const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const uint32_t day_of_era = static_cast<uint32_t>(days - era * 146097);
+    const uint32_t year_of_era
+            = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    const uint32_t day_of_year
+            = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    const uint32_t shifted_month = (5 * day_of_year + 2) / 153;
+    *day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    *month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    *year = static_cast<int32_t>(year_of_era) + era * 400 + (*month <= 2);
+}
+
+/*!
+ *  Format comma separated integer PMTK parameters, without pulling printf in
+ *
+ *  \param parameters filled with the formatted parameters
+ *  \param values parameter values
+ */
+void format_parameters(char *parameters, std::initializer_list<long> values)
+{
+    char *append = parameters;
+    *append = '\0';
+    for (long value : values) {
+        if (append != parameters) {
+            *append++ = ',';
+        }
+        append = minmea_format_int(append, value, 0);
+    }
+}
+
+#if MBED_CONF_L86_PERSISTENCE_ENABLED
+constexpr uint32_t PERSISTENT_STATE_VERSION = 1;
+#endif
+
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+const char *const LATENCY_STAGE_NAMES[LATENCY_STAGES_COUNT]
+        = { "reception", "parsing", "publication", "total" };
+
+int latency_bucket(uint32_t latency_us)
+{
+    if (latency_us < 2) {
+        return 0;
+    }
+    int bucket = 31 - __builtin_clz(latency_us);
+    return bucket < L86::LATENCY_BUCKETS ? bucket : L86::LATENCY_BUCKETS - 1;
+}
+#endif
+
+#if MBED_CONF_L86_STATS_ENABLED
+void cycle_counter_init()
+{
+#if defined(DWT) && defined(DWT_CTRL_CYCCNTENA_Msk)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+uint32_t cycle_count()
+{
+#if defined(DWT) && defined(DWT_CTRL_CYCCNTENA_Msk)
+    return DWT->CYCCNT;
+#elif defined(__MBED__)
+    // No cycle counter (Cortex-M0/M0+): count microseconds instead
+    return us_ticker_read();
+#else
+    // Host build: count nanoseconds instead
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+#endif
+}
+#endif
+}
+
+#if MBED_CONF_L86_STATS_ENABLED
+#define L86_STATS_INCREMENT(field) (_stats.field++)
+#define L86_STATS_CYCLES_START(start) uint32_t start = cycle_count()
+#define L86_STATS_CYCLES_ADD(field, start) (_stats.field += (uint32_t)(cycle_count() - start))
+#else
+#define L86_STATS_INCREMENT(field)
+#define L86_STATS_CYCLES_START(start)
+#define L86_STATS_CYCLES_ADD(field, start)
+#endif
+
+L86::L86(UnbufferedSerial *uart)
+{
+    _registered_satellite_count = 0;
+    _uart = uart;
+    memset(&_global_informations.time, 0, sizeof(_global_informations.time));
+    _global_informations.positionning_mode = PositionningMode::UNKNOWN;
+    _global_informations.fix_status = FixStatusGGA::UNKNOWN;
+    _global_informations.satellites_used = 0;
+    _utc_days = 0;
+    _utc_seconds_of_day = 0;
+    _utc_time = 0;
+    _utc_microseconds = 0;
+    _fix_available = false;
+    memset(&_fix, 0, sizeof(_fix));
+    _start_mode = StartMode::HOT_START;
+    _start_time = std::chrono::microseconds(0);
+    _ttff_pending = false;
+    for (int i = 0; i < START_MODES_COUNT; i++) {
+        _ttff[i] = std::chrono::milliseconds(0);
+    }
+    memset(&_ttff_report, 0, sizeof(_ttff_report));
+    _fix_lost = false;
+#if MBED_CONF_L86_PERSISTENCE_ENABLED
+    _persistence_queue = nullptr;
+    _state_saved = false;
+    _saved_fix_time = std::chrono::microseconds(0);
+#endif
+#if MBED_CONF_L86_KALMAN_ENABLED
+    _kalman_initialized = false;
+    _kalman_outage = false;
+    _kalman_altitude_pending = false;
+#endif
+    for (int i = 0; i < MBED_CONF_L86_COMMAND_QUEUE_SIZE; i++) {
+        _commands[i].handle = 0;
+        _commands[i].status = CommandStatus::UNKNOWN;
+    }
+    _active_command = -1;
+    _io_suspended = false;
+    _configuration = Configuration();
+    _pending_configuration = Configuration();
+    for (int i = 0; i < CONFIGURATION_FIELDS_COUNT; i++) {
+        _configuration_commands[i] = 0;
+    }
+    _next_command_slot = 0;
+    _command_sequence = 0;
+    _message_len = 0;
+    reset_framing();
+    _parser_service = nullptr;
+    _rx_overflows = 0;
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+    _arrival_times_missing = 0;
+#endif
+#if MBED_CONF_L86_STATS_ENABLED
+    cycle_counter_init();
+#endif
+    reset_stats();
+    reset_latency();
+    _timer.start();
+
+    _pps = nullptr;
+    _pps_edge_pending = false;
+    _pps_paired = false;
+    _sync_utc_time = 0;
+    _clock_drift = 0.0f;
+
+    _position_informations.altitude = 0.0;
+    _position_informations.latitude = 0.0;
+    _position_informations.longitude = 0.0;
+
+    _movement_informations.speed_kmh = 0.0;
+    _movement_informations.speed_knots = 0.0;
+    _movement_informations.course_over_ground = 0.0;
+
+    _dilution_of_precision.positional = NAN;
+    _dilution_of_precision.horizontal = NAN;
+    _dilution_of_precision.vertical = NAN;
+    start_receive();
+}
+
+bool L86::set_satellite_system(SatelliteSystems satellite_systems)
+{
+    return set_satellite_system_async(satellite_systems).get() == MINMEA_PMTK_FLAG_SUCCESS;
+}
+
+L86::CommandFuture L86::set_satellite_system_async(SatelliteSystems satellite_systems)
+{
+    minmea_sentence_pmtk message = { MINMEA_PMTK_API_SET_GNSS_SEARCH_MODE, "", true, false, false };
+    format_parameters(message.parameters,
+            { satellite_systems.test(static_cast<size_t>(SatelliteSystem::GPS)),
+                    satellite_systems.test(static_cast<size_t>(SatelliteSystem::GLONASS)),
+                    satellite_systems.test(static_cast<size_t>(SatelliteSystem::GALILEO)),
+                    satellite_systems.test(static_cast<size_t>(SatelliteSystem::GALILEO_FULL)),
+                    satellite_systems.test(static_cast<size_t>(SatelliteSystem::BEIDOU)) });
+
+    CriticalSectionLock lock;
+    _pending_configuration.satellite_systems = satellite_systems;
+    return send_configuration(message, ConfigurationField::SATELLITE_SYSTEMS);
+}
+
+bool L86::set_nmea_output_frequency(NmeaCommands nmea_commands, NmeaFrequency frequency)
+{
+    return set_nmea_output_frequency_async(nmea_commands, frequency).get()
+            == MINMEA_PMTK_FLAG_SUCCESS;
+}
+
+L86::CommandFuture L86::set_nmea_output_frequency_async(
+        NmeaCommands nmea_commands, NmeaFrequency frequency)
+{
+    NmeaOutput output;
+    for (size_t i = 0; i < NMEA_COMMANDS_COUNT; i++) {
+        output.frequencies[i] = nmea_commands.test(i) ? static_cast<uint8_t>(frequency) : 0;
+    }
+    return set_nmea_output_async(output);
+}
+
+bool L86::set_nmea_output(const NmeaOutput &output)
+{
+    return set_nmea_output_async(output).get() == MINMEA_PMTK_FLAG_SUCCESS;
+}
+
+L86::CommandFuture L86::set_nmea_output_async(const NmeaOutput &output)
+{
+    minmea_sentence_pmtk message = { MINMEA_PMTK_API_SET_NMEA_OUTPUT, "", true, false, false };
+    // GLL, RMC, VTG, GGA, GSA and GSV rates, followed by the unsupported sentences
+    int frequencies[MINMEA_PMTK_NMEA_OUTPUT_COUNT];
+    for (size_t i = 0; i < NMEA_COMMANDS_COUNT; i++) {
+        frequencies[NMEA_FREQUENCY_INDEXES[i]] = output.frequencies[i];
+    }
+    char *append = message.parameters;
+    for (int frequency : frequencies) {
+        append = minmea_format_int(append, frequency, 0);
+        *append++ = ',';
+    }
+    strcpy(append, "0,0,0,0,0,0,0,0,0,0,0,0,0");
+
+    CriticalSectionLock lock;
+    _pending_configuration.nmea_output = output;
+    return send_configuration(message, ConfigurationField::NMEA_OUTPUT);
+}
+
+bool L86::set_navigation_mode(NavigationMode navigation_mode)
+{
+    return set_navigation_mode_async(navigation_mode).get() == MINMEA_PMTK_FLAG_SUCCESS;
+}
+
+L86::CommandFuture L86::set_navigation_mode_async(NavigationMode navigation_mode)
+{
+    minmea_sentence_pmtk message = { MINMEA_PMTK_FR_MODE, "", true, false, false };
+    format_parameters(message.parameters, { static_cast<int>(navigation_mode) });
+
+    CriticalSectionLock lock;
+    _pending_configuration.navigation_mode = navigation_mode;
+    return send_configuration(message, ConfigurationField::NAVIGATION_MODE);
+}
+
+bool L86::set_position_fix_interval(uint16_t interval)
+{
+    return set_position_fix_interval_async(interval).get() == MINMEA_PMTK_FLAG_SUCCESS;
+}
+
+L86::CommandFuture L86::set_position_fix_interval_async(uint16_t interval)
+{
+    minmea_sentence_pmtk message = { MINMEA_PMTK_API_SET_POS_FIX, "", true, false, false };
+    format_parameters(message.parameters, { interval });
+
+    CriticalSectionLock lock;
+    _pending_configuration.fix_interval = interval;
+    return send_configuration(message, ConfigurationField::FIX_INTERVAL);
+}
+
+bool L86::apply(const Configuration &configuration, ConfigurationFields fields)
+{
+    Configuration known;
+    ConfigurationFields known_fields = known_configuration(&known);
+    // Only the unknown or different settings are sent
+    CommandFuture futures[CONFIGURATION_FIELDS_COUNT];
+    ConfigurationFields sent;
+
+    if (fields.test(static_cast<size_t>(ConfigurationField::SATELLITE_SYSTEMS))
+            && (!known_fields.test(static_cast<size_t>(ConfigurationField::SATELLITE_SYSTEMS))
+                    || known.satellite_systems != configuration.satellite_systems)) {
+        futures[static_cast<size_t>(ConfigurationField::SATELLITE_SYSTEMS)]
+                = set_satellite_system_async(configuration.satellite_systems);
+        sent.set(static_cast<size_t>(ConfigurationField::SATELLITE_SYSTEMS));
+    }
+    if (fields.test(static_cast<size_t>(ConfigurationField::NMEA_OUTPUT))
+            && (!known_fields.test(static_cast<size_t>(ConfigurationField::NMEA_OUTPUT))
+                    || memcmp(known.nmea_output.frequencies,
+                               configuration.nmea_output.frequencies,
+                               sizeof(known.nmea_output.frequencies))
+                            != 0)) {
+        futures[static_cast<size_t>(ConfigurationField::NMEA_OUTPUT)]
+                = set_nmea_output_async(configuration.nmea_output);
+        sent.set(static_cast<size_t>(ConfigurationField::NMEA_OUTPUT));
+    }
+    if (fields.test(static_cast<size_t>(ConfigurationField::NAVIGATION_MODE))
+            && (!known_fields.test(static_cast<size_t>(ConfigurationField::NAVIGATION_MODE))
+                    || known.navigation_mode != configuration.navigation_mode)) {
+        futures[static_cast<size_t>(ConfigurationField::NAVIGATION_MODE)]
+                = set_navigation_mode_async(configuration.navigation_mode);
+        sent.set(static_cast<size_t>(ConfigurationField::NAVIGATION_MODE));
+    }
+    if (fields.test(static_cast<size_t>(ConfigurationField::FIX_INTERVAL))
+            && (!known_fields.test(static_cast<size_t>(ConfigurationField::FIX_INTERVAL))
+                    || known.fix_interval != configuration.fix_interval)) {
+        futures[static_cast<size_t>(ConfigurationField::FIX_INTERVAL)]
+                = set_position_fix_interval_async(configuration.fix_interval);
+        sent.set(static_cast<size_t>(ConfigurationField::FIX_INTERVAL));
+    }
+
+    bool success = true;
+    for (size_t i = 0; i < CONFIGURATION_FIELDS_COUNT; i++) {
+        if (sent.test(i) && futures[i].get() != MINMEA_PMTK_FLAG_SUCCESS) {
+            success = false;
+        }
+    }
+    return success;
+}
+
+L86::ConfigurationFields L86::known_configuration(Configuration *configuration)
+{
+    CriticalSectionLock lock;
+    *configuration = _configuration;
+    return _configuration_known;
+}
+
+void L86::invalidate_configuration()
+{
+    CriticalSectionLock lock;
+    _configuration_known.reset();
+}
+
+bool L86::start(StartMode start_mode)
+{
+    return start_async(start_mode).get() == MINMEA_PMTK_FLAG_SUCCESS;
+}
+
+L86::CommandFuture L86::start_async(StartMode start_mode)
+{
+    minmea_sentence_pmtk message = { MINMEA_PMTK_UNKNOWN, "", false, false, false };
+    switch (start_mode) {
+        case StartMode::FULL_COLD_START: {
+            message.type = MINMEA_PMTK_CMD_FULL_COLD_START;
+            break;
+        }
+        case StartMode::COLD_START: {
+            message.type = MINMEA_PMTK_CMD_COLD_START;
+            break;
+        }
+        case StartMode::WARM_START: {
+            message.type = MINMEA_PMTK_CMD_WARM_START;
+            break;
+        }
+        case StartMode::HOT_START: {
+            message.type = MINMEA_PMTK_CMD_HOT_START;
+            break;
+        }
+    }
+
+    {
+        CriticalSectionLock lock;
+        _start_mode = start_mode;
+        _start_time = now();
+        _ttff_pending = true;
+        memset(&_ttff_report, 0, sizeof(_ttff_report));
+        _ttff_report.start_mode = start_mode;
+        _ttff_report.started = true;
+        _fix_lost = false;
+    }
+
+    return CommandFuture(this, send_command(message));
+}
+
+std::chrono::milliseconds L86::time_to_first_fix(StartMode start_mode)
+{
+    CriticalSectionLock lock;
+    return _ttff[static_cast<size_t>(start_mode)];
+}
+
+L86::TtffReport L86::ttff_report()
+{
+    CriticalSectionLock lock;
+    return _ttff_report;
+}
+
+void L86::dump_ttff_report(FILE *stream)
+{
+    static const char *const START_MODE_NAMES[START_MODES_COUNT]
+            = { "full cold start", "cold start", "warm start", "hot start" };
+    TtffReport report = ttff_report();
+    fprintf(stream,
+            "from %s: sentence=%lldms rmc=%lldms 2d=%lldms 3d=%lldms\n",
+            report.started ? START_MODE_NAMES[static_cast<size_t>(report.start_mode)] : "power-up",
+            (long long)report.first_sentence.count(),
+            (long long)report.first_valid_rmc.count(),
+            (long long)report.first_fix_2d.count(),
+            (long long)report.first_fix_3d.count());
+    if (report.reacquisitions != 0) {
+        fprintf(stream,
+                "reacquisition: losses=%lu count=%lu last=%lldms mean=%lldms max=%lldms\n",
+                (unsigned long)report.fix_losses,
+                (unsigned long)report.reacquisitions,
+                (long long)report.last_reacquisition.count(),
+                (long long)(report.total_reacquisition.count() / report.reacquisitions),
+                (long long)report.max_reacquisition.count());
+    } else {
+        fprintf(stream, "reacquisition: losses=%lu\n", (unsigned long)report.fix_losses);
+    }
+}
+
+bool L86::set_reference_location(float latitude, float longitude, float altitude, time_t utc_time)
+{
+    int32_t year;
+    uint32_t month;
+    uint32_t day;
+    int32_t seconds_of_day = static_cast<int32_t>(utc_time % SECONDS_PER_DAY);
+    civil_from_days(static_cast<int32_t>(utc_time / SECONDS_PER_DAY), &year, &month, &day);
+
+    minmea_sentence_pmtk message
+            = { MINMEA_PMTK_API_SET_REFERENCE_LOCATION, "", true, false, false };
+    char *append = minmea_format_float(message.parameters, latitude, 6);
+    *append++ = ',';
+    append = minmea_format_float(append, longitude, 6);
+    *append++ = ',';
+    append = minmea_format_float(append, altitude, 1);
+    const long date_time[] = { year,
+        static_cast<long>(month),
+        static_cast<long>(day),
+        seconds_of_day / 3600,
+        seconds_of_day / 60 % 60,
+        seconds_of_day % 60 };
+    for (size_t i = 0; i < sizeof(date_time) / sizeof(date_time[0]); i++) {
+        *append++ = ',';
+        append = minmea_format_int(append, date_time[i], i == 0 ? 4 : 2);
+    }
+
+    return generate_and_send_pmtk_message(message);
+}
+
+bool L86::save_state()
+{
+#if MBED_CONF_L86_PERSISTENCE_ENABLED
+    Fix fix = this->fix();
+    if (!_fix_available || fix.fix_status == FixStatusGGA::INVALID || fix.time.count() <= 0) {
+        return false;
+    }
+
+    PersistentState state;
+    state.version = PERSISTENT_STATE_VERSION;
+    state.latitude = fix.latitude;
+    state.longitude = fix.longitude;
+    state.altitude = isnan(fix.altitude) ? 0.0f : fix.altitude;
+    state.utc_time = fix.time.count() / 1000000LL;
+    return kv_set(MBED_CONF_L86_PERSISTENCE_KEY, &state, sizeof(state), 0) == MBED_SUCCESS;
+#else
+    return false;
+#endif
+}
+
+L86::RestoreResult L86::restore_state(time_t utc_time)
+{
+#if MBED_CONF_L86_PERSISTENCE_ENABLED
+    PersistentState state;
+    size_t actual_size = 0;
+    if (kv_get(MBED_CONF_L86_PERSISTENCE_KEY, &state, sizeof(state), &actual_size) != MBED_SUCCESS
+            || actual_size != sizeof(state) || state.version != PERSISTENT_STATE_VERSION) {
+        return RestoreResult::NO_STATE;
+    }
+
+    if (utc_time == 0) {
+        utc_time = ::time(nullptr);
+    }
+    // An unset RTC reads -1, or counts from 0 since the power cycle: behind the saved fix
+    int64_t age = static_cast<int64_t>(utc_time) - state.utc_time;
+    if (utc_time <= 0 || age < 0) {
+        return RestoreResult::UNKNOWN_TIME;
+    }
+    if (age > MBED_CONF_L86_PERSISTENCE_MAX_AGE) {
+        return RestoreResult::TOO_OLD;
+    }
+
+    return set_reference_location(state.latitude, state.longitude, state.altitude, utc_time)
+            ? RestoreResult::RESTORED
+            : RestoreResult::FAILED;
+#else
+    (void)utc_time;
+    return RestoreResult::NO_STATE;
+#endif
+}
+
+void L86::enable_persistence(EventQueue *queue)
+{
+#if MBED_CONF_L86_PERSISTENCE_ENABLED
+    CriticalSectionLock lock;
+    _persistence_queue = queue;
+#else
+    (void)queue;
+#endif
+}
+
+bool L86::standby_mode(StandbyMode standby_mode)
+{
+    return standby_mode_async(standby_mode).get() == MINMEA_PMTK_FLAG_SUCCESS;
+}
+
+L86::CommandFuture L86::standby_mode_async(StandbyMode standby_mode)
+{
+    minmea_sentence_pmtk message = { MINMEA_PMTK_API_SET_PERIODIC_MODE, "", true, false, false };
+    format_parameters(message.parameters, { static_cast<int>(standby_mode) });
+
+    return CommandFuture(this, send_command(message));
+}
+
+bool L86::standby_mode(StandbyMode standby_mode, const PeriodicParameters &parameters)
+{
+    return standby_mode_async(standby_mode, parameters).get() == MINMEA_PMTK_FLAG_SUCCESS;
+}
+
+L86::CommandFuture L86::standby_mode_async(
+        StandbyMode standby_mode, const PeriodicParameters &parameters)
+{
+    minmea_sentence_pmtk message = { MINMEA_PMTK_API_SET_PERIODIC_MODE, "", true, false, false };
+    format_parameters(message.parameters,
+            { static_cast<int>(standby_mode),
+                    static_cast<long>(parameters.run_time),
+                    static_cast<long>(parameters.sleep_time),
+                    static_cast<long>(parameters.second_run_time),
+                    static_cast<long>(parameters.second_sleep_time) });
+
+    return CommandFuture(this, send_command(message));
+}
+
+bool L86::epo_info(EpoInfo *info)
+{
+    return epo_info_async(info).get() == MINMEA_PMTK_FLAG_SUCCESS;
+}
+
+L86::CommandFuture L86::epo_info_async(EpoInfo *info)
+{
+    return CommandFuture(
+            this, send_query(MINMEA_PMTK_Q_EPO_INFO, MINMEA_SENTENCE_PMTK_EPO_INFO, info));
+}
+
+bool L86::firmware_release(FirmwareRelease *release)
+{
+    return firmware_release_async(release).get() == MINMEA_PMTK_FLAG_SUCCESS;
+}
+
+L86::CommandFuture L86::firmware_release_async(FirmwareRelease *release)
+{
+    return CommandFuture(
+            this, send_query(MINMEA_PMTK_Q_RELEASE, MINMEA_SENTENCE_PMTK_RELEASE, release));
+}
+
+bool L86::nmea_output(NmeaOutput *output)
+{
+    return nmea_output_async(output).get() == MINMEA_PMTK_FLAG_SUCCESS;
+}
+
+L86::CommandFuture L86::nmea_output_async(NmeaOutput *output)
+{
+    return CommandFuture(this,
+            send_query(MINMEA_PMTK_API_Q_NMEA_OUTPUT, MINMEA_SENTENCE_PMTK_NMEA_OUTPUT, output));
+}
+
+bool L86::position_fix_interval(uint16_t *interval)
+{
+    return position_fix_interval_async(interval).get() == MINMEA_PMTK_FLAG_SUCCESS;
+}
+
+L86::CommandFuture L86::position_fix_interval_async(uint16_t *interval)
+{
+    return CommandFuture(
+            this, send_query(MINMEA_PMTK_API_Q_FIX_CTL, MINMEA_SENTENCE_PMTK_FIX_CTL, interval));
+}
+
+L86::Satellite *L86::satellites()
+{
+    return _satellites_informations.satellites;
+}
+
+float L86::latitude()
+{
+    return _position_informations.latitude;
+}
+
+float L86::longitude()
+{
+    return _position_informations.longitude;
+}
+
+double L86::altitude()
+{
+    return _position_informations.altitude;
+}
+
+float L86::smoothed_latitude()
+{
+#if MBED_CONF_L86_KALMAN_ENABLED
+    if (_kalman_initialized) {
+        CriticalSectionLock lock;
+        return _kalman_origin_latitude
+                + l86_to_float(_kalman_north.position()) / METERS_PER_DEGREE;
+    }
+#endif
+    return _position_informations.latitude;
+}
+
+float L86::smoothed_longitude()
+{
+#if MBED_CONF_L86_KALMAN_ENABLED
+    if (_kalman_initialized) {
+        CriticalSectionLock lock;
+        return _kalman_origin_longitude
+                + l86_to_float(_kalman_east.position()) / _kalman_meters_per_longitude_degree;
+    }
+#endif
+    return _position_informations.longitude;
+}
+
+double L86::smoothed_altitude()
+{
+#if MBED_CONF_L86_KALMAN_ENABLED
+    if (_kalman_initialized) {
+        CriticalSectionLock lock;
+        return l86_to_float(_kalman_vertical.position());
+    }
+#endif
+    return _position_informations.altitude;
+}
+
+L86::PositionCovariance L86::smoothed_covariance()
+{
+    PositionCovariance covariance = { 0.0f, 0.0f, 0.0f };
+#if MBED_CONF_L86_KALMAN_ENABLED
+    if (_kalman_initialized) {
+        CriticalSectionLock lock;
+        covariance.north = l86_to_float(_kalman_north.position_variance());
+        covariance.east = l86_to_float(_kalman_east.position_variance());
+        covariance.vertical = l86_to_float(_kalman_vertical.position_variance());
+    }
+#endif
+    return covariance;
+}
+
+double L86::speed(L86::SpeedUnit unit)
+{
+    if (unit == SpeedUnit::KMH) {
+        return _movement_informations.speed_kmh;
+    } else {
+        return _movement_informations.speed_knots;
+    }
+}
+
+double L86::speed()
+{
+    if (MBED_CONF_L86_SPEED_UNIT == SpeedUnit::KMH) {
+        return _movement_informations.speed_kmh;
+    } else {
+        return _movement_informations.speed_knots;
+    }
+}
+
+time_t L86::time()
+{
+    return _utc_time;
+}
+
+L86::PositionningMode L86::positionning_mode()
+{
+    return _global_informations.positionning_mode;
+}
+
+L86::FixStatusGGA L86::fix_status()
+{
+    return _global_informations.fix_status;
+}
+
+L86::FixStatusGSA L86::fix_satellite_status()
+{
+    return _satellites_informations.status;
+}
+
+int L86::satellite_count()
+{
+    return _satellites_informations.satellite_count;
+}
+
+L86::Mode L86::mode()
+{
+    return _satellites_informations.mode;
+}
+
+L86::DilutionOfPrecision L86::dilution_of_precision()
+{
+    return _dilution_of_precision;
+}
+
+int L86::registered_satellite_count()
+{
+    return _registered_satellite_count;
+}
+
+L86::Stats L86::stats()
+{
+#if MBED_CONF_L86_STATS_ENABLED
+    CriticalSectionLock lock;
+    return _stats;
+#else
+    Stats stats;
+    memset(&stats, 0, sizeof(stats));
+    return stats;
+#endif
+}
+
+void L86::reset_stats()
+{
+#if MBED_CONF_L86_STATS_ENABLED
+    CriticalSectionLock lock;
+    memset(&_stats, 0, sizeof(_stats));
+#endif
+}
+
+std::chrono::microseconds L86::now()
+{
+    return _timer.elapsed_time();
+}
+
+L86::LatencyHistogram L86::latency(LatencyStage stage)
+{
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+    CriticalSectionLock lock;
+    return _latency[static_cast<size_t>(stage)];
+#else
+    (void)stage;
+    LatencyHistogram histogram;
+    memset(&histogram, 0, sizeof(histogram));
+    return histogram;
+#endif
+}
+
+void L86::reset_latency()
+{
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+    CriticalSectionLock lock;
+    memset(_latency, 0, sizeof(_latency));
+    for (int i = 0; i < LATENCY_STAGES_COUNT; i++) {
+        _latency[i].min_us = UINT32_MAX;
+    }
+#endif
+}
+
+void L86::dump_latency(FILE *stream)
+{
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+    for (int i = 0; i < LATENCY_STAGES_COUNT; i++) {
+        LatencyHistogram histogram = latency(static_cast<LatencyStage>(i));
+        if (histogram.count == 0) {
+            fprintf(stream, "%s: no sample\n", LATENCY_STAGE_NAMES[i]);
+            continue;
+        }
+        fprintf(stream,
+                "%s: count=%lu min=%luus mean=%luus max=%luus\n",
+                LATENCY_STAGE_NAMES[i],
+                (unsigned long)histogram.count,
+                (unsigned long)histogram.min_us,
+                (unsigned long)(histogram.total_us / histogram.count),
+                (unsigned long)histogram.max_us);
+        for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+            if (histogram.buckets[bucket] != 0) {
+                fprintf(stream,
+                        "  [%lu, %lu[ us: %lu\n",
+                        bucket == 0 ? 0UL : 1UL << bucket,
+                        1UL << (bucket + 1),
+                        (unsigned long)histogram.buckets[bucket]);
+            }
+        }
+    }
+#else
+    fprintf(stream, "latency tracing disabled\n");
+#endif
+}
+
+bool L86::generate_and_send_pmtk_message(minmea_sentence_pmtk message)
+{
+    CommandHandle handle = send_command(message);
+    if (handle == 0) {
+        return false;
+    }
+    return wait_command(handle) == CommandStatus::SUCCEEDED;
+}
+
+L86::CommandHandle L86::send_command(
+        const minmea_sentence_pmtk &message, Callback<void(CommandStatus)> done)
+{
+    char sentence[MINMEA_PMTK_MAX_LENGTH];
+    minmea_serialize_pmtk(message, sentence);
+
+    CriticalSectionLock lock;
+    // Slots are reused in turn, so that the recent results stay available
+    int slot = -1;
+    for (int i = 0; i < MBED_CONF_L86_COMMAND_QUEUE_SIZE; i++) {
+        int candidate = (_next_command_slot + i) % MBED_CONF_L86_COMMAND_QUEUE_SIZE;
+        if (_commands[candidate].status != CommandStatus::QUEUED
+                && _commands[candidate].status != CommandStatus::PENDING) {
+            slot = candidate;
+            break;
+        }
+    }
+    if (slot < 0) {
+        return 0;
+    }
+    _next_command_slot = (slot + 1) % MBED_CONF_L86_COMMAND_QUEUE_SIZE;
+
+    Command &command = _commands[slot];
+    do {
+        _command_sequence++;
+        command.handle = (_command_sequence << COMMAND_SLOT_BITS) | slot;
+    } while (command.handle == 0);
+    command.status = CommandStatus::QUEUED;
+    command.type = message.type;
+    command.ack_expected = message.ack_expected;
+    command.attempts = 0;
+    strcpy(command.sentence, sentence);
+    command.done = done;
+    command.reply = MINMEA_UNKNOWN;
+    command.reply_data = nullptr;
+    _command_flags.clear(1UL << slot);
+
+    _command_queue.push(slot);
+    if (_active_command < 0 && !_io_suspended) {
+        start_next_command();
+    }
+    return command.handle;
+}
+
+L86::CommandHandle L86::send_query(
+        enum minmea_pmtk_packet_type type, enum minmea_sentence_id reply, void *data)
+{
+    minmea_sentence_pmtk message = { type, "", true, false, false };
+
+    // Nested lock: the query must not be completed by an acknowledge before its reply is set
+    CriticalSectionLock lock;
+    CommandHandle handle = send_command(message);
+    if (handle != 0) {
+        Command &command = _commands[handle & COMMAND_SLOT_MASK];
+        command.reply = reply;
+        command.reply_data = data;
+    }
+    return handle;
+}
+
+L86::CommandStatus L86::command_status(CommandHandle handle)
+{
+    CriticalSectionLock lock;
+    CommandHandle slot = handle & COMMAND_SLOT_MASK;
+    if (handle == 0 || slot >= MBED_CONF_L86_COMMAND_QUEUE_SIZE
+            || _commands[slot].handle != handle) {
+        return CommandStatus::UNKNOWN;
+    }
+    return _commands[slot].status;
+}
+
+L86::CommandStatus L86::wait_command(CommandHandle handle)
+{
+    CommandHandle slot = handle & COMMAND_SLOT_MASK;
+    CommandStatus status = command_status(handle);
+    while (status == CommandStatus::QUEUED || status == CommandStatus::PENDING) {
+        // The flag is kept set for other waiters, it is cleared when the slot is reused
+        _command_flags.wait_any(1UL << slot, osWaitForever, false);
+        status = command_status(handle);
+    }
+    return status;
+}
+
+bool L86::attach_command_callback(CommandHandle handle, Callback<void(CommandStatus)> done)
+{
+    CriticalSectionLock lock;
+    CommandHandle slot = handle & COMMAND_SLOT_MASK;
+    if (handle == 0 || slot >= MBED_CONF_L86_COMMAND_QUEUE_SIZE
+            || _commands[slot].handle != handle
+            || (_commands[slot].status != CommandStatus::QUEUED
+                    && _commands[slot].status != CommandStatus::PENDING)) {
+        return false;
+    }
+    _commands[slot].done = done;
+    return true;
+}
+
+enum minmea_pmtk_flag L86::command_flag(CommandStatus status)
+{
+    switch (status) {
+        case CommandStatus::SUCCEEDED:
+            return MINMEA_PMTK_FLAG_SUCCESS;
+        case CommandStatus::FAILED:
+            return MINMEA_PMTK_FLAG_FAILURE;
+        case CommandStatus::UNSUPPORTED:
+            return MINMEA_PMTK_FLAG_UNSUPPORTED;
+        default:
+            return MINMEA_PMTK_FLAG_INVALID;
+    }
+}
+
+L86::CommandFuture::CommandFuture(): _l86(nullptr), _handle(0)
+{
+}
+
+L86::CommandFuture::CommandFuture(L86 *l86, CommandHandle handle): _l86(l86), _handle(handle)
+{
+}
+
+bool L86::CommandFuture::valid() const
+{
+    return _l86 != nullptr && _handle != 0;
+}
+
+bool L86::CommandFuture::ready() const
+{
+    CommandStatus command_status = status();
+    return command_status != CommandStatus::QUEUED && command_status != CommandStatus::PENDING;
+}
+
+L86::CommandStatus L86::CommandFuture::status() const
+{
+    return valid() ? _l86->command_status(_handle) : CommandStatus::UNKNOWN;
+}
+
+enum minmea_pmtk_flag L86::CommandFuture::get()
+{
+    return valid() ? command_flag(_l86->wait_command(_handle)) : MINMEA_PMTK_FLAG_INVALID;
+}
+
+bool L86::CommandFuture::then(Callback<void(CommandStatus)> done)
+{
+    return valid() && _l86->attach_command_callback(_handle, done);
+}
+
+void L86::start_next_command()
+{
+    uint8_t slot;
+    if (_io_suspended || !_command_queue.pop(slot)) {
+        _active_command = -1;
+        return;
+    }
+    _active_command = slot;
+    _commands[slot].status = CommandStatus::PENDING;
+    transmit_command();
+}
+
+void L86::transmit_command()
+{
+    Command &command = _commands[_active_command];
+    command.attempts++;
+    for (const char *c = command.sentence; *c != '\0'; c++) {
+        _tx_buffer.push(*c);
+    }
+    _uart->attach(callback(this, &L86::transmit_buffered_characters), SerialBase::TxIrq);
+    if (command.ack_expected) {
+        _command_timeout.attach(callback(this, &L86::command_timeout),
+                std::chrono::milliseconds(MBED_CONF_L86_PMTK_ACK_TIMEOUT));
+    }
+}
+
+void L86::transmit_buffered_characters()
+{
+    char c;
+    while (_uart->writable() && _tx_buffer.pop(c)) {
+        _uart->write(&c, 1);
+    }
+
+    Callback<void(CommandStatus)> done;
+    {
+        CriticalSectionLock lock;
+        if (!_tx_buffer.empty()) {
+            return;
+        }
+        _uart->attach(nullptr, SerialBase::TxIrq);
+        // Commands without acknowledge complete once sent
+        if (_active_command < 0 || _commands[_active_command].ack_expected) {
+            return;
+        }
+        complete_command(CommandStatus::SUCCEEDED, &done);
+    }
+    if (done) {
+        done(CommandStatus::SUCCEEDED);
+    }
+}
+
+void L86::command_timeout()
+{
+    Callback<void(CommandStatus)> done;
+    {
+        CriticalSectionLock lock;
+        if (_active_command < 0) {
+            return;
+        }
+        if (_commands[_active_command].attempts < MBED_CONF_L86_PMTK_MAX_ATTEMPTS) {
+            L86_STATS_INCREMENT(pmtk_retries);
+            transmit_command();
+            return;
+        }
+        L86_STATS_INCREMENT(pmtk_timeouts);
+        complete_command(CommandStatus::TIMEOUT, &done);
+    }
+    if (done) {
+        done(CommandStatus::TIMEOUT);
+    }
+}
+
+void L86::acknowledge_command(int type, int flag)
+{
+    CommandStatus status;
+    switch (flag) {
+        case MINMEA_PMTK_FLAG_SUCCESS:
+            status = CommandStatus::SUCCEEDED;
+            break;
+        case MINMEA_PMTK_FLAG_FAILURE:
+            status = CommandStatus::FAILED;
+            break;
+        case MINMEA_PMTK_FLAG_UNSUPPORTED:
+            status = CommandStatus::UNSUPPORTED;
+            break;
+        default:
+            status = CommandStatus::INVALID;
+            break;
+    }
+
+    Callback<void(CommandStatus)> done;
+    {
+        CriticalSectionLock lock;
+        // Late acknowledges of timed out commands are ignored
+        if (_active_command < 0 || !_commands[_active_command].ack_expected
+                || _commands[_active_command].type != type) {
+            return;
+        }
+        // A query is only completed by its reply, unless the module rejects it
+        if (_commands[_active_command].reply != MINMEA_UNKNOWN
+                && status == CommandStatus::SUCCEEDED) {
+            return;
+        }
+        complete_command(status, &done);
+    }
+    if (done) {
+        done(status);
+    }
+}
+
+void L86::answer_query(enum minmea_sentence_id reply)
+{
+    Callback<void(CommandStatus)> done;
+    {
+        CriticalSectionLock lock;
+        // Unsolicited replies and replies to timed out queries are ignored
+        if (_active_command < 0 || _commands[_active_command].reply != reply) {
+            return;
+        }
+        void *data = _commands[_active_command].reply_data;
+        switch (reply) {
+            case MINMEA_SENTENCE_PMTK_EPO_INFO: {
+                EpoInfo *info = static_cast<EpoInfo *>(data);
+                info->sets = _frame.pmtk_epo_info.sets;
+                info->first_week = _frame.pmtk_epo_info.first_week;
+                info->first_tow = _frame.pmtk_epo_info.first_tow;
+                info->last_week = _frame.pmtk_epo_info.last_week;
+                info->last_tow = _frame.pmtk_epo_info.last_tow;
+                break;
+            }
+            case MINMEA_SENTENCE_PMTK_FIX_CTL:
+                *static_cast<uint16_t *>(data)
+                        = static_cast<uint16_t>(_frame.pmtk_fix_ctl.fix_interval);
+                if (_configuration_commands[static_cast<size_t>(ConfigurationField::FIX_INTERVAL)]
+                        == 0) {
+                    _configuration.fix_interval = *static_cast<uint16_t *>(data);
+                    _configuration_known.set(static_cast<size_t>(ConfigurationField::FIX_INTERVAL));
+                }
+                break;
+            case MINMEA_SENTENCE_PMTK_NMEA_OUTPUT: {
+                NmeaOutput *output = static_cast<NmeaOutput *>(data);
+                for (size_t i = 0; i < NMEA_COMMANDS_COUNT; i++) {
+                    output->frequencies[i]
+                            = _frame.pmtk_nmea_output.frequencies[NMEA_FREQUENCY_INDEXES[i]];
+                }
+                if (_configuration_commands[static_cast<size_t>(ConfigurationField::NMEA_OUTPUT)]
+                        == 0) {
+                    _configuration.nmea_output = *output;
+                    _configuration_known.set(static_cast<size_t>(ConfigurationField::NMEA_OUTPUT));
+                }
+                break;
+            }
+            case MINMEA_SENTENCE_PMTK_RELEASE: {
+                FirmwareRelease *release = static_cast<FirmwareRelease *>(data);
+                strcpy(release->release, _frame.pmtk_release.release);
+                strcpy(release->build_id, _frame.pmtk_release.build_id);
+                strcpy(release->product_model, _frame.pmtk_release.product_model);
+                break;
+            }
+            default:
+                break;
+        }
+        complete_command(CommandStatus::SUCCEEDED, &done);
+    }
+    if (done) {
+        done(CommandStatus::SUCCEEDED);
+    }
 }
 
-L86::L86(UnbufferedSerial *uart)
+void L86::complete_command(CommandStatus status, Callback<void(CommandStatus)> *done)
 {
-    _registered_satellite_count = 0;
-    _uart = uart;
-
-    _position_informations.altitude = 0.0;
-    _position_informations.latitude = 0.0;
-    _position_informations.longitude = 0.0;
-
-    _movement_informations.speed_kmh = 0.0;
-    _movement_informations.speed_knots = 0.0;
-    start_receive();
+    Command &command = _commands[_active_command];
+    _command_timeout.detach();
+    command.status = status;
+    update_configuration(command, status);
+    *done = command.done;
+    command.done = nullptr;
+    _command_flags.set(1UL << _active_command);
+    start_next_command();
 }
 
-bool L86::set_satellite_system(SatelliteSystems satellite_systems)
+L86::CommandFuture L86::send_configuration(
+        const minmea_sentence_pmtk &message, ConfigurationField field)
 {
-    minmea_sentence_pmtk message = { MINMEA_PMTK_API_SET_GNSS_SEARCH_MODE, 0, true, false, false };
-    sprintf(message.parameters,
-            "%i,%i,%i,%i,%i",
-            satellite_systems.test(static_cast<size_t>(SatelliteSystem::GPS)),
-            satellite_systems.test(static_cast<size_t>(SatelliteSystem::GLONASS)),
-            satellite_systems.test(static_cast<size_t>(SatelliteSystem::GALILEO)),
-            satellite_systems.test(static_cast<size_t>(SatelliteSystem::GALILEO_FULL)),
-            satellite_systems.test(static_cast<size_t>(SatelliteSystem::BEIDOU)));
-
-    return generate_and_send_pmtk_message(message);
+    CriticalSectionLock lock;
+    CommandHandle handle = send_command(message);
+    // Unknown until acknowledged, a previous command of the field no longer updates it
+    _configuration_known.reset(static_cast<size_t>(field));
+    _configuration_commands[static_cast<size_t>(field)] = handle;
+    return CommandFuture(this, handle);
 }
 
-bool L86::set_nmea_output_frequency(NmeaCommands nmea_commands, NmeaFrequency frequency)
+void L86::update_configuration(const Command &command, CommandStatus status)
 {
-    minmea_sentence_pmtk message = { MINMEA_PMTK_API_SET_NMEA_OUTPUT, 0, true, false, false };
-    sprintf(message.parameters,
-            "%i,%i,%i,%i,%i,%i,0,0,0,0,0,0,0,0,0,0,0,0,0",
-            nmea_commands.test(static_cast<size_t>(NmeaCommandType::GLL))
-                    ? static_cast<int>(frequency)
-                    : 0,
-            nmea_commands.test(static_cast<size_t>(NmeaCommandType::RMC))
-                    ? static_cast<int>(frequency)
-                    : 0,
-            nmea_commands.test(static_cast<size_t>(NmeaCommandType::VTG))
-                    ? static_cast<int>(frequency)
-                    : 0,
-            nmea_commands.test(static_cast<size_t>(NmeaCommandType::GGA))
-                    ? static_cast<int>(frequency)
-                    : 0,
-            nmea_commands.test(static_cast<size_t>(NmeaCommandType::GSA))
-                    ? static_cast<int>(frequency)
-                    : 0,
-            nmea_commands.test(static_cast<size_t>(NmeaCommandType::GSV))
-                    ? static_cast<int>(frequency)
-                    : 0);
+    for (size_t i = 0; i < CONFIGURATION_FIELDS_COUNT; i++) {
+        if (_configuration_commands[i] != command.handle) {
+            continue;
+        }
+        _configuration_commands[i] = 0;
+        // A failed or timed out setting may have been applied or not
+        if (status != CommandStatus::SUCCEEDED) {
+            return;
+        }
+        switch (static_cast<ConfigurationField>(i)) {
+            case ConfigurationField::SATELLITE_SYSTEMS:
+                _configuration.satellite_systems = _pending_configuration.satellite_systems;
+                break;
+            case ConfigurationField::NMEA_OUTPUT:
+                _configuration.nmea_output = _pending_configuration.nmea_output;
+                break;
+            case ConfigurationField::NAVIGATION_MODE:
+                _configuration.navigation_mode = _pending_configuration.navigation_mode;
+                break;
+            case ConfigurationField::FIX_INTERVAL:
+                _configuration.fix_interval = _pending_configuration.fix_interval;
+                break;
+        }
+        _configuration_known.set(i);
+        return;
+    }
 
-    return generate_and_send_pmtk_message(message);
+    // Settings sent with send_command() are not tracked
+    if (status == CommandStatus::SUCCEEDED || status == CommandStatus::TIMEOUT) {
+        switch (command.type) {
+            case MINMEA_PMTK_API_SET_GNSS_SEARCH_MODE:
+                _configuration_known.reset(
+                        static_cast<size_t>(ConfigurationField::SATELLITE_SYSTEMS));
+                break;
+            case MINMEA_PMTK_API_SET_NMEA_OUTPUT:
+                _configuration_known.reset(static_cast<size_t>(ConfigurationField::NMEA_OUTPUT));
+                break;
+            case MINMEA_PMTK_FR_MODE:
+                _configuration_known.reset(
+                        static_cast<size_t>(ConfigurationField::NAVIGATION_MODE));
+                break;
+            case MINMEA_PMTK_API_SET_POS_FIX:
+                _configuration_known.reset(static_cast<size_t>(ConfigurationField::FIX_INTERVAL));
+                break;
+            default:
+                break;
+        }
+    }
 }
 
-bool L86::set_navigation_mode(NavigationMode navigation_mode)
+void L86::get_received_message()
 {
-    minmea_sentence_pmtk message = { MINMEA_PMTK_FR_MODE, 0, true, false, false };
-    sprintf(message.parameters, "%i", static_cast<int>(navigation_mode));
-
-    return generate_and_send_pmtk_message(message);
+    L86_STATS_CYCLES_START(start);
+    char c;
+    while (_uart->readable()) {
+        _uart->read(&c, 1);
+        receive_character(c);
+    }
+    L86_STATS_CYCLES_ADD(receive_cycles, start);
 }
 
-bool L86::set_position_fix_interval(uint16_t interval)
+void L86::buffer_received_message()
 {
-    minmea_sentence_pmtk message = { MINMEA_PMTK_API_SET_POS_FIX, 0, true, false, false };
-    sprintf(message.parameters, "%u", interval);
+    char c;
+    while (_uart->readable()) {
+        _uart->read(&c, 1);
+        if (_rx_buffer.full()) {
+            // Keep what is already queued, the framing will drop the broken sentence
+            _rx_overflows++;
+            continue;
+        }
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+        // Once a time is missing, later times wait until it is consumed to keep the order
+        if (c == '$' || c == '\n') {
+            if (_arrival_times_missing > 0 || _arrival_times.full()) {
+                _arrival_times_missing++;
+            } else {
+                _arrival_times.push(static_cast<uint32_t>(now().count()));
+            }
+        }
+#endif
+        _rx_buffer.push(c);
+    }
+    _parser_service->notify();
+}
 
-    return generate_and_send_pmtk_message(message);
+size_t L86::process_received_bytes(size_t max_bytes, uint32_t *sentences)
+{
+    L86_STATS_CYCLES_START(start);
+    size_t count = 0;
+    char c;
+    while (count < max_bytes && _rx_buffer.pop(c)) {
+        count++;
+        if (receive_character(c)) {
+            (*sentences)++;
+        }
+    }
+    L86_STATS_CYCLES_ADD(receive_cycles, start);
+    return count;
 }
 
-bool L86::start(StartMode start_mode)
+bool L86::receive_character(char c)
 {
-    minmea_sentence_pmtk message = { MINMEA_PMTK_UNKNOWN, 0, false, false, false };
-    switch (start_mode) {
-        case StartMode::FULL_COLD_START: {
-            message.type = MINMEA_PMTK_CMD_FULL_COLD_START;
-            break;
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+    uint32_t delimiter_time = 0;
+    if (c == '$' || c == '\n') {
+        delimiter_time = arrival_time();
+    }
+#endif
+    if (c == '$') {
+        // Lost end of line or line noise: keep the new sentence instead of merging both
+        _framing_recovering = _framing_state != FramingState::HUNT;
+        if (_framing_recovering) {
+            L86_STATS_INCREMENT(resynchronizations);
         }
-        case StartMode::COLD_START: {
-            message.type = MINMEA_PMTK_CMD_COLD_START;
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+        _sentence_start_time = delimiter_time;
+#endif
+        _received_message[0] = c;
+        _message_len = 1;
+        _framing_checksum = 0;
+        _received_checksum = -1;
+        _framing_state = FramingState::BODY;
+        return false;
+    }
+    if (_framing_state == FramingState::HUNT) {
+        return false;
+    }
+
+    if (_message_len >= MINMEA_MAX_LENGTH - 1) {
+        L86_STATS_INCREMENT(framing_overflows);
+        reset_framing();
+        return false;
+    }
+
+    int digit;
+    switch (_framing_state) {
+        case FramingState::BODY:
+            if (c == '*') {
+                _framing_state = FramingState::CHECKSUM_HIGH;
+            } else if (c == '\r' || c == '\n') {
+                // Sentence without checksum
+                _framing_state = FramingState::END;
+            } else if (isprint(static_cast<unsigned char>(c))) {
+                _framing_checksum ^= c;
+            } else {
+                L86_STATS_INCREMENT(framing_errors);
+                reset_framing();
+                return false;
+            }
             break;
-        }
-        case StartMode::WARM_START: {
-            message.type = MINMEA_PMTK_CMD_WARM_START;
+
+        case FramingState::CHECKSUM_HIGH:
+        case FramingState::CHECKSUM_LOW:
+            digit = hex_value(c);
+            if (digit < 0) {
+                L86_STATS_INCREMENT(framing_errors);
+                reset_framing();
+                return false;
+            }
+            if (_framing_state == FramingState::CHECKSUM_HIGH) {
+                _received_checksum = digit << 4;
+                _framing_state = FramingState::CHECKSUM_LOW;
+            } else {
+                _received_checksum |= digit;
+                _framing_state = FramingState::END;
+            }
             break;
-        }
-        case StartMode::HOT_START: {
-            message.type = MINMEA_PMTK_CMD_HOT_START;
+
+        case FramingState::END:
+            if (c != '\r' && c != '\n') {
+                L86_STATS_INCREMENT(framing_errors);
+                reset_framing();
+                return false;
+            }
             break;
-        }
+
+        case FramingState::HUNT:
+            break;
+    }
+    _received_message[_message_len++] = c;
+    if (c != '\n') {
+        return false;
     }
 
-    return generate_and_send_pmtk_message(message);
+    // Completed message received
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+    _sentence_end_time = delimiter_time;
+    record_latency(LatencyStage::RECEPTION, _sentence_start_time, _sentence_end_time);
+#endif
+    _received_message[_message_len] = '\0';
+    size_t length = _message_len;
+    bool recovered = _framing_recovering;
+    reset_framing();
+    if (_received_checksum >= 0 && _received_checksum != _framing_checksum) {
+        L86_STATS_INCREMENT(checksum_failures);
+        return false;
+    }
+    if (recovered) {
+        L86_STATS_INCREMENT(recovered_sentences);
+    }
+    parse_message(_received_message, length);
+    return true;
 }
 
-bool L86::standby_mode(StandbyMode standby_mode)
+void L86::reset_framing()
 {
-    minmea_sentence_pmtk message = { MINMEA_PMTK_API_SET_PERIODIC_MODE, 0, true, false, false };
-    sprintf(message.parameters, "%i", static_cast<int>(standby_mode));
+    _framing_state = FramingState::HUNT;
+    _framing_recovering = false;
+    _message_len = 0;
+}
 
-    return generate_and_send_pmtk_message(message);
+uint32_t L86::arrival_time()
+{
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+    uint32_t time;
+    // Buffered characters were timestamped by the serial interrupt
+    if (_parser_service) {
+        CriticalSectionLock lock;
+        if (_arrival_times.pop(time)) {
+            return time;
+        }
+        if (_arrival_times_missing > 0) {
+            _arrival_times_missing--;
+        }
+    }
+#endif
+    return static_cast<uint32_t>(now().count());
 }
 
-L86::Satellite *L86::satellites()
+void L86::record_latency(LatencyStage stage, uint32_t start, uint32_t end)
 {
-    return _satellites_informations.satellites;
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+    uint32_t latency_us = end - start;
+    LatencyHistogram &histogram = _latency[static_cast<size_t>(stage)];
+    CriticalSectionLock lock;
+    histogram.buckets[latency_bucket(latency_us)]++;
+    histogram.count++;
+    histogram.total_us += latency_us;
+    if (latency_us < histogram.min_us) {
+        histogram.min_us = latency_us;
+    }
+    if (latency_us > histogram.max_us) {
+        histogram.max_us = latency_us;
+    }
+#else
+    (void)stage;
+    (void)start;
+    (void)end;
+#endif
 }
 
-float L86::latitude()
+void L86::smooth_fix(std::chrono::microseconds fix_local_time, float speed, float course)
 {
-    return _position_informations.latitude;
+#if MBED_CONF_L86_KALMAN_ENABLED
+    typedef KalmanScalar T;
+    constexpr float MAX_OFFSET = 10000.0f; //!< Recenter the origin farther, in m
+    constexpr float MAX_JUMP = 20000.0f; //!< Reseed on a farther measurement, in m
+    constexpr float MAX_VARIANCE = 10000.0f; //!< Measurement variance bound, in m^2
+    constexpr float MAX_ALTITUDE = 20000.0f; //!< Altitude bound, in m
+    constexpr float DEFAULT_DOP = 2.0f; //!< DOP used before the first GGA/GSA
+    const float uere2 = MBED_CONF_L86_UERE * MBED_CONF_L86_UERE;
+    const float speed_variance
+            = MBED_CONF_L86_PREDICTION_SPEED_ERROR * MBED_CONF_L86_PREDICTION_SPEED_ERROR;
+
+    float hdop = _dilution_of_precision.horizontal;
+    float vdop = _dilution_of_precision.vertical;
+    float horizontal_variance = (isnan(hdop) || hdop <= 0.0f ? DEFAULT_DOP : hdop);
+    horizontal_variance *= horizontal_variance * uere2;
+    float vertical_variance = (isnan(vdop) || vdop <= 0.0f ? DEFAULT_DOP : vdop);
+    vertical_variance *= vertical_variance * uere2;
+    // Fixed-point values are limited to +/-32767: a 100 m error already weighs little
+    horizontal_variance = fminf(horizontal_variance, MAX_VARIANCE);
+    vertical_variance = fminf(vertical_variance, MAX_VARIANCE);
+    bool velocity_valid = !isnan(speed) && !isnan(course);
+    float velocity_north = velocity_valid ? speed * cosf(course) : 0.0f;
+    float velocity_east = velocity_valid ? speed * sinf(course) : 0.0f;
+    float altitude = _position_informations.altitude;
+    if (altitude > MAX_ALTITUDE) {
+        altitude = MAX_ALTITUDE;
+    } else if (altitude < -MAX_ALTITUDE) {
+        altitude = -MAX_ALTITUDE;
+    }
+    int64_t epoch = static_cast<int64_t>(_utc_time) * 1000000LL + _utc_microseconds;
+
+    CriticalSectionLock lock;
+    // Fixless sentences carry no position: keep the last estimate and reseed on the next fix
+    if (_global_informations.fix_status == FixStatusGGA::INVALID
+            || !isfinite(_position_informations.latitude)
+            || !isfinite(_position_informations.longitude)) {
+        _kalman_outage = true;
+        return;
+    }
+    float dt = (fix_local_time - _kalman_time).count() * 1e-6f;
+    float north = 0.0f;
+    float east = 0.0f;
+    if (_kalman_initialized) {
+        north = (_position_informations.latitude - _kalman_origin_latitude) * METERS_PER_DEGREE;
+        east = (_position_informations.longitude - _kalman_origin_longitude)
+                * _kalman_meters_per_longitude_degree;
+    }
+    // A jump out of the fixed-point range restarts the filter, like a long gap
+    if (!_kalman_initialized || _kalman_outage || dt < 0.0f
+            || dt > MBED_CONF_L86_KALMAN_RESET_INTERVAL || fabsf(north) > MAX_JUMP
+            || fabsf(east) > MAX_JUMP) {
+        _kalman_origin_latitude = _position_informations.latitude;
+        _kalman_origin_longitude = _position_informations.longitude;
+        _kalman_meters_per_longitude_degree
+                = METERS_PER_DEGREE * cosf(_kalman_origin_latitude * DEGREES_TO_RADIANS);
+        _kalman_north.reset(T(0.0f), T(horizontal_variance), T(velocity_north), T(speed_variance));
+        _kalman_east.reset(T(0.0f), T(horizontal_variance), T(velocity_east), T(speed_variance));
+        _kalman_vertical.reset(T(isnan(altitude) ? 0.0f : altitude),
+                T(vertical_variance),
+                T(0.0f),
+                T(speed_variance));
+        _kalman_altitude_pending = false;
+        _kalman_initialized = true;
+        _kalman_outage = false;
+        _kalman_epoch = epoch;
+        _kalman_time = fix_local_time;
+        return;
+    }
+
+    // RMC, GGA and GLL of a same epoch carry the same position: only filter it once
+    if (epoch != _kalman_epoch) {
+        T q = T(MBED_CONF_L86_KALMAN_PROCESS_NOISE);
+        _kalman_north.predict(T(dt), q);
+        _kalman_east.predict(T(dt), q);
+        _kalman_vertical.predict(T(dt), q);
+        _kalman_north.update_position(T(north), T(horizontal_variance));
+        _kalman_east.update_position(T(east), T(horizontal_variance));
+        if (velocity_valid) {
+            _kalman_north.update_velocity(T(velocity_north), T(speed_variance));
+            _kalman_east.update_velocity(T(velocity_east), T(speed_variance));
+        }
+        _kalman_epoch = epoch;
+        _kalman_time = fix_local_time;
+    }
+    if (_kalman_altitude_pending) {
+        _kalman_vertical.update_position(T(altitude), T(vertical_variance));
+        _kalman_altitude_pending = false;
+    }
+
+    // Keep positions close to the origin, fixed-point positions are limited to +/-32 km
+    north = l86_to_float(_kalman_north.position());
+    east = l86_to_float(_kalman_east.position());
+    if (fabsf(north) > MAX_OFFSET || fabsf(east) > MAX_OFFSET) {
+        _kalman_north.shift(T(north));
+        _kalman_east.shift(T(east));
+        _kalman_origin_latitude += north / METERS_PER_DEGREE;
+        _kalman_origin_longitude += east / _kalman_meters_per_longitude_degree;
+        _kalman_meters_per_longitude_degree
+                = METERS_PER_DEGREE * cosf(_kalman_origin_latitude * DEGREES_TO_RADIANS);
+    }
+#else
+    (void)fix_local_time;
+    (void)speed;
+    (void)course;
+#endif
 }
 
-float L86::longitude()
+void L86::enable_pps(InterruptIn *pps)
 {
-    return _position_informations.longitude;
+    _pps = pps;
+    _pps->rise(callback(this, &L86::pps_rise));
 }
 
-double L86::altitude()
+void L86::pps_rise()
 {
-    return _position_informations.altitude;
+    pps_edge(now());
 }
 
-double L86::speed(L86::SpeedUnit unit)
+void L86::pps_edge(std::chrono::microseconds edge_time)
 {
-    if (unit == SpeedUnit::KMH) {
-        return _movement_informations.speed_kmh;
-    } else {
-        return _movement_informations.speed_knots;
+    CriticalSectionLock lock;
+    _pps_edge_time = edge_time;
+    _pps_edge_pending = true;
+}
+
+void L86::pair_pps_edge(minmea_time time)
+{
+    time_t utc_time = this->time();
+    CriticalSectionLock lock;
+    // The module reports the time of the edge in the following sentences, only pair
+    // whole seconds received less than a second after the edge
+    if (!_pps_edge_pending || time.microseconds != 0 || now() - _pps_edge_time >= 1s) {
+        return;
+    }
+    _pps_edge_pending = false;
+
+    if (_pps_paired && utc_time > _sync_utc_time
+            && utc_time - _sync_utc_time <= PPS_MAX_DRIFT_PERIOD) {
+        float utc_elapsed = (utc_time - _sync_utc_time) * 1e6f;
+        float drift = (_pps_edge_time - _sync_local_time).count() / utc_elapsed - 1.0f;
+        if (fabsf(drift) < PPS_MAX_DRIFT) {
+            _clock_drift += (drift - _clock_drift) * PPS_DRIFT_GAIN;
+        }
     }
+    _sync_local_time = _pps_edge_time;
+    _sync_utc_time = utc_time;
+    _pps_paired = true;
 }
 
-double L86::speed()
+std::chrono::microseconds L86::utc_now()
 {
-    if (MBED_CONF_L86_SPEED_UNIT == SpeedUnit::KMH) {
-        return _movement_informations.speed_kmh;
-    } else {
-        return _movement_informations.speed_knots;
+    std::chrono::microseconds local_time = now();
+    CriticalSectionLock lock;
+    if (!_pps_paired) {
+        return std::chrono::microseconds(0);
     }
+    int64_t elapsed = (local_time - _sync_local_time).count();
+    elapsed -= static_cast<int64_t>(elapsed * _clock_drift);
+    return std::chrono::microseconds(_sync_utc_time * 1000000LL + elapsed);
 }
 
-time_t L86::time()
+bool L86::pps_synchronized()
 {
-    return mktime(&_global_informations.time);
+    std::chrono::microseconds local_time = now();
+    CriticalSectionLock lock;
+    return _pps_paired
+            && local_time - _sync_local_time < std::chrono::seconds(MBED_CONF_L86_PPS_HOLDOVER);
 }
 
-L86::PositionningMode L86::positionning_mode()
+float L86::clock_drift_ppm()
 {
-    return _global_informations.positionning_mode;
+    return _clock_drift * 1e6f;
 }
 
-L86::FixStatusGGA L86::fix_status()
+L86::Prediction L86::predict(std::chrono::microseconds at_time)
 {
-    return _global_informations.fix_status;
+    Prediction prediction;
+    CriticalSectionLock lock;
+    prediction.age = at_time - _fix_local_time;
+    prediction.valid = _fix_available
+            && prediction.age <= std::chrono::milliseconds(MBED_CONF_L86_PREDICTION_MAX_AGE);
+    float age = prediction.age.count() * 1e-6f;
+    prediction.latitude = _fix_latitude + _latitude_rate * age;
+    prediction.longitude = _fix_longitude + _longitude_rate * age;
+    prediction.uncertainty = _fix_uncertainty + MBED_CONF_L86_PREDICTION_SPEED_ERROR * age
+            + 0.5f * MBED_CONF_L86_PREDICTION_MAX_ACCELERATION * age * age;
+    return prediction;
 }
 
-L86::FixStatusGSA L86::fix_satellite_status()
+L86::Fix L86::fix()
 {
-    return _satellites_informations.status;
+    CriticalSectionLock lock;
+    return _fix;
 }
 
-int L86::satellite_count()
+bool L86::attach_fix_callback(Callback<void(const Fix &)> func)
 {
-    return _satellites_informations.satellite_count;
+    CriticalSectionLock lock;
+    for (int i = 0; i < MAX_FIX_CALLBACKS; i++) {
+        if (!_fix_callbacks[i]) {
+            _fix_callbacks[i] = func;
+            return true;
+        }
+    }
+    return false;
 }
 
-L86::Mode L86::mode()
+int L86::attach_nmea_sink(NmeaSink sink, SentenceTypes types)
 {
-    return _satellites_informations.mode;
+    CriticalSectionLock lock;
+    for (int i = 0; i < MAX_NMEA_SINKS; i++) {
+        if (!_nmea_sinks[i].sink) {
+            _nmea_sinks[i].types = types;
+            memset(&_nmea_sinks[i].stats, 0, sizeof(_nmea_sinks[i].stats));
+            _nmea_sinks[i].sink = sink;
+            return i;
+        }
+    }
+    return -1;
 }
 
-L86::DilutionOfPrecision L86::dilution_of_precision()
+L86::NmeaSinkStats L86::nmea_sink_stats(int sink)
 {
-    return _dilution_of_precision;
+    NmeaSinkStats stats = { 0, 0 };
+    if (sink >= 0 && sink < MAX_NMEA_SINKS) {
+        CriticalSectionLock lock;
+        stats = _nmea_sinks[sink].stats;
+    }
+    return stats;
 }
 
-int L86::registered_satellite_count()
+void L86::forward_sentence(
+        enum minmea_sentence_id sentence_id, const char *sentence, size_t length)
 {
-    return _registered_satellite_count;
+    for (int i = 0; i < MAX_NMEA_SINKS; i++) {
+        NmeaSinkSlot &slot = _nmea_sinks[i];
+        if (!slot.sink || !slot.types.test(sentence_id)) {
+            continue;
+        }
+        if (slot.sink(sentence, length)) {
+            slot.stats.forwarded++;
+        } else {
+            slot.stats.dropped++;
+        }
+    }
 }
 
-bool L86::generate_and_send_pmtk_message(minmea_sentence_pmtk message)
+void L86::publish_fix()
 {
-    char buffer[MINMEA_PMTK_MAX_LENGTH];
-    minmea_serialize_pmtk(message, (char *)buffer);
-    _current_pmtk_message = message;
+    // Local time of the fix epoch: from the 1PPS sync if available, else the sentence arrival
+    std::chrono::microseconds fix_local_time = now();
+    if (pps_synchronized()) {
+        fix_local_time = _sync_local_time
+                + std::chrono::microseconds((_utc_time - _sync_utc_time) * 1000000LL
+                        + _utc_microseconds);
+    }
 
-    for (int i = 0; i < 5 && _current_pmtk_message.result == false; i++) {
-        _uart->write((uint8_t *)buffer, strlen(buffer));
-        if (!_current_pmtk_message.ack_expected) {
-            return true;
+    // Velocity converted once per fix to degrees per second, so that predict() needs no trig
+    float speed = _movement_informations.speed_knots * METERS_PER_SECOND_PER_KNOT;
+    float course = _movement_informations.course_over_ground * DEGREES_TO_RADIANS;
+    float latitude_rate = 0.0f;
+    float longitude_rate = 0.0f;
+    if (!isnan(speed) && !isnan(course)) {
+        float meters_per_longitude_degree
+                = METERS_PER_DEGREE * cosf(_position_informations.latitude * DEGREES_TO_RADIANS);
+        latitude_rate = speed * cosf(course) / METERS_PER_DEGREE;
+        if (meters_per_longitude_degree > 1.0f) {
+            longitude_rate = speed * sinf(course) / meters_per_longitude_degree;
+        }
+    }
+    float hdop = _dilution_of_precision.horizontal;
+    float uncertainty = (isnan(hdop) || hdop <= 0.0f) ? 2.0f * MBED_CONF_L86_UERE
+                                                       : hdop * MBED_CONF_L86_UERE;
+#if MBED_CONF_L86_KALMAN_ENABLED
+    smooth_fix(fix_local_time, speed, course);
+#endif
+
+    // Fixless sentences carry no position to extrapolate
+    bool position_valid = _global_informations.fix_status != FixStatusGGA::INVALID
+            && isfinite(_position_informations.latitude)
+            && isfinite(_position_informations.longitude);
+
+    {
+        CriticalSectionLock lock;
+        if (position_valid) {
+            _fix_local_time = fix_local_time;
+            _fix_latitude = _position_informations.latitude;
+            _fix_longitude = _position_informations.longitude;
+            _latitude_rate = latitude_rate;
+            _longitude_rate = longitude_rate;
+            _fix_uncertainty = uncertainty;
+        }
+        _fix_available = position_valid;
+
+        _fix.time = std::chrono::microseconds(
+                static_cast<int64_t>(_utc_time) * 1000000LL + _utc_microseconds);
+        _fix.latitude = _position_informations.latitude;
+        _fix.longitude = _position_informations.longitude;
+        _fix.altitude = _position_informations.altitude;
+        _fix.speed_knots = _movement_informations.speed_knots;
+        _fix.course_over_ground = _movement_informations.course_over_ground;
+        _fix.dilution_of_precision = _dilution_of_precision;
+        _fix.fix_status = _global_informations.fix_status;
+        _fix.satellites_used = _global_informations.satellites_used;
+    }
+
+    for (int i = 0; i < MAX_FIX_CALLBACKS; i++) {
+        if (_fix_callbacks[i]) {
+            _fix_callbacks[i](_fix);
+        }
+    }
+
+    if (_fix.fix_status != FixStatusGGA::INVALID) {
+        if (_ttff_pending) {
+            _ttff_pending = false;
+            _ttff[static_cast<size_t>(_start_mode)]
+                    = std::chrono::duration_cast<std::chrono::milliseconds>(now() - _start_time);
         }
-        for (int j = 0; j < 3 && _current_pmtk_message.ack_received == false; j++) {
-            ThisThread::sleep_for(150ms);
+#if MBED_CONF_L86_PERSISTENCE_ENABLED
+        // kv_set() writes flash, it is deferred to the persistence queue
+        if (_persistence_queue
+                && (!_state_saved
+                        || _fix.time - _saved_fix_time
+                                >= std::chrono::seconds(MBED_CONF_L86_PERSISTENCE_INTERVAL))) {
+            _state_saved = true;
+            _saved_fix_time = _fix.time;
+            _persistence_queue->call(this, &L86::save_state);
         }
+#endif
     }
-    return _current_pmtk_message.result;
+
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+    uint32_t published_time = static_cast<uint32_t>(now().count());
+    record_latency(LatencyStage::PUBLICATION, _sentence_parsed_time, published_time);
+    record_latency(LatencyStage::TOTAL, _sentence_start_time, published_time);
+#endif
 }
 
-void L86::get_received_message()
+void L86::track_fix_status()
 {
-    static int message_len = 0;
-    while (_uart->readable()) {
-        if (message_len >= MINMEA_MAX_LENGTH - 1) {
-            message_len = 0;
+    std::chrono::microseconds time = now();
+    std::chrono::milliseconds elapsed
+            = std::chrono::duration_cast<std::chrono::milliseconds>(time - _start_time);
+    FixStatusGSA status = _satellites_informations.status;
+
+    if (status == FixStatusGSA::FIX2D || status == FixStatusGSA::FIX3D) {
+        if (_ttff_report.first_fix_2d.count() == 0) {
+            _ttff_report.first_fix_2d = elapsed;
         }
-        _uart->read(&_received_message[message_len++], 1);
-        if (_received_message[message_len - 1] == '\n') {
-            // Completed message received
-            _received_message[message_len] = '\0';
-            parse_message(_received_message);
-            message_len = 0;
+        if (status == FixStatusGSA::FIX3D && _ttff_report.first_fix_3d.count() == 0) {
+            _ttff_report.first_fix_3d = elapsed;
         }
+        if (_fix_lost) {
+            _fix_lost = false;
+            std::chrono::milliseconds reacquisition
+                    = std::chrono::duration_cast<std::chrono::milliseconds>(time - _fix_lost_time);
+            _ttff_report.reacquisitions++;
+            _ttff_report.last_reacquisition = reacquisition;
+            _ttff_report.total_reacquisition += reacquisition;
+            if (reacquisition > _ttff_report.max_reacquisition) {
+                _ttff_report.max_reacquisition = reacquisition;
+            }
+        }
+    } else if (status == FixStatusGSA::NOFIX && _ttff_report.first_fix_2d.count() != 0
+            && !_fix_lost) {
+        _fix_lost = true;
+        _fix_lost_time = time;
+        _ttff_report.fix_losses++;
     }
 }
 
-void L86::parse_message(char *message)
+const L86::SentenceHandler L86::_sentence_handlers[MINMEA_SENTENCE_COUNT] = {
+    nullptr, // MINMEA_UNKNOWN
+#if MBED_CONF_L86_RMC_ENABLED
+    &L86::handle_rmc,
+#else
+    nullptr,
+#endif
+#if MBED_CONF_L86_GGA_ENABLED
+    &L86::handle_gga,
+#else
+    nullptr,
+#endif
+#if MBED_CONF_L86_GSA_ENABLED
+    &L86::handle_gsa,
+#else
+    nullptr,
+#endif
+#if MBED_CONF_L86_GLL_ENABLED
+    &L86::handle_gll,
+#else
+    nullptr,
+#endif
+    nullptr, // MINMEA_SENTENCE_GST
+#if MBED_CONF_L86_GSV_ENABLED
+    &L86::handle_gsv,
+#else
+    nullptr,
+#endif
+#if MBED_CONF_L86_VTG_ENABLED
+    &L86::handle_vtg,
+#else
+    nullptr,
+#endif
+    nullptr, // MINMEA_SENTENCE_ZDA
+    &L86::handle_pmtk_ack,
+    &L86::handle_pmtk_epo_info,
+    &L86::handle_pmtk_fix_ctl,
+    &L86::handle_pmtk_nmea_output,
+    &L86::handle_pmtk_release,
+    &L86::handle_pmtk_system_message,
+};
+
+void L86::parse_message(char *message, size_t length)
 {
-    int limit = LIMIT_SATELLITES;
-    switch (minmea_sentence_id(message, false)) {
-        case MINMEA_SENTENCE_PMTK_ACK:
-            break;
+    L86_STATS_CYCLES_START(start);
+    bool position_updated = false;
+    // The framing already checked the sentence integrity
+    enum minmea_sentence_id sentence_id = minmea_sentence_type(message);
+    if (sentence_id != MINMEA_INVALID && _ttff_report.first_sentence.count() == 0) {
+        _ttff_report.first_sentence
+                = std::chrono::duration_cast<std::chrono::milliseconds>(now() - _start_time);
+    }
+    if (sentence_id != MINMEA_INVALID) {
+        forward_sentence(sentence_id, message, length);
+    }
+    if (sentence_id == MINMEA_INVALID) {
+        L86_STATS_INCREMENT(checksum_failures);
+    } else if (_sentence_handlers[sentence_id]) {
+        position_updated = (this->*_sentence_handlers[sentence_id])(message);
+    } else {
+        L86_STATS_INCREMENT(unknown_sentences);
+    }
+    L86_STATS_CYCLES_ADD(parse_cycles, start);
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+    _sentence_parsed_time = static_cast<uint32_t>(now().count());
+    record_latency(LatencyStage::PARSING, _sentence_end_time, _sentence_parsed_time);
+#endif
+    if (position_updated) {
+        publish_fix();
+    }
+}
 
-        case MINMEA_SENTENCE_RMC:
-            struct minmea_sentence_rmc rmc_frame;
-            if (minmea_parse_rmc(&rmc_frame, message)) {
-                if (rmc_frame.valid) {
-                    set_date(rmc_frame.date);
-                    set_time(rmc_frame.time);
-                    set_latitude(rmc_frame.latitude);
-                    set_longitude(rmc_frame.longitude);
-                    _movement_informations.speed_knots = minmea_tofloat(&rmc_frame.speed);
-                    _movement_informations.course_over_ground = minmea_tofloat(&rmc_frame.course);
-                    _position_informations.magnetic_variation
-                            = minmea_tofloat(&rmc_frame.variation);
-                }
-            }
-            break;
+bool L86::handle_pmtk_ack(const char *message)
+{
+    struct minmea_sentence_pmtk_ack &frame = _frame.pmtk_ack;
+    if (minmea_parse_pmtk_ack(&frame, message)) {
+        L86_STATS_INCREMENT(pmtk_acks);
+        acknowledge_command(frame.command, frame.flag);
+    }
+    return false;
+}
 
-        case MINMEA_SENTENCE_VTG:
-            struct minmea_sentence_vtg vtg_frame;
-            if (minmea_parse_vtg(&vtg_frame, message)) {
-                _movement_informations.speed_knots = minmea_tofloat(&vtg_frame.speed_knots);
-                _movement_informations.speed_kmh = minmea_tofloat(&vtg_frame.speed_kph);
-                set_positionning_mode(vtg_frame.faa_mode);
-            }
-            break;
+bool L86::handle_pmtk_epo_info(const char *message)
+{
+    if (minmea_parse_pmtk_epo_info(&_frame.pmtk_epo_info, message)) {
+        answer_query(MINMEA_SENTENCE_PMTK_EPO_INFO);
+    }
+    return false;
+}
 
-        case MINMEA_SENTENCE_GGA:
-            struct minmea_sentence_gga gga_frame;
-            if (minmea_parse_gga(&gga_frame, message)) {
-                set_time(gga_frame.time);
-                set_latitude(gga_frame.latitude);
-                set_longitude(gga_frame.longitude);
-                _position_informations.altitude = minmea_tofloat(&gga_frame.altitude);
-                _satellites_informations.satellite_count = gga_frame.satellites_tracked;
-                set_fix_status(gga_frame.fix_quality);
-                _dilution_of_precision.horizontal = minmea_tofloat(&gga_frame.hdop);
-            }
-            break;
+bool L86::handle_pmtk_fix_ctl(const char *message)
+{
+    if (minmea_parse_pmtk_fix_ctl(&_frame.pmtk_fix_ctl, message)) {
+        answer_query(MINMEA_SENTENCE_PMTK_FIX_CTL);
+    }
+    return false;
+}
 
-        case MINMEA_SENTENCE_GSA:
-            struct minmea_sentence_gsa gsa_frame;
-            if (minmea_parse_gsa(&gsa_frame, message)) {
-                set_fix_satellite_status(gsa_frame.fix_type);
-                set_mode(gsa_frame.mode);
-                _dilution_of_precision.horizontal = minmea_tofloat(&gsa_frame.hdop);
-                _dilution_of_precision.positional = minmea_tofloat(&gsa_frame.pdop);
-                _dilution_of_precision.vertical = minmea_tofloat(&gsa_frame.vdop);
-                for (int i = 0; i < MAX_SATELLITES; i++) {
-                    _satellites_informations.satellites[i].id = gsa_frame.sats[i];
-                }
-            }
-            break;
+bool L86::handle_pmtk_nmea_output(const char *message)
+{
+    if (minmea_parse_pmtk_nmea_output(&_frame.pmtk_nmea_output, message)) {
+        answer_query(MINMEA_SENTENCE_PMTK_NMEA_OUTPUT);
+    }
+    return false;
+}
 
-        case MINMEA_SENTENCE_GSV:
-            struct minmea_sentence_gsv gsv_frame;
-            if (minmea_parse_gsv(&gsv_frame, message)) {
-                // last sequence message
-                if (gsv_frame.msg_nr == gsv_frame.total_msgs) {
-                    limit = MAX_SATELLITES - gsv_frame.total_sats;
-                }
-                // reset satellites if first sequence number
-                if (gsv_frame.msg_nr == 1) {
-                    _registered_satellite_count = 0;
-                }
-                for (int i = 0; i <= limit; i++) {
-                    Satellite satellite;
-                    satellite.id = (uint16_t)gsv_frame.sats[i].nr;
-                    satellite.elevation = (uint16_t)gsv_frame.sats[i].elevation;
-                    satellite.azimuth = (uint16_t)gsv_frame.sats[i].azimuth;
-                    satellite.snr = (uint16_t)gsv_frame.sats[i].snr;
-                    _satellites_informations.satellites[_registered_satellite_count++] = satellite;
-                }
-                _satellites_informations.satellite_count = gsv_frame.total_sats;
-            }
-            break;
+bool L86::handle_pmtk_system_message(const char *message)
+{
+    if (minmea_parse_pmtk_system_message(&_frame.pmtk_system_message, message)
+            && _frame.pmtk_system_message.message == MINMEA_PMTK_SYSTEM_MESSAGE_STARTUP) {
+        // The module restarted with its default (or backed up) configuration
+        invalidate_configuration();
+    }
+    return false;
+}
 
-        case MINMEA_SENTENCE_GLL:
-            struct minmea_sentence_gll gll_frame;
-            if (minmea_parse_gll(&gll_frame, message)) {
-                if (gll_frame.status == 'A') {
-                    set_time(gll_frame.time);
-                    set_positionning_mode(gll_frame.mode);
-                    set_latitude(gll_frame.latitude);
-                    set_longitude(gll_frame.longitude);
-                }
-            }
-            break;
+bool L86::handle_pmtk_release(const char *message)
+{
+    if (minmea_parse_pmtk_release(&_frame.pmtk_release, message)) {
+        answer_query(MINMEA_SENTENCE_PMTK_RELEASE);
+    }
+    return false;
+}
 
-        default:
-            // printf("\n -- Unknown command --> %s\n", message);
-            break;
+#if MBED_CONF_L86_RMC_ENABLED
+bool L86::handle_rmc(const char *message)
+{
+    struct minmea_sentence_rmc &frame = _frame.rmc;
+    if (!minmea_parse_rmc(&frame, message)) {
+        return false;
+    }
+    L86_STATS_INCREMENT(sentences[static_cast<size_t>(NmeaCommandType::RMC)]);
+    if (!frame.valid) {
+        return false;
+    }
+    if (_ttff_report.first_valid_rmc.count() == 0) {
+        _ttff_report.first_valid_rmc
+                = std::chrono::duration_cast<std::chrono::milliseconds>(now() - _start_time);
+    }
+    set_time(frame.time);
+    set_date(frame.date);
+    pair_pps_edge(frame.time);
+    set_latitude(frame.latitude);
+    set_longitude(frame.longitude);
+    _movement_informations.speed_knots = minmea_tofloat(&frame.speed);
+    _movement_informations.course_over_ground = minmea_tofloat(&frame.course);
+    _position_informations.magnetic_variation = minmea_tofloat(&frame.variation);
+    return true;
+}
+#endif
+
+#if MBED_CONF_L86_VTG_ENABLED
+bool L86::handle_vtg(const char *message)
+{
+    struct minmea_sentence_vtg &frame = _frame.vtg;
+    if (minmea_parse_vtg(&frame, message)) {
+        L86_STATS_INCREMENT(sentences[static_cast<size_t>(NmeaCommandType::VTG)]);
+        _movement_informations.speed_knots = minmea_tofloat(&frame.speed_knots);
+        _movement_informations.speed_kmh = minmea_tofloat(&frame.speed_kph);
+        set_positionning_mode(frame.faa_mode);
+    }
+    return false;
+}
+#endif
+
+#if MBED_CONF_L86_GGA_ENABLED
+bool L86::handle_gga(const char *message)
+{
+    struct minmea_sentence_gga &frame = _frame.gga;
+    if (!minmea_parse_gga(&frame, message)) {
+        return false;
+    }
+    L86_STATS_INCREMENT(sentences[static_cast<size_t>(NmeaCommandType::GGA)]);
+    set_time(frame.time);
+    set_latitude(frame.latitude);
+    set_longitude(frame.longitude);
+    _position_informations.altitude = minmea_tofloat(&frame.altitude);
+#if MBED_CONF_L86_KALMAN_ENABLED
+    _kalman_altitude_pending = !isnan(_position_informations.altitude);
+#endif
+    _satellites_informations.satellite_count = frame.satellites_tracked;
+    _global_informations.satellites_used = frame.satellites_tracked;
+    set_fix_status(frame.fix_quality);
+    _dilution_of_precision.horizontal = minmea_tofloat(&frame.hdop);
+    return true;
+}
+#endif
+
+#if MBED_CONF_L86_GSA_ENABLED
+bool L86::handle_gsa(const char *message)
+{
+    struct minmea_sentence_gsa &frame = _frame.gsa;
+    if (minmea_parse_gsa(&frame, message)) {
+        L86_STATS_INCREMENT(sentences[static_cast<size_t>(NmeaCommandType::GSA)]);
+        set_fix_satellite_status(frame.fix_type);
+        track_fix_status();
+        set_mode(frame.mode);
+        _dilution_of_precision.horizontal = minmea_tofloat(&frame.hdop);
+        _dilution_of_precision.positional = minmea_tofloat(&frame.pdop);
+        _dilution_of_precision.vertical = minmea_tofloat(&frame.vdop);
+        for (int i = 0; i < MAX_SATELLITES; i++) {
+            _satellites_informations.satellites[i].id = frame.sats[i];
+        }
     }
+    return false;
 }
+#endif
+
+#if MBED_CONF_L86_GSV_ENABLED
+bool L86::handle_gsv(const char *message)
+{
+    struct minmea_sentence_gsv &frame = _frame.gsv;
+    if (!minmea_parse_gsv(&frame, message)) {
+        return false;
+    }
+    L86_STATS_INCREMENT(sentences[static_cast<size_t>(NmeaCommandType::GSV)]);
+    // reset satellites if first sequence number
+    if (frame.msg_nr == 1) {
+        _registered_satellite_count = 0;
+    }
+    // the last sequence message may hold less satellites
+    int count = frame.total_sats - (frame.msg_nr - 1) * LIMIT_SATELLITES;
+    if (count > LIMIT_SATELLITES) {
+        count = LIMIT_SATELLITES;
+    }
+    for (int i = 0; i < count && _registered_satellite_count < MAX_SATELLITES; i++) {
+        Satellite satellite;
+        satellite.id = (uint16_t)frame.sats[i].nr;
+        satellite.elevation = (uint16_t)frame.sats[i].elevation;
+        satellite.azimuth = (uint16_t)frame.sats[i].azimuth;
+        satellite.snr = (uint16_t)frame.sats[i].snr;
+        _satellites_informations.satellites[_registered_satellite_count++] = satellite;
+    }
+    _satellites_informations.satellite_count = frame.total_sats;
+    return false;
+}
+#endif
+
+#if MBED_CONF_L86_GLL_ENABLED
+bool L86::handle_gll(const char *message)
+{
+    struct minmea_sentence_gll &frame = _frame.gll;
+    if (!minmea_parse_gll(&frame, message)) {
+        return false;
+    }
+    L86_STATS_INCREMENT(sentences[static_cast<size_t>(NmeaCommandType::GLL)]);
+    if (frame.status != 'A') {
+        return false;
+    }
+    set_time(frame.time);
+    set_positionning_mode(frame.mode);
+    set_latitude(frame.latitude);
+    set_longitude(frame.longitude);
+    return true;
+}
+#endif
 
 void L86::start_receive()
 {
-    _uart->attach(callback(this, &L86::get_received_message));
+    _uart->enable_output(1);
+    if (_parser_service) {
+        _uart->attach(callback(this, &L86::buffer_received_message));
+    } else {
+        _uart->attach(callback(this, &L86::get_received_message));
+    }
 }
 
 void L86::stop_receive()
@@ -337,6 +2076,42 @@ void L86::stop_receive()
     _uart->enable_output(0);
 }
 
+FileHandle *L86::suspend_io(std::chrono::milliseconds timeout)
+{
+    Timer timer;
+    timer.start();
+    while (true) {
+        {
+            CriticalSectionLock lock;
+            if (_active_command < 0 && _command_queue.empty() && _tx_buffer.empty()) {
+                _io_suspended = true;
+                break;
+            }
+        }
+        if (timer.elapsed_time() > timeout) {
+            return nullptr;
+        }
+        ThisThread::sleep_for(10ms);
+    }
+    _uart->attach(nullptr, SerialBase::TxIrq);
+    _uart->attach(nullptr, SerialBase::RxIrq);
+    return _uart;
+}
+
+void L86::resume_io()
+{
+    {
+        CriticalSectionLock lock;
+        reset_framing();
+    }
+    start_receive();
+    CriticalSectionLock lock;
+    _io_suspended = false;
+    if (_active_command < 0) {
+        start_next_command();
+    }
+}
+
 void L86::set_positionning_mode(char c_positionning_mode)
 {
     switch (c_positionning_mode) {
@@ -407,16 +2182,35 @@ void L86::set_mode(char c_mode)
 
 void L86::set_time(struct minmea_time time)
 {
+    if (time.hours < 0) {
+        return;
+    }
     _global_informations.time.tm_hour = time.hours;
     _global_informations.time.tm_min = time.minutes;
     _global_informations.time.tm_sec = time.seconds;
+
+    int32_t seconds_of_day = time.hours * 3600 + time.minutes * 60 + time.seconds;
+    // GGA and GLL carry no date: follow midnight until the next RMC date
+    if (seconds_of_day < _utc_seconds_of_day - SECONDS_PER_DAY / 2) {
+        _utc_days++;
+    }
+    _utc_seconds_of_day = seconds_of_day;
+    _utc_microseconds = time.microseconds;
+    _utc_time = static_cast<time_t>(_utc_days) * SECONDS_PER_DAY + _utc_seconds_of_day;
 }
 
 void L86::set_date(struct minmea_date date)
 {
+    if (date.year < 0) {
+        return;
+    }
     _global_informations.time.tm_mday = date.day;
     _global_informations.time.tm_mon = date.month - 1; // Month in struct tm is 0-indexed
     _global_informations.time.tm_year = date.year + 100; // Adding 100 to the year to offset it from 1900
+
+    _utc_days = static_cast<int32_t>(
+            minmea_days_from_civil(2000 + date.year, date.month, date.day));
+    _utc_time = static_cast<time_t>(_utc_days) * SECONDS_PER_DAY + _utc_seconds_of_day;
 }
 void L86::set_longitude(minmea_float longitude)
 {
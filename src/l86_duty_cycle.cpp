@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_duty_cycle.h"
+
+L86DutyCycleScheduler::L86DutyCycleScheduler(L86 *l86, EventQueue *queue)
+{
+    _l86 = l86;
+    _queue = queue;
+    _state = State::CONTINUOUS;
+    _target = State::CONTINUOUS;
+    _reschedule_pending = false;
+    _stationary_fixes = 0;
+    _run_stationary = false;
+    _sleep_time = MBED_CONF_L86_DUTY_CYCLE_MIN_SLEEP_TIME;
+    _window_event = 0;
+    _window_anchored = true;
+    _last_fix_time = std::chrono::microseconds(0);
+}
+
+void L86DutyCycleScheduler::process(const L86::Fix &fix)
+{
+    {
+        CriticalSectionLock lock;
+        if (!_window_anchored) {
+            _window_anchored = true;
+            _queue->call(this, &L86DutyCycleScheduler::anchor_window);
+        }
+    }
+
+    // Sentences of a same epoch publish the same fix
+    if (fix.time == _last_fix_time) {
+        return;
+    }
+    _last_fix_time = fix.time;
+
+    float hdop = fix.dilution_of_precision.horizontal;
+    bool good_fix = fix.fix_status != L86::FixStatusGGA::INVALID && !isnan(fix.speed_knots)
+            && (isnan(hdop) || hdop <= MBED_CONF_L86_DUTY_CYCLE_MAX_HDOP);
+
+    if (!good_fix || fix.speed_knots >= MBED_CONF_L86_DUTY_CYCLE_MOVING_SPEED) {
+        _stationary_fixes = 0;
+        request(State::CONTINUOUS);
+    } else if (fix.speed_knots < MBED_CONF_L86_DUTY_CYCLE_STATIONARY_SPEED) {
+        _run_stationary = true;
+        if (_stationary_fixes < MBED_CONF_L86_DUTY_CYCLE_STATIONARY_FIXES) {
+            _stationary_fixes++;
+        } else {
+            request(State::PERIODIC);
+        }
+    }
+}
+
+bool L86DutyCycleScheduler::periodic()
+{
+    return _state == State::PERIODIC;
+}
+
+uint32_t L86DutyCycleScheduler::sleep_time()
+{
+    return _sleep_time;
+}
+
+void L86DutyCycleScheduler::request(State target)
+{
+    CriticalSectionLock lock;
+    _target = target;
+    if (_target != _state && !_reschedule_pending) {
+        _reschedule_pending = true;
+        _queue->call(this, &L86DutyCycleScheduler::reschedule);
+    }
+}
+
+void L86DutyCycleScheduler::reschedule()
+{
+    State target;
+    {
+        CriticalSectionLock lock;
+        _reschedule_pending = false;
+        target = _target;
+    }
+    if (target == _state) {
+        return;
+    }
+
+    if (target == State::CONTINUOUS) {
+        _queue->cancel(_window_event);
+        {
+            CriticalSectionLock lock;
+            _window_anchored = true;
+        }
+        _l86->start_receive();
+        if (_l86->standby_mode(L86::StandbyMode::NORMAL_MODE)) {
+            _state = State::CONTINUOUS;
+            _sleep_time = MBED_CONF_L86_DUTY_CYCLE_MIN_SLEEP_TIME;
+        }
+    } else if (configure_periodic()) {
+        _state = State::PERIODIC;
+        _run_stationary = false;
+        _window_event = _queue->call_in(std::chrono::milliseconds(MBED_CONF_L86_DUTY_CYCLE_RUN_TIME),
+                this,
+                &L86DutyCycleScheduler::close_window);
+    }
+}
+
+bool L86DutyCycleScheduler::configure_periodic()
+{
+    L86::PeriodicParameters parameters
+            = { MBED_CONF_L86_DUTY_CYCLE_RUN_TIME, _sleep_time, 0, 0 };
+    return _l86->standby_mode(L86::StandbyMode::PERIODIC_STANDBY_MODE, parameters);
+}
+
+void L86DutyCycleScheduler::close_window()
+{
+    if (_state != State::PERIODIC) {
+        return;
+    }
+    // Still parked: sleep longer, the new timings restart the module cycle
+    if (_run_stationary && _sleep_time < MBED_CONF_L86_DUTY_CYCLE_MAX_SLEEP_TIME) {
+        uint32_t sleep_time = _sleep_time * 2;
+        if (sleep_time > MBED_CONF_L86_DUTY_CYCLE_MAX_SLEEP_TIME) {
+            sleep_time = MBED_CONF_L86_DUTY_CYCLE_MAX_SLEEP_TIME;
+        }
+        uint32_t previous_sleep_time = _sleep_time;
+        _sleep_time = sleep_time;
+        if (!configure_periodic()) {
+            _sleep_time = previous_sleep_time;
+        }
+    }
+    _l86->stop_receive();
+    _window_event = _queue->call_in(
+            std::chrono::milliseconds(_sleep_time - MBED_CONF_L86_DUTY_CYCLE_WAKE_UP_GUARD),
+            this,
+            &L86DutyCycleScheduler::open_window);
+}
+
+void L86DutyCycleScheduler::open_window()
+{
+    if (_state != State::PERIODIC) {
+        return;
+    }
+    _run_stationary = false;
+    {
+        CriticalSectionLock lock;
+        _window_anchored = false;
+    }
+    _l86->start_receive();
+    // Closed by anchor_window() once the run outputs, or after a whole module cycle without
+    _window_event = _queue->call_in(std::chrono::milliseconds(_sleep_time
+                                            + MBED_CONF_L86_DUTY_CYCLE_RUN_TIME
+                                            + MBED_CONF_L86_DUTY_CYCLE_WAKE_UP_GUARD),
+            this,
+            &L86DutyCycleScheduler::close_window);
+}
+
+void L86DutyCycleScheduler::anchor_window()
+{
+    if (_state != State::PERIODIC) {
+        return;
+    }
+    _queue->cancel(_window_event);
+    _window_event = _queue->call_in(std::chrono::milliseconds(MBED_CONF_L86_DUTY_CYCLE_RUN_TIME),
+            this,
+            &L86DutyCycleScheduler::close_window);
+}
@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_epo.h"
+
+namespace {
+constexpr uint8_t PREAMBLE_1 = 0x04;
+constexpr uint8_t PREAMBLE_2 = 0x24;
+constexpr size_t PACKET_OVERHEAD = 9; //!< Preamble, length, command, checksum and end of line
+constexpr uint16_t COMMAND_EPO_DATA = 722;
+constexpr uint16_t COMMAND_EPO_ACK = 723;
+constexpr uint16_t COMMAND_SET_OUTPUT_FORMAT = 253;
+constexpr uint16_t FINAL_SEQUENCE = 0xFFFF; //!< Sequence number of the end of transfer packet
+constexpr size_t ACK_PACKET_SIZE = PACKET_OVERHEAD + 3;
+constexpr std::chrono::milliseconds IO_SUSPEND_TIMEOUT = std::chrono::milliseconds(
+        MBED_CONF_L86_PMTK_ACK_TIMEOUT * MBED_CONF_L86_PMTK_MAX_ATTEMPTS
+        * MBED_CONF_L86_COMMAND_QUEUE_SIZE); //!< Worst case of a full command queue
+
+void put_uint16(uint8_t *buffer, uint16_t value)
+{
+    buffer[0] = value & 0xFF;
+    buffer[1] = value >> 8;
+}
+
+uint16_t get_uint16(const uint8_t *buffer)
+{
+    return buffer[0] | (buffer[1] << 8);
+}
+}
+
+L86EpoUploader::L86EpoUploader(L86 *l86, uint8_t window):
+        L86EpoUploader(static_cast<FileHandle *>(nullptr), window)
+{
+    _l86 = l86;
+}
+
+L86EpoUploader::L86EpoUploader(FileHandle *link, uint8_t window)
+{
+    _l86 = nullptr;
+    _link = link;
+    if (window < 1) {
+        window = 1;
+    } else if (window > MBED_CONF_L86_EPO_WINDOW) {
+        window = MBED_CONF_L86_EPO_WINDOW;
+    }
+    _window = window;
+    _rx_state = RxState::PREAMBLE_1;
+    _rx_len = 0;
+    _file = nullptr;
+    _block_device = nullptr;
+    _block_address = 0;
+    _block_remaining = 0;
+}
+
+L86EpoUploader::Result L86EpoUploader::upload(FileHandle *file, Report *report)
+{
+    _file = file;
+    return run(Source(this, &L86EpoUploader::read_file), report);
+}
+
+L86EpoUploader::Result L86EpoUploader::upload(
+        BlockDevice *block_device, bd_addr_t address, bd_size_t size, Report *report)
+{
+    _block_device = block_device;
+    _block_address = address;
+    _block_remaining = size;
+    return run(Source(this, &L86EpoUploader::read_block_device), report);
+}
+
+L86EpoUploader::Result L86EpoUploader::run(Source source, Report *report)
+{
+    Report local_report;
+    if (!report) {
+        report = &local_report;
+    }
+    memset(report, 0, sizeof(*report));
+
+    if (_l86) {
+        // Binary packets must not reach the NMEA parser, nor commands the binary stream
+        _link = _l86->suspend_io(IO_SUSPEND_TIMEOUT);
+        if (!_link) {
+            return Result::LINK_ERROR;
+        }
+    }
+
+    // Switch to binary mode, keeping the current baudrate
+    minmea_sentence_pmtk message = { MINMEA_PMTK_SET_OUTPUT_FORMAT, "1,0", false, false, false };
+    char buffer[MINMEA_PMTK_MAX_LENGTH];
+    minmea_serialize_pmtk(message, buffer);
+    Result result = Result::LINK_ERROR;
+    if (_link->write(buffer, strlen(buffer)) == static_cast<ssize_t>(strlen(buffer))) {
+        ThisThread::sleep_for(100ms);
+        _rx_state = RxState::PREAMBLE_1;
+        result = transfer(source, report);
+    }
+
+    // Back to NMEA mode, even after a failure
+    uint8_t format[5] = { 0 };
+    format[1] = MBED_CONF_L86_EPO_BAUDRATE & 0xFF;
+    format[2] = (MBED_CONF_L86_EPO_BAUDRATE >> 8) & 0xFF;
+    format[3] = (MBED_CONF_L86_EPO_BAUDRATE >> 16) & 0xFF;
+    format[4] = (MBED_CONF_L86_EPO_BAUDRATE >> 24) & 0xFF;
+    send_packet(COMMAND_SET_OUTPUT_FORMAT, format, sizeof(format));
+    ThisThread::sleep_for(100ms);
+
+    if (_l86) {
+        _l86->resume_io();
+        if (result == Result::SUCCESS) {
+            if (!_l86->epo_info(&report->info)) {
+                result = Result::TIMEOUT;
+            } else if (report->info.sets == 0) {
+                result = Result::REJECTED;
+            }
+        }
+    }
+
+    return result;
+}
+
+L86EpoUploader::Result L86EpoUploader::transfer(Source source, Report *report)
+{
+    Timer timer;
+    timer.start();
+
+    // Go-back-N: packets from base to next - 1 are sent and waiting for their acknowledge
+    uint32_t base = 0;
+    uint32_t next = 0;
+    bool end_of_data = false;
+    int retries = 0;
+
+    while (!end_of_data || base != next) {
+        while (!end_of_data && next - base < _window) {
+            uint8_t *data = _packets[next % _window];
+            size_t len = 0;
+            while (len < PACKET_DATA_SIZE) {
+                ssize_t read_len = source(data + len, PACKET_DATA_SIZE - len);
+                if (read_len < 0) {
+                    return Result::SOURCE_ERROR;
+                }
+                if (read_len == 0) {
+                    end_of_data = true;
+                    break;
+                }
+                len += read_len;
+            }
+            if (len % SV_RECORD_SIZE != 0) {
+                return Result::SOURCE_ERROR;
+            }
+            if (len == 0) {
+                break;
+            }
+            memset(data + len, 0, PACKET_DATA_SIZE - len);
+            if (!send_data_packet(next, data)) {
+                return Result::LINK_ERROR;
+            }
+            report->bytes += len;
+            report->packets++;
+            next++;
+        }
+        if (base == next) {
+            break;
+        }
+
+        uint16_t sequence;
+        bool success = true;
+        if (wait_ack(&sequence,
+                    &success,
+                    std::chrono::milliseconds(MBED_CONF_L86_EPO_ACK_TIMEOUT))) {
+            uint16_t offset = sequence - static_cast<uint16_t>(base);
+            if (offset >= next - base) {
+                continue; // duplicate acknowledge of a retransmitted packet
+            }
+            // The module handles packets in order: an acknowledge covers the previous ones
+            base += offset;
+            if (success) {
+                base++;
+                retries = 0;
+                continue;
+            }
+        }
+
+        // Missing or negative acknowledge: resend the whole window
+        if (++retries > MBED_CONF_L86_EPO_MAX_RETRIES) {
+            return success ? Result::TIMEOUT : Result::REJECTED;
+        }
+        for (uint32_t i = base; i != next; i++) {
+            if (!send_data_packet(i, _packets[i % _window])) {
+                return Result::LINK_ERROR;
+            }
+            report->packets++;
+            report->retransmissions++;
+        }
+    }
+
+    // End of transfer: all-zero packet with the final sequence number
+    memset(_packets[0], 0, PACKET_DATA_SIZE);
+    for (retries = 0; retries <= MBED_CONF_L86_EPO_MAX_RETRIES; retries++) {
+        if (!send_data_packet(FINAL_SEQUENCE, _packets[0])) {
+            return Result::LINK_ERROR;
+        }
+        uint16_t sequence = 0;
+        bool success = false;
+        while (wait_ack(&sequence, &success,
+                std::chrono::milliseconds(MBED_CONF_L86_EPO_ACK_TIMEOUT))) {
+            if (sequence == FINAL_SEQUENCE) {
+                break;
+            }
+        }
+        if (sequence == FINAL_SEQUENCE && success) {
+            break;
+        }
+    }
+    if (retries > MBED_CONF_L86_EPO_MAX_RETRIES) {
+        return Result::TIMEOUT;
+    }
+
+    timer.stop();
+    report->duration = std::chrono::duration_cast<std::chrono::milliseconds>(timer.elapsed_time());
+    if (report->duration.count() > 0) {
+        report->throughput = static_cast<uint32_t>(
+                static_cast<uint64_t>(report->bytes) * 1000 / report->duration.count());
+    }
+    return Result::SUCCESS;
+}
+
+ssize_t L86EpoUploader::read_file(uint8_t *buffer, size_t size)
+{
+    return _file->read(buffer, size);
+}
+
+ssize_t L86EpoUploader::read_block_device(uint8_t *buffer, size_t size)
+{
+    if (size > _block_remaining) {
+        size = _block_remaining;
+    }
+    if (size == 0) {
+        return 0;
+    }
+    if (_block_device->read(buffer, _block_address, size) != 0) {
+        return -1;
+    }
+    _block_address += size;
+    _block_remaining -= size;
+    return size;
+}
+
+bool L86EpoUploader::send_packet(uint16_t command, const uint8_t *payload, size_t size)
+{
+    uint8_t header[6];
+    uint8_t footer[3];
+    header[0] = PREAMBLE_1;
+    header[1] = PREAMBLE_2;
+    put_uint16(header + 2, size + PACKET_OVERHEAD);
+    put_uint16(header + 4, command);
+
+    uint8_t checksum = header[2] ^ header[3] ^ header[4] ^ header[5];
+    for (size_t i = 0; i < size; i++) {
+        checksum ^= payload[i];
+    }
+    footer[0] = checksum;
+    footer[1] = '\r';
+    footer[2] = '\n';
+
+    return _link->write(header, sizeof(header)) == static_cast<ssize_t>(sizeof(header))
+            && _link->write(payload, size) == static_cast<ssize_t>(size)
+            && _link->write(footer, sizeof(footer)) == static_cast<ssize_t>(sizeof(footer));
+}
+
+bool L86EpoUploader::send_data_packet(uint16_t sequence, const uint8_t *data)
+{
+    uint8_t payload[2 + PACKET_DATA_SIZE];
+    put_uint16(payload, sequence);
+    memcpy(payload + 2, data, PACKET_DATA_SIZE);
+    return send_packet(COMMAND_EPO_DATA, payload, sizeof(payload));
+}
+
+bool L86EpoUploader::wait_ack(uint16_t *sequence, bool *success, std::chrono::milliseconds timeout)
+{
+    Timer timer;
+    timer.start();
+
+    while (timer.elapsed_time() < timeout) {
+        if (!_link->readable()) {
+            ThisThread::sleep_for(1ms);
+            continue;
+        }
+        uint8_t c;
+        if (_link->read(&c, 1) != 1) {
+            return false;
+        }
+
+        switch (_rx_state) {
+            case RxState::PREAMBLE_1:
+                if (c == PREAMBLE_1) {
+                    _rx_state = RxState::PREAMBLE_2;
+                }
+                break;
+
+            case RxState::PREAMBLE_2:
+                if (c == PREAMBLE_2) {
+                    _rx_packet[0] = PREAMBLE_1;
+                    _rx_packet[1] = PREAMBLE_2;
+                    _rx_len = 2;
+                    _rx_state = RxState::PAYLOAD;
+                } else if (c != PREAMBLE_1) {
+                    _rx_state = RxState::PREAMBLE_1;
+                }
+                break;
+
+            case RxState::PAYLOAD: {
+                _rx_packet[_rx_len++] = c;
+                if (_rx_len < 4) {
+                    break;
+                }
+                size_t length = get_uint16(_rx_packet + 2);
+                if (length < PACKET_OVERHEAD || length > sizeof(_rx_packet)) {
+                    // Not a packet expected during the upload (or stale NMEA data)
+                    _rx_state = RxState::PREAMBLE_1;
+                    break;
+                }
+                if (_rx_len < length) {
+                    break;
+                }
+                _rx_state = RxState::PREAMBLE_1;
+
+                uint8_t checksum = 0;
+                for (size_t i = 2; i < length - 3; i++) {
+                    checksum ^= _rx_packet[i];
+                }
+                if (checksum != _rx_packet[length - 3] || _rx_packet[length - 2] != '\r'
+                        || _rx_packet[length - 1] != '\n') {
+                    break;
+                }
+                if (get_uint16(_rx_packet + 4) == COMMAND_EPO_ACK && length == ACK_PACKET_SIZE) {
+                    *sequence = get_uint16(_rx_packet + 6);
+                    *success = _rx_packet[8] == 1;
+                    return true;
+                }
+            } break;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_fusion.h"
+
+namespace {
+constexpr float METERS_PER_DEGREE = 111195.0f; //!< Mean length of a latitude degree
+constexpr float DEGREES_TO_RADIANS = 0.0174532925f;
+constexpr float METERS_PER_SECOND_PER_KNOT = 0.514444f;
+constexpr float DGPS_VARIANCE_FACTOR = 0.25f; //!< Differential fix, half the error
+constexpr float ESTIMATED_VARIANCE_FACTOR = 16.0f; //!< Dead reckoning, four times the error
+}
+
+L86FixFusion::L86FixFusion()
+{
+    for (int i = 0; i < MAX_RECEIVERS; i++) {
+        _receivers[i].fusion = this;
+        _receivers[i].index = i;
+        _receivers[i].pending = false;
+        _receivers[i].variance = NAN;
+        _receivers[i].health = { Health::UNKNOWN, 0.0f, NAN, 0, 0, 0 };
+    }
+    _receiver_count = 0;
+    _epoch_open = false;
+    _epoch = std::chrono::microseconds(0);
+    _last_epoch = std::chrono::microseconds(0);
+    _fused_valid = false;
+    _fused_variance = NAN;
+}
+
+int L86FixFusion::add_receiver(L86 *l86)
+{
+    int index;
+    {
+        CriticalSectionLock lock;
+        if (_receiver_count >= MAX_RECEIVERS) {
+            return -1;
+        }
+        index = _receiver_count;
+    }
+    if (l86 && !l86->attach_fix_callback(callback(&_receivers[index], &Receiver::process))) {
+        return -1;
+    }
+    CriticalSectionLock lock;
+    _receiver_count++;
+    return index;
+}
+
+void L86FixFusion::attach(Callback<void(const L86::Fix &)> func)
+{
+    _callback = func;
+}
+
+void L86FixFusion::process(int receiver, const L86::Fix &fix)
+{
+    // Fixes without UTC time cannot be aligned
+    if (receiver < 0 || receiver >= _receiver_count || fix.time.count() <= 0) {
+        return;
+    }
+    const std::chrono::microseconds tolerance
+            = std::chrono::milliseconds(MBED_CONF_L86_FUSION_EPOCH_TOLERANCE);
+    L86::Fix fused;
+    bool publish = false;
+    {
+        CriticalSectionLock lock;
+        if (_epoch_open && fix.time > _epoch + tolerance) {
+            fuse(&fused);
+            publish = true;
+        }
+        // Fixes of an epoch already fused are dropped
+        bool late = _epoch_open ? fix.time < _epoch - tolerance
+                                : _last_epoch.count() != 0 && fix.time <= _last_epoch + tolerance;
+        if (!late) {
+            if (!_epoch_open) {
+                _epoch = fix.time;
+                _epoch_open = true;
+            }
+            // Sentences of a same epoch publish the fix again, as it gets completed
+            _receivers[receiver].fix = fix;
+            _receivers[receiver].pending = true;
+        }
+    }
+    if (publish && _callback) {
+        _callback(fused);
+    }
+}
+
+void L86FixFusion::flush()
+{
+    L86::Fix fused;
+    {
+        CriticalSectionLock lock;
+        if (!_epoch_open) {
+            return;
+        }
+        fuse(&fused);
+    }
+    if (_callback) {
+        _callback(fused);
+    }
+}
+
+L86FixFusion::ReceiverHealth L86FixFusion::health(int receiver)
+{
+    ReceiverHealth health = { Health::UNKNOWN, 0.0f, NAN, 0, 0, 0 };
+    if (receiver >= 0 && receiver < MAX_RECEIVERS) {
+        CriticalSectionLock lock;
+        health = _receivers[receiver].health;
+    }
+    return health;
+}
+
+void L86FixFusion::fuse(L86::Fix *fused)
+{
+    int candidates[MAX_RECEIVERS];
+    int count = 0;
+    for (int i = 0; i < _receiver_count; i++) {
+        Receiver &receiver = _receivers[i];
+        receiver.health.weight = 0.0f;
+        receiver.health.offset = NAN;
+        receiver.variance = receiver.pending ? variance(receiver.fix) : NAN;
+        if (!receiver.pending) {
+            receiver.health.health = Health::MISSING;
+            receiver.health.missed++;
+        } else if (isnan(receiver.variance)) {
+            receiver.health.health = Health::NO_FIX;
+            receiver.health.missed++;
+        } else {
+            candidates[count++] = i;
+        }
+        receiver.pending = false;
+    }
+    _epoch_open = false;
+    _last_epoch = _epoch;
+
+    if (count == 0) {
+        *fused = L86::Fix();
+        fused->time = _epoch;
+        fused->latitude = NAN;
+        fused->longitude = NAN;
+        fused->altitude = NAN;
+        fused->speed_knots = NAN;
+        fused->course_over_ground = NAN;
+        fused->dilution_of_precision = { NAN, NAN, NAN };
+        fused->fix_status = L86::FixStatusGGA::INVALID;
+        _fused_valid = false;
+        return;
+    }
+
+    const Receiver &reference = _receivers[this->reference(candidates, count)];
+    float north[MAX_RECEIVERS];
+    float east[MAX_RECEIVERS];
+    bool used[MAX_RECEIVERS];
+    float weights = 0.0f, mean_north = 0.0f, mean_east = 0.0f;
+    float altitude_weights = 0.0f, altitude = 0.0f;
+    float speed_weights = 0.0f, speed = 0.0f;
+    float course_north = 0.0f, course_east = 0.0f;
+    *fused = reference.fix;
+    for (int i = 0; i < count; i++) {
+        const Receiver &receiver = _receivers[candidates[i]];
+        offset(reference.fix, receiver.fix.latitude, receiver.fix.longitude, &north[i], &east[i]);
+        used[i] = consistent(hypotf(north[i], east[i]), receiver.variance, reference.variance);
+        if (!used[i]) {
+            continue;
+        }
+
+        // Positions are averaged as offsets from the reference, so that the longitude wraps
+        float weight = 1.0f / receiver.variance;
+        weights += weight;
+        mean_north += weight * north[i];
+        mean_east += weight * east[i];
+        if (!isnan(receiver.fix.altitude)) {
+            altitude_weights += weight;
+            altitude += weight * receiver.fix.altitude;
+        }
+        if (!isnan(receiver.fix.speed_knots)) {
+            speed_weights += weight;
+            speed += weight * receiver.fix.speed_knots;
+        }
+        if (!isnan(receiver.fix.course_over_ground)) {
+            course_north += weight * cosf(receiver.fix.course_over_ground * DEGREES_TO_RADIANS);
+            course_east += weight * sinf(receiver.fix.course_over_ground * DEGREES_TO_RADIANS);
+        }
+        if (receiver.fix.fix_status == L86::FixStatusGGA::DGPS_FIX
+                || (receiver.fix.fix_status == L86::FixStatusGGA::GNSS_FIX
+                        && fused->fix_status != L86::FixStatusGGA::DGPS_FIX)) {
+            fused->fix_status = receiver.fix.fix_status;
+        }
+        if (receiver.fix.satellites_used > fused->satellites_used) {
+            fused->satellites_used = receiver.fix.satellites_used;
+        }
+    }
+    mean_north /= weights;
+    mean_east /= weights;
+
+    fused->latitude = reference.fix.latitude + mean_north / METERS_PER_DEGREE;
+    float meters_per_longitude_degree
+            = METERS_PER_DEGREE * cosf(reference.fix.latitude * DEGREES_TO_RADIANS);
+    if (meters_per_longitude_degree > 1.0f) {
+        fused->longitude = reference.fix.longitude + mean_east / meters_per_longitude_degree;
+        if (fused->longitude > 180.0f) {
+            fused->longitude -= 360.0f;
+        } else if (fused->longitude <= -180.0f) {
+            fused->longitude += 360.0f;
+        }
+    }
+    fused->altitude = altitude_weights > 0.0f ? altitude / altitude_weights : NAN;
+    fused->speed_knots = speed_weights > 0.0f ? speed / speed_weights : NAN;
+    fused->course_over_ground = (course_north != 0.0f || course_east != 0.0f)
+            ? fmodf(atan2f(course_east, course_north) / DEGREES_TO_RADIANS + 360.0f, 360.0f)
+            : NAN;
+    // HDOP equivalent of the fused uncertainty
+    fused->dilution_of_precision.horizontal = sqrtf(1.0f / weights) / MBED_CONF_L86_UERE;
+
+    for (int i = 0; i < count; i++) {
+        ReceiverHealth &health = _receivers[candidates[i]].health;
+        health.offset = hypotf(north[i] - mean_north, east[i] - mean_east);
+        if (used[i]) {
+            health.health = Health::USED;
+            health.weight = 1.0f / (_receivers[candidates[i]].variance * weights);
+            health.used++;
+        } else {
+            health.health = Health::OUTLIER;
+            health.rejected++;
+        }
+    }
+
+    _fused = *fused;
+    _fused_variance = 1.0f / weights;
+    _fused_valid = true;
+}
+
+int L86FixFusion::reference(const int *candidates, int count)
+{
+    // The previous fused fix, extrapolated to the epoch, votes as an extra receiver
+    bool predicted = false;
+    float predicted_north = 0.0f, predicted_east = 0.0f;
+    if (_fused_valid
+            && _epoch - _fused.time
+                    <= std::chrono::milliseconds(MBED_CONF_L86_PREDICTION_MAX_AGE)) {
+        predicted = true;
+        float elapsed = (_epoch - _fused.time).count() / 1e6f;
+        if (!isnan(_fused.speed_knots) && !isnan(_fused.course_over_ground)) {
+            float distance = _fused.speed_knots * METERS_PER_SECOND_PER_KNOT * elapsed;
+            predicted_north = distance * cosf(_fused.course_over_ground * DEGREES_TO_RADIANS);
+            predicted_east = distance * sinf(_fused.course_over_ground * DEGREES_TO_RADIANS);
+        }
+    }
+
+    int best = candidates[0];
+    int best_score = -1;
+    for (int i = 0; i < count; i++) {
+        const Receiver &candidate = _receivers[candidates[i]];
+        int score = 0;
+        float north, east;
+        for (int j = 0; j < count; j++) {
+            const Receiver &other = _receivers[candidates[j]];
+            if (j == i) {
+                continue;
+            }
+            offset(candidate.fix, other.fix.latitude, other.fix.longitude, &north, &east);
+            if (consistent(hypotf(north, east), candidate.variance, other.variance)) {
+                score++;
+            }
+        }
+        if (predicted) {
+            offset(candidate.fix, _fused.latitude, _fused.longitude, &north, &east);
+            if (consistent(hypotf(north + predicted_north, east + predicted_east),
+                        candidate.variance,
+                        _fused_variance)) {
+                score++;
+            }
+        }
+        // Ties go to the most precise fix
+        if (score > best_score
+                || (score == best_score && candidate.variance < _receivers[best].variance)) {
+            best = candidates[i];
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+bool L86FixFusion::consistent(float distance, float variance_a, float variance_b)
+{
+    return distance <= MBED_CONF_L86_FUSION_OUTLIER_MIN_DISTANCE
+            || distance <= MBED_CONF_L86_FUSION_OUTLIER_THRESHOLD * sqrtf(variance_a + variance_b);
+}
+
+float L86FixFusion::variance(const L86::Fix &fix)
+{
+    if (fix.fix_status == L86::FixStatusGGA::INVALID || isnan(fix.latitude)
+            || isnan(fix.longitude)) {
+        return NAN;
+    }
+    // An unknown HDOP is taken as the worst accepted one
+    float hdop = fix.dilution_of_precision.horizontal;
+    if (isnan(hdop) || hdop <= 0.0f) {
+        hdop = MBED_CONF_L86_FUSION_MAX_HDOP;
+    } else if (hdop > MBED_CONF_L86_FUSION_MAX_HDOP) {
+        return NAN;
+    }
+
+    float variance = hdop * MBED_CONF_L86_UERE * hdop * MBED_CONF_L86_UERE;
+    if (fix.fix_status == L86::FixStatusGGA::DGPS_FIX) {
+        variance *= DGPS_VARIANCE_FACTOR;
+    } else if (fix.fix_status == L86::FixStatusGGA::ESTIMATED_MODE) {
+        variance *= ESTIMATED_VARIANCE_FACTOR;
+    }
+    if (fix.satellites_used > 0 && fix.satellites_used < MBED_CONF_L86_FUSION_SATELLITES) {
+        variance *= static_cast<float>(MBED_CONF_L86_FUSION_SATELLITES) / fix.satellites_used;
+    }
+    return variance;
+}
+
+void L86FixFusion::offset(
+        const L86::Fix &reference, float latitude, float longitude, float *north, float *east)
+{
+    float delta = longitude - reference.longitude;
+    if (delta > 180.0f) {
+        delta -= 360.0f;
+    } else if (delta < -180.0f) {
+        delta += 360.0f;
+    }
+    *north = (latitude - reference.latitude) * METERS_PER_DEGREE;
+    *east = delta * METERS_PER_DEGREE * cosf(reference.latitude * DEGREES_TO_RADIANS);
+}
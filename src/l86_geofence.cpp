@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_geofence.h"
+
+namespace {
+// Points are handled with doubled coordinates so that cell centers stay on integers
+typedef struct {
+    int64_t x;
+    int64_t y;
+} Point;
+
+Point doubled(const L86Geofence::Vertex &vertex)
+{
+    return { 2 * static_cast<int64_t>(vertex.longitude), 2 * static_cast<int64_t>(vertex.latitude) };
+}
+
+int64_t cross(const Point &origin, const Point &a, const Point &b)
+{
+    return (a.x - origin.x) * (b.y - origin.y) - (a.y - origin.y) * (b.x - origin.x);
+}
+
+/*!
+ *  Check if segment [a, b] crosses segment [c, d], touching points count on one side only
+ */
+bool crosses(const Point &a, const Point &b, const Point &c, const Point &d)
+{
+    if ((cross(a, b, c) >= 0) == (cross(a, b, d) >= 0)) {
+        return false;
+    }
+    return (cross(c, d, a) >= 0) != (cross(c, d, b) >= 0);
+}
+
+/*!
+ *  Crossing number point-in-polygon test
+ */
+bool contains(const L86Geofence::Polygon &polygon, const Point &point)
+{
+    bool inside = false;
+    for (uint16_t i = 0; i < polygon.vertex_count; i++) {
+        Point a = doubled(polygon.vertices[i]);
+        Point b = doubled(polygon.vertices[(i + 1) % polygon.vertex_count]);
+        if ((a.y > point.y) != (b.y > point.y)) {
+            int64_t side = (point.x - a.x) * (b.y - a.y) - (b.x - a.x) * (point.y - a.y);
+            if ((b.y > a.y) ? side < 0 : side > 0) {
+                inside = !inside;
+            }
+        }
+    }
+    return inside;
+}
+
+bool edge_overlaps(const L86Geofence::Polygon &polygon,
+        uint16_t edge,
+        int32_t min_latitude,
+        int32_t min_longitude,
+        int32_t max_latitude,
+        int32_t max_longitude)
+{
+    const L86Geofence::Vertex &a = polygon.vertices[edge];
+    const L86Geofence::Vertex &b = polygon.vertices[(edge + 1) % polygon.vertex_count];
+    return std::min(a.latitude, b.latitude) <= max_latitude
+            && std::max(a.latitude, b.latitude) >= min_latitude
+            && std::min(a.longitude, b.longitude) <= max_longitude
+            && std::max(a.longitude, b.longitude) >= min_longitude;
+}
+}
+
+bool L86Geofence::compile(const Polygon *polygons,
+        uint16_t polygon_count,
+        uint16_t rows,
+        uint16_t columns,
+        const Buffers &buffers,
+        Index *index)
+{
+    int32_t min_latitude = INT32_MAX, min_longitude = INT32_MAX;
+    int32_t max_latitude = INT32_MIN, max_longitude = INT32_MIN;
+    for (uint16_t p = 0; p < polygon_count; p++) {
+        for (uint16_t v = 0; v < polygons[p].vertex_count; v++) {
+            min_latitude = std::min(min_latitude, polygons[p].vertices[v].latitude);
+            min_longitude = std::min(min_longitude, polygons[p].vertices[v].longitude);
+            max_latitude = std::max(max_latitude, polygons[p].vertices[v].latitude);
+            max_longitude = std::max(max_longitude, polygons[p].vertices[v].longitude);
+        }
+    }
+    if (polygon_count == 0 || rows == 0 || columns == 0 || min_latitude > max_latitude) {
+        return false;
+    }
+
+    index->min_latitude = min_latitude;
+    index->min_longitude = min_longitude;
+    index->cell_height = (max_latitude - min_latitude) / rows + 1;
+    index->cell_width = (max_longitude - min_longitude) / columns + 1;
+    index->rows = rows;
+    index->columns = columns;
+    index->cell_offsets = buffers.cell_offsets;
+    index->entries = buffers.entries;
+    index->edges = buffers.edges;
+    index->polygons = polygons;
+    index->polygon_count = polygon_count;
+
+    uint32_t cell_count = static_cast<uint32_t>(rows) * columns;
+    for (uint32_t cell = 0; cell <= cell_count; cell++) {
+        buffers.cell_offsets[cell] = 0;
+    }
+
+    // First pass counts entries per cell and edges, second pass fills the index
+    for (int pass = 0; pass < 2; pass++) {
+        uint32_t edge_count = 0;
+        for (uint16_t p = 0; p < polygon_count; p++) {
+            const Polygon &polygon = polygons[p];
+            int32_t polygon_min_latitude = INT32_MAX, polygon_min_longitude = INT32_MAX;
+            int32_t polygon_max_latitude = INT32_MIN, polygon_max_longitude = INT32_MIN;
+            for (uint16_t v = 0; v < polygon.vertex_count; v++) {
+                polygon_min_latitude = std::min(polygon_min_latitude, polygon.vertices[v].latitude);
+                polygon_min_longitude
+                        = std::min(polygon_min_longitude, polygon.vertices[v].longitude);
+                polygon_max_latitude = std::max(polygon_max_latitude, polygon.vertices[v].latitude);
+                polygon_max_longitude
+                        = std::max(polygon_max_longitude, polygon.vertices[v].longitude);
+            }
+            int32_t first_row = (polygon_min_latitude - min_latitude) / index->cell_height;
+            int32_t last_row = (polygon_max_latitude - min_latitude) / index->cell_height;
+            int32_t first_column = (polygon_min_longitude - min_longitude) / index->cell_width;
+            int32_t last_column = (polygon_max_longitude - min_longitude) / index->cell_width;
+
+            for (int32_t row = first_row; row <= last_row; row++) {
+                for (int32_t column = first_column; column <= last_column; column++) {
+                    uint32_t cell = static_cast<uint32_t>(row) * columns + column;
+                    int32_t cell_min_latitude = min_latitude + row * index->cell_height;
+                    int32_t cell_min_longitude = min_longitude + column * index->cell_width;
+                    int32_t cell_max_latitude = cell_min_latitude + index->cell_height;
+                    int32_t cell_max_longitude = cell_min_longitude + index->cell_width;
+                    Point center = { 2 * static_cast<int64_t>(cell_min_longitude)
+                                + index->cell_width,
+                        2 * static_cast<int64_t>(cell_min_latitude) + index->cell_height };
+
+                    uint32_t first_edge = edge_count;
+                    for (uint16_t edge = 0; edge < polygon.vertex_count; edge++) {
+                        if (edge_overlaps(polygon,
+                                    edge,
+                                    cell_min_latitude,
+                                    cell_min_longitude,
+                                    cell_max_latitude,
+                                    cell_max_longitude)) {
+                            if (pass == 1 && edge_count < buffers.max_edges) {
+                                buffers.edges[edge_count] = edge;
+                            }
+                            edge_count++;
+                        }
+                    }
+                    bool center_inside = contains(polygon, center);
+                    if (edge_count == first_edge && !center_inside) {
+                        // The fence does not touch this cell
+                        continue;
+                    }
+                    if (pass == 0) {
+                        buffers.cell_offsets[cell + 1]++;
+                    } else {
+                        // cell_offsets[cell + 1] is the fill cursor of the cell
+                        uint32_t entry = buffers.cell_offsets[cell + 1]++;
+                        if (entry < buffers.max_entries) {
+                            buffers.entries[entry]
+                                    = { p, center_inside, first_edge, edge_count - first_edge };
+                        }
+                    }
+                }
+            }
+        }
+        index->edge_count = edge_count;
+
+        if (pass == 0) {
+            // Exclusive prefix sum, shifted by one cell to be used as fill cursors
+            uint32_t total = 0;
+            for (uint32_t cell = 0; cell < cell_count; cell++) {
+                uint32_t count = buffers.cell_offsets[cell + 1];
+                buffers.cell_offsets[cell + 1] = total;
+                total += count;
+            }
+            index->entry_count = total;
+            if (total > buffers.max_entries || edge_count > buffers.max_edges) {
+                return false;
+            }
+        }
+    }
+    // After filling, cell_offsets[cell + 1] is the end of the cell, i.e. the next cell start
+    buffers.cell_offsets[0] = 0;
+    return true;
+}
+
+L86Geofence::L86Geofence(const Index *index)
+{
+    _index = index;
+    _presence_count = 0;
+    _last_cell = -1;
+    _overflows = 0;
+}
+
+void L86Geofence::attach(Callback<void(const Event &)> func)
+{
+    _callback = func;
+}
+
+void L86Geofence::process(const L86::Fix &fix)
+{
+    // A fix lost keeps the last position, which must not cross fences
+    if (fix.fix_status == L86::FixStatusGGA::INVALID || isnan(fix.latitude)
+            || isnan(fix.longitude)) {
+        return;
+    }
+    int32_t latitude = static_cast<int32_t>(lroundf(fix.latitude * 1e6f));
+    int32_t longitude = static_cast<int32_t>(lroundf(fix.longitude * 1e6f));
+    int32_t cell = locate(latitude, longitude);
+
+    // Same cell without fence edge: the fences containing the fix did not change
+    if (cell == _last_cell && (cell < 0 || !cell_has_edges(cell))) {
+        check_dwell(fix.time);
+        return;
+    }
+    _last_cell = cell;
+
+    uint16_t inside[MAX_INSIDE];
+    int inside_count = 0;
+    if (cell >= 0) {
+        Point point = { 2 * static_cast<int64_t>(longitude), 2 * static_cast<int64_t>(latitude) };
+        int32_t row = cell / _index->columns;
+        int32_t column = cell % _index->columns;
+        Point center = { 2 * (static_cast<int64_t>(_index->min_longitude)
+                                 + static_cast<int64_t>(column) * _index->cell_width)
+                    + _index->cell_width,
+            2 * (static_cast<int64_t>(_index->min_latitude)
+                    + static_cast<int64_t>(row) * _index->cell_height)
+                    + _index->cell_height };
+
+        for (uint32_t e = _index->cell_offsets[cell]; e < _index->cell_offsets[cell + 1]; e++) {
+            const CellEntry &entry = _index->entries[e];
+            const Polygon &polygon = _index->polygons[entry.fence];
+            bool is_inside = entry.center_inside;
+            for (uint32_t i = 0; i < entry.edge_count; i++) {
+                uint16_t edge = _index->edges[entry.first_edge + i];
+                if (crosses(center,
+                            point,
+                            doubled(polygon.vertices[edge]),
+                            doubled(polygon.vertices[(edge + 1) % polygon.vertex_count]))) {
+                    is_inside = !is_inside;
+                }
+            }
+            if (is_inside) {
+                if (inside_count < MAX_INSIDE) {
+                    inside[inside_count++] = entry.fence;
+                } else {
+                    _overflows++;
+                }
+            }
+        }
+    }
+
+    // Exits
+    for (int i = 0; i < _presence_count;) {
+        bool still_inside = false;
+        for (int j = 0; j < inside_count && !still_inside; j++) {
+            still_inside = inside[j] == _presences[i].fence;
+        }
+        if (still_inside) {
+            i++;
+            continue;
+        }
+        uint16_t fence = _presences[i].fence;
+        _presences[i] = _presences[--_presence_count];
+        emit(EventType::EXIT, fence, fix.time);
+    }
+
+    // Entries
+    for (int j = 0; j < inside_count; j++) {
+        bool known = false;
+        for (int i = 0; i < _presence_count && !known; i++) {
+            known = _presences[i].fence == inside[j];
+        }
+        if (!known) {
+            _presences[_presence_count++] = { inside[j], false, fix.time };
+            emit(EventType::ENTER, inside[j], fix.time);
+        }
+    }
+
+    check_dwell(fix.time);
+}
+
+bool L86Geofence::inside(uint16_t fence)
+{
+    for (int i = 0; i < _presence_count; i++) {
+        if (_presences[i].fence == fence) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t L86Geofence::overflows()
+{
+    return _overflows;
+}
+
+int32_t L86Geofence::locate(int32_t latitude, int32_t longitude)
+{
+    int64_t row = (static_cast<int64_t>(latitude) - _index->min_latitude);
+    int64_t column = (static_cast<int64_t>(longitude) - _index->min_longitude);
+    if (row < 0 || column < 0) {
+        return -1;
+    }
+    row /= _index->cell_height;
+    column /= _index->cell_width;
+    if (row >= _index->rows || column >= _index->columns) {
+        return -1;
+    }
+    return static_cast<int32_t>(row * _index->columns + column);
+}
+
+bool L86Geofence::cell_has_edges(int32_t cell)
+{
+    for (uint32_t e = _index->cell_offsets[cell]; e < _index->cell_offsets[cell + 1]; e++) {
+        if (_index->entries[e].edge_count != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void L86Geofence::emit(EventType type, uint16_t fence, std::chrono::microseconds time)
+{
+    if (_callback) {
+        Event event = { type, fence, time };
+        _callback(event);
+    }
+}
+
+void L86Geofence::check_dwell(std::chrono::microseconds time)
+{
+    for (int i = 0; i < _presence_count; i++) {
+        uint16_t dwell_time = _index->polygons[_presences[i].fence].dwell_time;
+        if (dwell_time != 0 && !_presences[i].dwell_reported
+                && time - _presences[i].enter_time >= std::chrono::seconds(dwell_time)) {
+            _presences[i].dwell_reported = true;
+            emit(EventType::DWELL, _presences[i].fence, time);
+        }
+    }
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_odometer.h"
+
+namespace {
+constexpr uint32_t MILLIMETERS_PER_DEGREE = 111195000; //!< Mean length of a latitude degree
+constexpr int32_t MICRODEGREES = 1000000;
+constexpr int64_t SHORT_STEP = 1 << 16; //!< Max step in Q15 microdegrees, in microdegrees
+
+//! cos(n degrees) in Q15, for n from 0 to 90
+const uint16_t COSINE_TABLE[91] = {
+    32767, 32762, 32747, 32722, 32687, 32642, 32587, 32523, 32448, 32364,
+    32269, 32165, 32051, 31927, 31794, 31650, 31498, 31335, 31163, 30982,
+    30791, 30591, 30381, 30162, 29934, 29697, 29451, 29196, 28932, 28659,
+    28377, 28087, 27788, 27481, 27165, 26841, 26509, 26169, 25821, 25465,
+    25101, 24730, 24351, 23964, 23571, 23170, 22762, 22347, 21925, 21497,
+    21062, 20621, 20173, 19720, 19260, 18794, 18323, 17846, 17364, 16876,
+    16384, 15886, 15383, 14876, 14364, 13848, 13328, 12803, 12275, 11743,
+    11207, 10668, 10126, 9580, 9032, 8481, 7927, 7371, 6813, 6252,
+    5690, 5126, 4560, 3993, 3425, 2856, 2286, 1715, 1144, 572,
+    0,
+};
+
+/*!
+ *  cos(latitude) in Q15, linearly interpolated in the lookup table
+ */
+uint32_t cosine(int32_t latitude)
+{
+    uint32_t absolute = latitude < 0 ? -latitude : latitude;
+    uint32_t degree = absolute / MICRODEGREES;
+    if (degree >= 90) {
+        return 0;
+    }
+    uint32_t fraction = absolute % MICRODEGREES;
+    uint32_t low = COSINE_TABLE[degree];
+    uint32_t high = COSINE_TABLE[degree + 1];
+    return low - static_cast<uint32_t>((static_cast<uint64_t>(low - high) * fraction) / MICRODEGREES);
+}
+
+uint32_t square_root(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return static_cast<uint32_t>(root);
+}
+}
+
+L86Odometer::L86Odometer(float min_speed, float max_hdop)
+{
+    _min_speed = min_speed;
+    _max_hdop = max_hdop;
+    _anchored = false;
+    _anchor_latitude = 0;
+    _anchor_longitude = 0;
+    _total = 0;
+    _trip = 0;
+}
+
+uint32_t L86Odometer::distance(
+        int32_t latitude_a, int32_t longitude_a, int32_t latitude_b, int32_t longitude_b)
+{
+    int64_t delta_latitude = static_cast<int64_t>(latitude_b) - latitude_a;
+    int64_t delta_longitude = static_cast<int64_t>(longitude_b) - longitude_a;
+    if (delta_longitude > 180 * MICRODEGREES) {
+        delta_longitude -= 360 * MICRODEGREES;
+    } else if (delta_longitude < -180 * MICRODEGREES) {
+        delta_longitude += 360 * MICRODEGREES;
+    }
+    int32_t mean_latitude = static_cast<int32_t>((static_cast<int64_t>(latitude_a) + latitude_b) / 2);
+
+    // Steps below 0.065 degree keep 15 fraction bits, so that the microdegree truncations do
+    // not bias the sum of the steps
+    if (delta_latitude > -SHORT_STEP && delta_latitude < SHORT_STEP
+            && delta_longitude > -SHORT_STEP && delta_longitude < SHORT_STEP) {
+        int64_t north = delta_latitude * 32768;
+        int64_t east = delta_longitude * cosine(mean_latitude);
+        uint64_t root = square_root(static_cast<uint64_t>(north * north)
+                + static_cast<uint64_t>(east * east));
+        return static_cast<uint32_t>(
+                (root * MILLIMETERS_PER_DEGREE / MICRODEGREES + (1 << 14)) >> 15);
+    }
+
+    delta_longitude = (delta_longitude * cosine(mean_latitude)) >> 15;
+
+    uint64_t microdegrees = square_root(static_cast<uint64_t>(delta_latitude * delta_latitude)
+            + static_cast<uint64_t>(delta_longitude * delta_longitude));
+    return static_cast<uint32_t>(microdegrees * MILLIMETERS_PER_DEGREE / MICRODEGREES);
+}
+
+void L86Odometer::process(const L86::Fix &fix)
+{
+    if (fix.fix_status == L86::FixStatusGGA::INVALID || isnan(fix.latitude)
+            || isnan(fix.longitude)) {
+        return;
+    }
+    float hdop = fix.dilution_of_precision.horizontal;
+    if (!isnan(hdop) && hdop > _max_hdop) {
+        return;
+    }
+    int32_t latitude = static_cast<int32_t>(lroundf(fix.latitude * MICRODEGREES));
+    int32_t longitude = static_cast<int32_t>(lroundf(fix.longitude * MICRODEGREES));
+    if (!_anchored) {
+        _anchor_latitude = latitude;
+        _anchor_longitude = longitude;
+        _anchored = true;
+        return;
+    }
+    // Stationary: keep the anchor so that jitter is not integrated
+    if (isnan(fix.speed_knots) || fix.speed_knots < _min_speed) {
+        return;
+    }
+    uint32_t millimeters = distance(_anchor_latitude, _anchor_longitude, latitude, longitude);
+    _total += millimeters;
+    _trip += millimeters;
+    _anchor_latitude = latitude;
+    _anchor_longitude = longitude;
+}
+
+uint32_t L86Odometer::total_distance()
+{
+    return static_cast<uint32_t>(_total / 1000);
+}
+
+uint32_t L86Odometer::trip_distance()
+{
+    return static_cast<uint32_t>(_trip / 1000);
+}
+
+void L86Odometer::reset_trip()
+{
+    _trip = 0;
+}
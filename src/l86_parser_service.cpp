@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_parser_service.h"
+
+L86ParserService::L86ParserService(osPriority priority, uint32_t stack_size):
+        _thread(priority, stack_size, nullptr, "l86_parser")
+{
+    _next_instance = 0;
+    for (int i = 0; i < MAX_INSTANCES; i++) {
+        _instances[i] = nullptr;
+        _stats[i] = { 0, 0, 0, 0 };
+    }
+}
+
+bool L86ParserService::start()
+{
+    return _thread.start(callback(this, &L86ParserService::run)) == osOK;
+}
+
+bool L86ParserService::add(L86 *l86)
+{
+    _mutex.lock();
+    int slot = find(l86);
+    if (slot < 0) {
+        slot = find(nullptr);
+    }
+    if (slot < 0) {
+        _mutex.unlock();
+        return false;
+    }
+    _instances[slot] = l86;
+    _stats[slot] = { 0, 0, 0, 0 };
+    l86->_rx_buffer.reset();
+#if MBED_CONF_L86_LATENCY_TRACE_ENABLED
+    l86->_arrival_times.reset();
+    l86->_arrival_times_missing = 0;
+#endif
+    l86->_rx_overflows = 0;
+    l86->_parser_service = this;
+    l86->start_receive();
+    _mutex.unlock();
+    return true;
+}
+
+bool L86ParserService::remove(L86 *l86)
+{
+    _mutex.lock();
+    int slot = find(l86);
+    if (slot < 0) {
+        _mutex.unlock();
+        return false;
+    }
+    l86->_parser_service = nullptr;
+    l86->start_receive();
+    _instances[slot] = nullptr;
+    _mutex.unlock();
+    return true;
+}
+
+L86ParserService::InstanceStats L86ParserService::stats(L86 *l86)
+{
+    InstanceStats stats = { 0, 0, 0, 0 };
+    _mutex.lock();
+    int slot = find(l86);
+    if (slot >= 0) {
+        stats = _stats[slot];
+        stats.rx_overflows = l86->_rx_overflows;
+    }
+    _mutex.unlock();
+    return stats;
+}
+
+void L86ParserService::notify()
+{
+    _flags.set(DATA_AVAILABLE_FLAG);
+}
+
+int L86ParserService::find(L86 *l86)
+{
+    for (int i = 0; i < MAX_INSTANCES; i++) {
+        if (_instances[i] == l86) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void L86ParserService::drain()
+{
+    bool pending = true;
+    while (pending) {
+        pending = false;
+        _mutex.lock();
+        // Rotate the first served module so that none of them is always served last
+        int first = _next_instance;
+        _next_instance = (_next_instance + 1) % MAX_INSTANCES;
+        for (int n = 0; n < MAX_INSTANCES; n++) {
+            int i = (first + n) % MAX_INSTANCES;
+            L86 *l86 = _instances[i];
+            if (l86 == nullptr) {
+                continue;
+            }
+            uint32_t backlog = l86->_rx_buffer.size();
+            if (backlog > _stats[i].max_backlog) {
+                _stats[i].max_backlog = backlog;
+            }
+            _stats[i].bytes_parsed += l86->process_received_bytes(
+                    MBED_CONF_L86_PARSER_SERVICE_QUANTUM, &_stats[i].sentences_parsed);
+            if (!l86->_rx_buffer.empty()) {
+                pending = true;
+            }
+        }
+        _mutex.unlock();
+    }
+}
+
+void L86ParserService::run()
+{
+    while (true) {
+        _flags.wait_any(DATA_AVAILABLE_FLAG);
+        drain();
+    }
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_rate_control.h"
+
+namespace {
+/* Usual length of the sentences of a fix, in bytes, by NmeaCommandType (GSV: GPS and GLONASS) */
+constexpr uint32_t SENTENCE_BYTES[NMEA_COMMANDS_COUNT] = { 72, 40, 80, 68, 280, 52 };
+constexpr uint32_t BITS_PER_BYTE = 10; //!< Start, 8 data and stop bits
+constexpr uint32_t MAX_LINK_LOAD = 80; //!< Share of the fix interval used by the output, in %
+constexpr uint32_t INTERVAL_STEP = 100; //!< Fix interval granularity, in ms
+}
+
+L86RateController::L86RateController(L86 *l86, const L86::NmeaOutput &output, int baudrate)
+{
+    _l86 = l86;
+    _output = output;
+
+    // Serial time of the throttled fast output, rounded up to the interval granularity
+    L86::NmeaOutput fast_output = output;
+    throttle(Level::FAST, &fast_output);
+    uint32_t bits = 0;
+    for (int i = 0; i < NMEA_COMMANDS_COUNT; i++) {
+        if (fast_output.frequencies[i] != 0) {
+            bits += SENTENCE_BYTES[i] * BITS_PER_BYTE / fast_output.frequencies[i];
+        }
+    }
+    uint32_t link_interval = baudrate > 0 ? bits * 1000 * 100 / MAX_LINK_LOAD / baudrate
+                                          : MBED_CONF_L86_RATE_NORMAL_INTERVAL;
+    link_interval = (link_interval + INTERVAL_STEP - 1) / INTERVAL_STEP * INTERVAL_STEP;
+    _fast_interval = MBED_CONF_L86_RATE_FAST_INTERVAL;
+    if (link_interval > _fast_interval) {
+        _fast_interval = link_interval < MBED_CONF_L86_RATE_NORMAL_INTERVAL
+                ? link_interval
+                : MBED_CONF_L86_RATE_NORMAL_INTERVAL;
+    }
+    _level = Level::NORMAL;
+    _pending_level = Level::NORMAL;
+    _switching = false;
+    _dirty = false;
+    _switches = 0;
+    _last_fix_time = std::chrono::microseconds(0);
+    _last_course = NAN;
+    _slow_since = std::chrono::microseconds(0);
+    _stationary_since = std::chrono::microseconds(0);
+}
+
+void L86RateController::process(const L86::Fix &fix)
+{
+    // Sentences of a same epoch publish the same fix
+    if (fix.time == _last_fix_time) {
+        return;
+    }
+    float course_rate = 0.0f;
+    if (!isnan(_last_course) && !isnan(fix.course_over_ground) && fix.time > _last_fix_time) {
+        float delta = fabsf(fix.course_over_ground - _last_course);
+        if (delta > 180.0f) {
+            delta = 360.0f - delta;
+        }
+        course_rate = delta * 1e6f / (fix.time - _last_fix_time).count();
+    }
+    _last_fix_time = fix.time;
+    // The course of a parked receiver is noise
+    _last_course = fix.speed_knots >= MBED_CONF_L86_RATE_MOVING_SPEED ? fix.course_over_ground
+                                                                       : NAN;
+
+    Level target = evaluate(fix, course_rate);
+    update();
+    if (!_switching && (target != _level || _dirty)) {
+        configure(target);
+    }
+}
+
+L86RateController::Level L86RateController::level()
+{
+    return _level;
+}
+
+uint32_t L86RateController::switches()
+{
+    return _switches;
+}
+
+uint16_t L86RateController::fast_interval()
+{
+    return _fast_interval;
+}
+
+L86RateController::Level L86RateController::evaluate(const L86::Fix &fix, float course_rate)
+{
+    if (fix.fix_status == L86::FixStatusGGA::INVALID || isnan(fix.speed_knots)) {
+        _slow_since = std::chrono::microseconds(0);
+        _stationary_since = std::chrono::microseconds(0);
+        return Level::NORMAL;
+    }
+
+    if (fix.speed_knots >= MBED_CONF_L86_RATE_FAST_SPEED
+            || course_rate >= MBED_CONF_L86_RATE_FAST_COURSE_RATE) {
+        _slow_since = std::chrono::microseconds(0);
+        _stationary_since = std::chrono::microseconds(0);
+        return Level::FAST;
+    }
+
+    Level target = _level;
+    if (_level == Level::FAST) {
+        if (fix.speed_knots >= MBED_CONF_L86_RATE_SLOW_SPEED
+                || course_rate >= MBED_CONF_L86_RATE_SLOW_COURSE_RATE) {
+            _slow_since = std::chrono::microseconds(0);
+        } else if (_slow_since.count() == 0) {
+            _slow_since = fix.time;
+        } else if (fix.time - _slow_since
+                >= std::chrono::milliseconds(MBED_CONF_L86_RATE_HOLD_TIME)) {
+            target = Level::NORMAL;
+        }
+    }
+
+    if (fix.speed_knots < MBED_CONF_L86_RATE_STATIONARY_SPEED) {
+        if (_stationary_since.count() == 0) {
+            _stationary_since = fix.time;
+        } else if (fix.time - _stationary_since
+                >= std::chrono::milliseconds(MBED_CONF_L86_RATE_STATIONARY_TIME)) {
+            target = Level::STATIONARY;
+        }
+    } else {
+        _stationary_since = std::chrono::microseconds(0);
+        if (_level == Level::STATIONARY && fix.speed_knots >= MBED_CONF_L86_RATE_MOVING_SPEED) {
+            target = Level::NORMAL;
+        }
+    }
+    return target;
+}
+
+void L86RateController::update()
+{
+    if (!_switching || !_interval_future.ready() || !_output_future.ready()) {
+        return;
+    }
+    _switching = false;
+    if ((!_interval_future.valid()
+                || _interval_future.status() == L86::CommandStatus::SUCCEEDED)
+            && (!_output_future.valid()
+                    || _output_future.status() == L86::CommandStatus::SUCCEEDED)) {
+        _level = _pending_level;
+        _dirty = false;
+        _switches++;
+    } else {
+        // One setting may have been applied: both are sent again on the next fix
+        _dirty = true;
+    }
+}
+
+void L86RateController::configure(Level level)
+{
+    L86::NmeaOutput output = _output;
+    L86::NmeaOutput current = _output;
+    throttle(level, &output);
+    throttle(_level, &current);
+    bool send_output = _dirty || memcmp(&output, &current, sizeof(output)) != 0;
+    bool send_interval = _dirty || interval(level) != interval(_level);
+
+    // Unchanged settings are not sent, their future stays invalid
+    _interval_future = L86::CommandFuture();
+    _output_future = L86::CommandFuture();
+    // Throttle the output before raising the rate, and lower the rate before restoring it
+    if (send_output && interval(level) < interval(_level)) {
+        _output_future = _l86->set_nmea_output_async(output);
+    }
+    if (send_interval) {
+        _interval_future = _l86->set_position_fix_interval_async(interval(level));
+    }
+    if (send_output && interval(level) >= interval(_level)) {
+        _output_future = _l86->set_nmea_output_async(output);
+    }
+
+    // On a full command queue, the level is configured again on the next fix, with both settings
+    // if one of them was queued
+    _pending_level = level;
+    _switching = (!send_interval || _interval_future.valid())
+            && (!send_output || _output_future.valid());
+    if (!_switching && (_interval_future.valid() || _output_future.valid())) {
+        _dirty = true;
+    }
+}
+
+void L86RateController::throttle(Level level, L86::NmeaOutput *output)
+{
+    uint8_t &gsa = output->frequencies[static_cast<size_t>(L86::NmeaCommandType::GSA)];
+    uint8_t &gsv = output->frequencies[static_cast<size_t>(L86::NmeaCommandType::GSV)];
+    if (level == Level::FAST && gsa != 0) {
+        gsa = MBED_CONF_L86_RATE_THROTTLED_FREQUENCY;
+    }
+    if (level != Level::NORMAL && gsv != 0) {
+        gsv = MBED_CONF_L86_RATE_THROTTLED_FREQUENCY;
+    }
+}
+
+uint16_t L86RateController::interval(Level level)
+{
+    switch (level) {
+        case Level::FAST:
+            return _fast_interval;
+        case Level::STATIONARY:
+            return MBED_CONF_L86_RATE_STATIONARY_INTERVAL;
+        default:
+            return MBED_CONF_L86_RATE_NORMAL_INTERVAL;
+    }
+}
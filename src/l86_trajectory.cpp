@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_trajectory.h"
+
+namespace {
+constexpr float METERS_PER_DEGREE = 111195.0f; //!< Mean length of a latitude degree
+constexpr float DEGREES_TO_RADIANS = 0.0174532925f;
+constexpr float MIN_COURSE_SPEED = 1.0f; //!< Course is meaningless below this speed, in knots
+
+float cross(float ax, float ay, float bx, float by)
+{
+    return ax * by - ay * bx;
+}
+}
+
+L86TrajectoryCompressor::L86TrajectoryCompressor(
+        float max_error, float max_course_change, float max_speed_change)
+{
+    _max_error = max_error;
+    _max_course_change = max_course_change;
+    _max_speed_change = max_speed_change;
+    _anchored = false;
+    _has_candidate = false;
+    _processed_count = 0;
+    _kept_count = 0;
+}
+
+void L86TrajectoryCompressor::attach(Callback<void(const L86::Fix &)> func)
+{
+    _callback = func;
+}
+
+void L86TrajectoryCompressor::process(const L86::Fix &fix)
+{
+    if (fix.fix_status == L86::FixStatusGGA::INVALID || isnan(fix.latitude)
+            || isnan(fix.longitude)) {
+        return;
+    }
+    _processed_count++;
+    if (!_anchored) {
+        keep(fix);
+        return;
+    }
+    if (extends_segment(fix)) {
+        return;
+    }
+    // End the segment at the last fix which could extend it, and restart from there
+    if (_has_candidate) {
+        keep(_candidate);
+        if (extends_segment(fix)) {
+            return;
+        }
+    }
+    keep(fix);
+}
+
+void L86TrajectoryCompressor::flush()
+{
+    if (_has_candidate) {
+        keep(_candidate);
+    }
+}
+
+uint32_t L86TrajectoryCompressor::processed_count()
+{
+    return _processed_count;
+}
+
+uint32_t L86TrajectoryCompressor::kept_count()
+{
+    return _kept_count;
+}
+
+void L86TrajectoryCompressor::keep(const L86::Fix &fix)
+{
+    _anchor = fix;
+    _anchored = true;
+    _has_candidate = false;
+    _cone_set = false;
+    _cone_empty = false;
+    _max_distance = 0.0f;
+    _meters_per_longitude_degree = METERS_PER_DEGREE * cosf(fix.latitude * DEGREES_TO_RADIANS);
+    _kept_count++;
+    if (_callback) {
+        _callback(fix);
+    }
+}
+
+bool L86TrajectoryCompressor::extends_segment(const L86::Fix &fix)
+{
+    if (fabsf(fix.speed_knots - _anchor.speed_knots) > _max_speed_change) {
+        return false;
+    }
+    if (fix.speed_knots >= MIN_COURSE_SPEED && _anchor.speed_knots >= MIN_COURSE_SPEED) {
+        float course_change = fabsf(fix.course_over_ground - _anchor.course_over_ground);
+        if (course_change > 180.0f) {
+            course_change = 360.0f - course_change;
+        }
+        if (course_change > _max_course_change) {
+            return false;
+        }
+    }
+
+    float x = (fix.longitude - _anchor.longitude) * _meters_per_longitude_degree;
+    float y = (fix.latitude - _anchor.latitude) * METERS_PER_DEGREE;
+    float distance = sqrtf(x * x + y * y);
+
+    // Fixes kept out of the segment must project inside it
+    if (_max_distance > _max_error && distance < _max_distance) {
+        return false;
+    }
+    // Close to the anchor: within the error of any segment starting from it
+    if (distance <= _max_error) {
+        _candidate = fix;
+        _has_candidate = true;
+        return true;
+    }
+    float ux = x / distance;
+    float uy = y / distance;
+    if (_cone_set
+            && (_cone_empty || cross(_lower_x, _lower_y, ux, uy) < 0.0f
+                    || cross(ux, uy, _upper_x, _upper_y) < 0.0f)) {
+        return false;
+    }
+
+    // Directions keeping this fix within the max error, intersected with the current cone
+    float sine = _max_error / distance;
+    float cosine = sqrtf(1.0f - sine * sine);
+    float lower_x = ux * cosine + uy * sine;
+    float lower_y = uy * cosine - ux * sine;
+    float upper_x = ux * cosine - uy * sine;
+    float upper_y = uy * cosine + ux * sine;
+    if (!_cone_set) {
+        _lower_x = lower_x;
+        _lower_y = lower_y;
+        _upper_x = upper_x;
+        _upper_y = upper_y;
+        _cone_set = true;
+    } else {
+        if (cross(_lower_x, _lower_y, lower_x, lower_y) > 0.0f) {
+            _lower_x = lower_x;
+            _lower_y = lower_y;
+        }
+        if (cross(_upper_x, _upper_y, upper_x, upper_y) < 0.0f) {
+            _upper_x = upper_x;
+            _upper_y = upper_y;
+        }
+        _cone_empty = cross(_lower_x, _lower_y, _upper_x, _upper_y) < 0.0f;
+    }
+    _max_distance = distance;
+    _candidate = fix;
+    _has_candidate = true;
+    return true;
+}
@@ -386,6 +386,11 @@ enum minmea_sentence_id minmea_sentence_id(const char *sentence, bool strict)
         return MINMEA_INVALID;
     }
 
+    return minmea_sentence_type(sentence);
+}
+
+enum minmea_sentence_id minmea_sentence_type(const char *sentence)
+{
     char type[8];
     if (!minmea_scan(sentence, "t", type)) {
         return MINMEA_INVALID;
@@ -418,6 +423,21 @@ enum minmea_sentence_id minmea_sentence_id(const char *sentence, bool strict)
     if (!strcmp(type, "PMTK001")) {
         return MINMEA_SENTENCE_PMTK_ACK;
     }
+    if (!strcmp(type, "PMTK707")) {
+        return MINMEA_SENTENCE_PMTK_EPO_INFO;
+    }
+    if (!strcmp(type, "PMTK500")) {
+        return MINMEA_SENTENCE_PMTK_FIX_CTL;
+    }
+    if (!strcmp(type, "PMTK514")) {
+        return MINMEA_SENTENCE_PMTK_NMEA_OUTPUT;
+    }
+    if (!strcmp(type, "PMTK705")) {
+        return MINMEA_SENTENCE_PMTK_RELEASE;
+    }
+    if (!strcmp(type, "PMTK010")) {
+        return MINMEA_SENTENCE_PMTK_SYSTEM_MESSAGE;
+    }
 
     return MINMEA_UNKNOWN;
 }
@@ -436,6 +456,132 @@ bool minmea_parse_pmtk_ack(struct minmea_sentence_pmtk_ack *frame, const char *s
     return true;
 }
 
+bool minmea_parse_pmtk_epo_info(struct minmea_sentence_pmtk_epo_info *frame, const char *sentence)
+{
+    // $PMTK707,56,1468,172800,1470,151200,1468,259200,1468,259200*1F
+    char type[8];
+    if (!minmea_scan(sentence,
+                "tiiiiiiiii",
+                type,
+                &frame->sets,
+                &frame->first_week,
+                &frame->first_tow,
+                &frame->last_week,
+                &frame->last_tow,
+                &frame->first_current_week,
+                &frame->first_current_tow,
+                &frame->last_current_week,
+                &frame->last_current_tow)) {
+        return false;
+    }
+    if (strcmp(type, "PMTK707")) {
+        return false;
+    }
+
+    return true;
+}
+
+bool minmea_parse_pmtk_fix_ctl(struct minmea_sentence_pmtk_fix_ctl *frame, const char *sentence)
+{
+    // $PMTK500,1000,0,0,0.0,0.0*1A
+    char type[8];
+    if (!minmea_scan(sentence, "ti", type, &frame->fix_interval)) {
+        return false;
+    }
+    if (strcmp(type, "PMTK500")) {
+        return false;
+    }
+
+    return true;
+}
+
+bool minmea_parse_pmtk_nmea_output(
+        struct minmea_sentence_pmtk_nmea_output *frame, const char *sentence)
+{
+    // $PMTK514,0,1,1,1,1,5,0,0,0,0,0,0,0,0,0,0,0,0,0*2B
+    char type[8];
+    if (!minmea_scan(sentence,
+                "tiiiiii",
+                type,
+                &frame->frequencies[MINMEA_GLL_FREQUENCY],
+                &frame->frequencies[MINMEA_RMC_FREQUENCY],
+                &frame->frequencies[MINMEA_VTG_FREQUENCY],
+                &frame->frequencies[MINMEA_GGA_FREQUENCY],
+                &frame->frequencies[MINMEA_GSA_FREQUENCY],
+                &frame->frequencies[MINMEA_GSV_FREQUENCY])) {
+        return false;
+    }
+    if (strcmp(type, "PMTK514")) {
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Copy a string field, truncated to the destination size. Returns the next field, or NULL
+ * after the last one.
+ */
+static const char *minmea_copy_field(char *buffer, size_t size, const char *field)
+{
+    size_t len = 0;
+    while (minmea_isfield(*field)) {
+        if (len + 1 < size) {
+            buffer[len++] = *field;
+        }
+        field++;
+    }
+    buffer[len] = '\0';
+
+    return *field == ',' ? field + 1 : NULL;
+}
+
+bool minmea_parse_pmtk_release(struct minmea_sentence_pmtk_release *frame, const char *sentence)
+{
+    // $PMTK705,AXN_3.8_3333_1703091820,0001,L86-M33,1.0*6F
+    char type[8];
+    if (!minmea_scan(sentence, "t", type)) {
+        return false;
+    }
+    if (strcmp(type, "PMTK705")) {
+        return false;
+    }
+
+    // The fields are longer than the minmea_scan() strings can safely take
+    const char *field = strchr(sentence, ',');
+    if (!field) {
+        return false;
+    }
+    field = minmea_copy_field(frame->release, sizeof(frame->release), field + 1);
+    frame->build_id[0] = '\0';
+    frame->product_model[0] = '\0';
+    if (field) {
+        field = minmea_copy_field(frame->build_id, sizeof(frame->build_id), field);
+    }
+    if (field) {
+        minmea_copy_field(frame->product_model, sizeof(frame->product_model), field);
+    }
+
+    return true;
+}
+
+bool minmea_parse_pmtk_system_message(
+        struct minmea_sentence_pmtk_system_message *frame, const char *sentence)
+{
+    // $PMTK010,001*2E
+    char type[8];
+    int message;
+    if (!minmea_scan(sentence, "ti", type, &message)) {
+        return false;
+    }
+    if (strcmp(type, "PMTK010")) {
+        return false;
+    }
+    frame->message = (enum minmea_pmtk_system_message_type)message;
+
+    return true;
+}
+
 bool minmea_parse_rmc(struct minmea_sentence_rmc *frame, const char *sentence)
 {
     // $GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*62
@@ -700,9 +846,88 @@ bool minmea_parse_zda(struct minmea_sentence_zda *frame, const char *sentence)
 
 void minmea_serialize_pmtk(struct minmea_sentence_pmtk pmtk_message, char *buffer)
 {
+    static const char hex_digits[] = "0123456789ABCDEF";
     char *append = buffer;
-    append += sprintf(append, "$PMTK%03i,%s*", pmtk_message.type, pmtk_message.parameters);
-    append += sprintf(append, "%02X\r\n", minmea_checksum(buffer));
+    *append++ = '$';
+    memcpy(append, "PMTK", 4);
+    append = minmea_format_int(append + 4, pmtk_message.type, 3);
+    if (pmtk_message.parameters[0] != '\0') {
+        *append++ = ',';
+        strcpy(append, pmtk_message.parameters);
+        append += strlen(append);
+    }
+    *append = '\0';
+    uint8_t checksum = minmea_checksum(buffer);
+    *append++ = '*';
+    *append++ = hex_digits[checksum >> 4];
+    *append++ = hex_digits[checksum & 0x0F];
+    *append++ = '\r';
+    *append++ = '\n';
+    *append = '\0';
+}
+
+char *minmea_format_int(char *buffer, long value, int width)
+{
+    char digits[12];
+    int count = 0;
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+    do {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) {
+        width--;
+    }
+    while (count < width && count < (int)sizeof(digits)) {
+        digits[count++] = '0';
+    }
+
+    if (value < 0) {
+        *buffer++ = '-';
+    }
+    while (count > 0) {
+        *buffer++ = digits[--count];
+    }
+    *buffer = '\0';
+    return buffer;
+}
+
+char *minmea_format_float(char *buffer, float value, int decimals)
+{
+    long scale = 1;
+    for (int i = 0; i < decimals; i++) {
+        scale *= 10;
+    }
+    // Split first so that the fraction scaling keeps the float precision
+    float magnitude = fabsf(value);
+    long integer = (long)magnitude;
+    long fraction = (long)((magnitude - integer) * scale + 0.5f);
+    if (fraction >= scale) {
+        integer++;
+        fraction -= scale;
+    }
+
+    if (value < 0 && (integer != 0 || fraction != 0)) {
+        *buffer++ = '-';
+    }
+    buffer = minmea_format_int(buffer, integer, 0);
+    if (decimals > 0) {
+        *buffer++ = '.';
+        buffer = minmea_format_int(buffer, fraction, decimals);
+    }
+    return buffer;
+}
+
+/* Replaces timegm(), which is missing from many embedded C libraries */
+long minmea_days_from_civil(long year, unsigned month, unsigned day)
+{
+    year -= month <= 2;
+    const long era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned long year_of_era = (unsigned long)(year - era * 400);
+    const unsigned long day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned long day_of_era
+            = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + (long)day_of_era - 719468;
 }
 
 int minmea_gettime(
@@ -712,27 +937,17 @@ int minmea_gettime(
         return -1;
     }
 
-    struct tm tm;
-    memset(&tm, 0, sizeof(tm));
+    long year;
     if (date->year < 80) {
-        tm.tm_year = 2000 + date->year - 1900; // 2000-2079
+        year = 2000 + date->year; // 2000-2079
     } else if (date->year >= 1900) {
-        tm.tm_year = date->year - 1900; // 4 digit year, use directly
-    } else {
-        tm.tm_year = date->year; // 1980-1999
-    }
-    tm.tm_mon = date->month - 1;
-    tm.tm_mday = date->day;
-    tm.tm_hour = time_->hours;
-    tm.tm_min = time_->minutes;
-    tm.tm_sec = time_->seconds;
-
-    time_t timestamp = timegm(&tm); /* See README.md if your system lacks timegm(). */
-    if (timestamp != (time_t)-1) {
-        ts->tv_sec = timestamp;
-        ts->tv_nsec = time_->microseconds * 1000;
-        return 0;
+        year = date->year; // 4 digit year, use directly
     } else {
-        return -1;
+        year = 1900 + date->year; // 1980-1999
     }
-}
\ No newline at end of file
+
+    ts->tv_sec = (time_t)minmea_days_from_civil(year, date->month, date->day) * 86400
+            + time_->hours * 3600 + time_->minutes * 60 + time_->seconds;
+    ts->tv_nsec = time_->microseconds * 1000;
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Geofence grid index against a brute-force point-in-polygon test, at 10, 100 and 1000 fences.
+ * The fences are octagons spread over a 1 degree square, the fixes a random walk across it.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "l86_geofence.h"
+#include "l86_test.h"
+
+namespace {
+constexpr int FIX_COUNT = 20000;
+constexpr int OCTAGON = 8;
+
+/* Even-odd rule, on the same microdegree coordinates as the index */
+bool brute_force_inside(const L86Geofence::Polygon &polygon, int32_t latitude, int32_t longitude)
+{
+    bool inside = false;
+    for (uint16_t i = 0, j = polygon.vertex_count - 1; i < polygon.vertex_count; j = i++) {
+        const L86Geofence::Vertex &a = polygon.vertices[i];
+        const L86Geofence::Vertex &b = polygon.vertices[j];
+        if ((a.latitude > latitude) != (b.latitude > latitude)) {
+            double crossing = a.longitude
+                    + static_cast<double>(b.longitude - a.longitude) * (latitude - a.latitude)
+                            / (b.latitude - a.latitude);
+            if (longitude < crossing) {
+                inside = !inside;
+            }
+        }
+    }
+    return inside;
+}
+
+void benchmark(int fence_count)
+{
+    std::mt19937 random(fence_count);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    // One fence per cell of a square layout, so that no fix is in more than one fence
+    int side = static_cast<int>(ceil(sqrt(fence_count)));
+    double spacing = 1e6 / side;
+    std::vector<L86Geofence::Vertex> vertices(fence_count * OCTAGON);
+    std::vector<L86Geofence::Polygon> polygons(fence_count);
+    for (int f = 0; f < fence_count; f++) {
+        double center_latitude = 45e6 + (f / side + 0.5) * spacing;
+        double center_longitude = 5e6 + (f % side + 0.5) * spacing;
+        double radius = spacing * (0.2 + 0.25 * unit(random));
+        for (int v = 0; v < OCTAGON; v++) {
+            double angle = 2 * M_PI * (v + 0.3 * unit(random)) / OCTAGON;
+            vertices[f * OCTAGON + v]
+                    = { static_cast<int32_t>(center_latitude + radius * sin(angle)),
+                          static_cast<int32_t>(center_longitude + radius * cos(angle)) };
+        }
+        polygons[f] = { &vertices[f * OCTAGON], OCTAGON, 0 };
+    }
+
+    uint16_t cells = static_cast<uint16_t>(2 * side);
+    std::vector<uint32_t> cell_offsets(cells * cells + 1);
+    L86Geofence::Index index;
+    L86Geofence::Buffers sizing = { cell_offsets.data(), nullptr, 0, nullptr, 0 };
+    L86Geofence::compile(polygons.data(), fence_count, cells, cells, sizing, &index);
+    std::vector<L86Geofence::CellEntry> entries(index.entry_count);
+    std::vector<uint16_t> edges(index.edge_count);
+    L86Geofence::Buffers buffers = {
+        cell_offsets.data(), entries.data(), index.entry_count, edges.data(), index.edge_count
+    };
+    CHECK(L86Geofence::compile(polygons.data(), fence_count, cells, cells, buffers, &index));
+
+    // Random walk with 50 m steps, bouncing on the area borders
+    std::vector<L86::Fix> fixes(FIX_COUNT);
+    double latitude = 45.5, longitude = 5.5, course = 0.0;
+    for (int i = 0; i < FIX_COUNT; i++) {
+        course += (unit(random) - 0.5) * 0.5;
+        latitude += 0.00045 * cos(course);
+        longitude += 0.00064 * sin(course);
+        if (latitude < 45.0 || latitude > 46.0 || longitude < 5.0 || longitude > 6.0) {
+            course += M_PI;
+            latitude = std::min(std::max(latitude, 45.0), 46.0);
+            longitude = std::min(std::max(longitude, 5.0), 6.0);
+        }
+        fixes[i] = l86_test_fix(i, static_cast<float>(latitude), static_cast<float>(longitude));
+    }
+
+    L86Geofence geofence(&index);
+    auto start = std::chrono::steady_clock::now();
+    for (const L86::Fix &fix : fixes) {
+        geofence.process(fix);
+    }
+    std::chrono::duration<double, std::nano> grid = std::chrono::steady_clock::now() - start;
+
+    int inside_count = 0;
+    start = std::chrono::steady_clock::now();
+    for (const L86::Fix &fix : fixes) {
+        int32_t fix_latitude = static_cast<int32_t>(lroundf(fix.latitude * 1e6f));
+        int32_t fix_longitude = static_cast<int32_t>(lroundf(fix.longitude * 1e6f));
+        for (int f = 0; f < fence_count; f++) {
+            inside_count += brute_force_inside(polygons[f], fix_latitude, fix_longitude);
+        }
+    }
+    std::chrono::duration<double, std::nano> brute_force = std::chrono::steady_clock::now() - start;
+
+    // Same fences entered as with the brute-force test, fix after fix
+    L86Geofence checked(&index);
+    int mismatches = 0;
+    for (int i = 0; i < FIX_COUNT; i += 10) {
+        checked.process(fixes[i]);
+        int32_t fix_latitude = static_cast<int32_t>(lroundf(fixes[i].latitude * 1e6f));
+        int32_t fix_longitude = static_cast<int32_t>(lroundf(fixes[i].longitude * 1e6f));
+        for (int f = 0; f < fence_count; f++) {
+            mismatches += checked.inside(f)
+                    != brute_force_inside(polygons[f], fix_latitude, fix_longitude);
+        }
+    }
+    CHECK(mismatches == 0);
+    CHECK(checked.overflows() == 0);
+
+    printf("%4d fences: grid %ux%u, %lu entries, %lu edges: %6.0f ns/fix, brute force %7.0f ns/fix"
+           " (%d inside)\n",
+            fence_count,
+            cells,
+            cells,
+            (unsigned long)index.entry_count,
+            (unsigned long)index.edge_count,
+            grid.count() / FIX_COUNT,
+            brute_force.count() / FIX_COUNT,
+            inside_count);
+}
+}
+
+int main()
+{
+    benchmark(10);
+    benchmark(100);
+    benchmark(1000);
+    return l86_test_result();
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Fixed-point odometer distance against a double haversine, on 1 to 100 m steps between
+ * -80 and 80 degrees of latitude: accuracy and time per step.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "l86_odometer.h"
+#include "l86_test.h"
+
+namespace {
+constexpr int STEP_COUNT = 100000;
+constexpr double EARTH_RADIUS = 6371000.0; // m
+
+typedef struct {
+    int32_t latitude_a;
+    int32_t longitude_a;
+    int32_t latitude_b;
+    int32_t longitude_b;
+} Step;
+
+double radians(int32_t microdegrees)
+{
+    return microdegrees * 1e-6 * M_PI / 180.0;
+}
+
+/* Haversine distance, in mm */
+double haversine(const Step &step)
+{
+    double latitude_a = radians(step.latitude_a);
+    double latitude_b = radians(step.latitude_b);
+    double half_latitude = sin((latitude_b - latitude_a) / 2);
+    double half_longitude = sin(radians(step.longitude_b - step.longitude_a) / 2);
+    double a = half_latitude * half_latitude
+            + cos(latitude_a) * cos(latitude_b) * half_longitude * half_longitude;
+    return 2 * EARTH_RADIUS * 1000.0 * asin(sqrt(a));
+}
+
+void benchmark()
+{
+    std::mt19937 random(35);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<Step> steps(STEP_COUNT);
+    for (Step &step : steps) {
+        double latitude = -80.0 + 160.0 * unit(random);
+        double longitude = -180.0 + 360.0 * unit(random);
+        double length = 1.0 + 99.0 * unit(random); // m
+        double course = 2 * M_PI * unit(random);
+        double north = length * cos(course) / EARTH_RADIUS * 180.0 / M_PI;
+        double east = length * sin(course) / EARTH_RADIUS * 180.0 / M_PI
+                / cos(latitude * M_PI / 180.0);
+        step.latitude_a = static_cast<int32_t>(latitude * 1e6);
+        step.longitude_a = static_cast<int32_t>(longitude * 1e6);
+        step.latitude_b = static_cast<int32_t>((latitude + north) * 1e6);
+        step.longitude_b = static_cast<int32_t>((longitude + east) * 1e6);
+    }
+
+    std::vector<uint32_t> fixed(STEP_COUNT);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < STEP_COUNT; i++) {
+        const Step &step = steps[i];
+        fixed[i] = L86Odometer::distance(
+                step.latitude_a, step.longitude_a, step.latitude_b, step.longitude_b);
+    }
+    std::chrono::duration<double, std::nano> fixed_time = std::chrono::steady_clock::now() - start;
+
+    std::vector<double> reference(STEP_COUNT);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < STEP_COUNT; i++) {
+        reference[i] = haversine(steps[i]);
+    }
+    std::chrono::duration<double, std::nano> haversine_time
+            = std::chrono::steady_clock::now() - start;
+
+    double max_error = 0.0, max_relative_error = 0.0, total = 0.0, total_reference = 0.0;
+    for (int i = 0; i < STEP_COUNT; i++) {
+        double error = fabs(fixed[i] - reference[i]);
+        max_error = std::max(max_error, error);
+        max_relative_error = std::max(max_relative_error, error / reference[i]);
+        total += fixed[i];
+        total_reference += reference[i];
+    }
+    CHECK(max_relative_error < 1e-3);
+    CHECK(fabs(total - total_reference) / total_reference < 1e-4);
+    printf("fixed point %5.1f ns/step, haversine %5.1f ns/step\n",
+            fixed_time.count() / STEP_COUNT,
+            haversine_time.count() / STEP_COUNT);
+    printf("max error %.0f mm (%.3f%%), total error %.4f%%\n",
+            max_error,
+            100.0 * max_relative_error,
+            100.0 * (total - total_reference) / total_reference);
+}
+}
+
+int main()
+{
+    benchmark();
+    return l86_test_result();
+}
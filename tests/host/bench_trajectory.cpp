@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Trajectory compressor throughput and compression ratio, with a check of the max error:
+ *   bench_trajectory [log.nmea]
+ *
+ * Runs on a synthetic 10 h drive at 1 Hz, with 1.5 m of position noise, and on the fixes of a
+ * recorded NMEA log if one is given.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "l86_test.h"
+#include "l86_trajectory.h"
+
+namespace {
+constexpr double METERS_PER_DEGREE = 111195.0;
+constexpr float MAX_ERROR = 5.0f; // m
+constexpr int DRIVE_LENGTH = 36000; // fixes
+
+std::vector<L86::Fix> kept;
+std::vector<L86::Fix> published;
+
+void keep(const L86::Fix &fix)
+{
+    kept.push_back(fix);
+}
+
+/* RMC, GGA and GLL publish the fix of an epoch: count it once */
+void publish(const L86::Fix &fix)
+{
+    if (published.empty() || fix.time != published.back().time) {
+        published.push_back(fix);
+    }
+}
+
+/* Distance from a fix to a segment, in m, in the equirectangular frame of the segment start */
+double distance_to_segment(const L86::Fix &fix, const L86::Fix &start, const L86::Fix &end)
+{
+    double scale = cos(start.latitude * M_PI / 180.0);
+    double ex = (end.longitude - start.longitude) * scale * METERS_PER_DEGREE;
+    double ey = (end.latitude - start.latitude) * METERS_PER_DEGREE;
+    double px = (fix.longitude - start.longitude) * scale * METERS_PER_DEGREE;
+    double py = (fix.latitude - start.latitude) * METERS_PER_DEGREE;
+    double length = ex * ex + ey * ey;
+    double t = length > 0 ? std::min(std::max((px * ex + py * ey) / length, 0.0), 1.0) : 0.0;
+    return hypot(px - t * ex, py - t * ey);
+}
+
+std::vector<L86::Fix> synthetic_drive()
+{
+    std::mt19937 random(36);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::normal_distribution<double> noise(0.0, 1.5);
+    std::vector<L86::Fix> fixes(DRIVE_LENGTH);
+    double north = 0.0, east = 0.0, course = 0.0, speed = 10.0, turn_rate = 0.0;
+    int segment_end = 0;
+    for (int i = 0; i < DRIVE_LENGTH; i++) {
+        // Straight lines and turns, at a constant speed each
+        if (i >= segment_end) {
+            bool turning = unit(random) < 0.3;
+            segment_end = i + (turning ? 5 + static_cast<int>(10 * unit(random))
+                                       : 20 + static_cast<int>(100 * unit(random)));
+            turn_rate = turning ? (unit(random) - 0.5) * 20.0 : 0.0;
+            speed = 3.0 + 27.0 * unit(random);
+        }
+        course = fmod(course + turn_rate + 360.0, 360.0);
+        north += speed * cos(course * M_PI / 180.0);
+        east += speed * sin(course * M_PI / 180.0);
+        double latitude = 45.0 + (north + noise(random)) / METERS_PER_DEGREE;
+        double longitude = (east + noise(random)) / (METERS_PER_DEGREE * cos(M_PI / 4));
+        fixes[i] = l86_test_fix(i, static_cast<float>(latitude), static_cast<float>(longitude));
+        fixes[i].speed_knots = static_cast<float>(speed / 0.514444);
+        fixes[i].course_over_ground = static_cast<float>(course);
+    }
+    return fixes;
+}
+
+/* Fixes published by the driver for a NMEA log */
+std::vector<L86::Fix> log_fixes(const char *path)
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+    l86.attach_fix_callback(publish);
+
+    FILE *log = fopen(path, "r");
+    if (!log) {
+        perror(path);
+        return published;
+    }
+    char line[MINMEA_MAX_LENGTH + 8];
+    while (fgets(line, sizeof(line), log)) {
+        uart.rx.append(line, strcspn(line, "\r\n"));
+        uart.rx += "\r\n";
+        uart.irq[SerialBase::RxIrq]();
+    }
+    fclose(log);
+    return published;
+}
+
+void benchmark(const char *name, const std::vector<L86::Fix> &fixes)
+{
+    kept.clear();
+    L86TrajectoryCompressor compressor(MAX_ERROR);
+    compressor.attach(keep);
+    auto start = std::chrono::steady_clock::now();
+    for (const L86::Fix &fix : fixes) {
+        compressor.process(fix);
+    }
+    compressor.flush();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+    // Each dropped fix must be within the max error of the kept segment around it
+    double max_error = 0.0;
+    size_t segment = 0;
+    for (const L86::Fix &fix : fixes) {
+        if (fix.fix_status == L86::FixStatusGGA::INVALID) {
+            continue;
+        }
+        while (segment + 2 < kept.size() && kept[segment + 1].time <= fix.time) {
+            segment++;
+        }
+        if (segment + 1 < kept.size()) {
+            max_error = std::max(
+                    max_error, distance_to_segment(fix, kept[segment], kept[segment + 1]));
+        }
+    }
+    CHECK(!kept.empty());
+    CHECK(max_error <= MAX_ERROR + 0.1);
+
+    printf("%s: %lu fixes, %lu kept (ratio %.1f), max error %.2f m, %.0f ns/fix\n",
+            name,
+            (unsigned long)compressor.processed_count(),
+            (unsigned long)kept.size(),
+            static_cast<double>(compressor.processed_count()) / kept.size(),
+            max_error,
+            elapsed.count() / fixes.size());
+}
+}
+
+int main(int argc, char **argv)
+{
+    benchmark("synthetic drive", synthetic_drive());
+    if (argc > 1) {
+        std::vector<L86::Fix> fixes = log_fixes(argv[1]);
+        CHECK(!fixes.empty());
+        benchmark(argv[1], fixes);
+    }
+    return l86_test_result();
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CATIE_SIXTRON_L86_TESTS_L86_TEST_H_
+#define CATIE_SIXTRON_L86_TESTS_L86_TEST_H_
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "l86.h"
+
+static int l86_test_failures = 0;
+
+#define CHECK(condition)                                                                           \
+    do {                                                                                           \
+        if (!(condition)) {                                                                        \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);                   \
+            l86_test_failures++;                                                                   \
+        }                                                                                          \
+    } while (0)
+
+#define CHECK_NEAR(value, expected, tolerance)                                                     \
+    do {                                                                                           \
+        double l86_value = (value);                                                                \
+        if (!(fabs(l86_value - (expected)) <= (tolerance))) {                                      \
+            printf("%s:%d: CHECK_NEAR(%s, %s, %s) failed: %f\n",                                   \
+                    __FILE__,                                                                      \
+                    __LINE__,                                                                      \
+                    #value,                                                                        \
+                    #expected,                                                                     \
+                    #tolerance,                                                                    \
+                    l86_value);                                                                    \
+            l86_test_failures++;                                                                   \
+        }                                                                                          \
+    } while (0)
+
+/*!
+ *  Build a fix with a position
+ *
+ *  \param seconds UTC time, in s
+ *  \param latitude latitude, in degrees
+ *  \param longitude longitude, in degrees
+ */
+inline L86::Fix l86_test_fix(double seconds, float latitude, float longitude)
+{
+    L86::Fix fix = {};
+    fix.time = std::chrono::microseconds(static_cast<int64_t>(seconds * 1e6));
+    fix.latitude = latitude;
+    fix.longitude = longitude;
+    fix.altitude = 100.0f;
+    fix.speed_knots = 5.0f;
+    fix.course_over_ground = 0.0f;
+    fix.dilution_of_precision.positional = 2.0f;
+    fix.dilution_of_precision.horizontal = 1.0f;
+    fix.dilution_of_precision.vertical = 2.0f;
+    fix.fix_status = L86::FixStatusGGA::GNSS_FIX;
+    fix.satellites_used = 8;
+    return fix;
+}
+
+/*!
+ *  Build a fix without position
+ */
+inline L86::Fix l86_test_no_fix(double seconds)
+{
+    L86::Fix fix = l86_test_fix(seconds, NAN, NAN);
+    fix.fix_status = L86::FixStatusGGA::INVALID;
+    return fix;
+}
+
+/*!
+ *  Send a sentence to a driver, as received on its serial link
+ *
+ *  \param uart serial link of the driver
+ *  \param body sentence without '$' and checksum
+ */
+inline void l86_test_receive(UnbufferedSerial *uart, const char *body)
+{
+    uint8_t checksum = 0;
+    for (const char *c = body; *c; c++) {
+        checksum ^= *c;
+    }
+    char sentence[MINMEA_MAX_LENGTH + 8];
+    snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, checksum);
+    uart->rx += sentence;
+    uart->irq[SerialBase::RxIrq]();
+}
+
+/*!
+ *  Run the transmit interrupt of a driver until it has nothing left to send
+ *
+ *  \param uart serial link of the driver
+ *
+ *  \return characters sent since the last call
+ */
+inline std::string l86_test_transmit(UnbufferedSerial *uart)
+{
+    while (uart->irq[SerialBase::TxIrq]) {
+        Callback<void()> transmit = uart->irq[SerialBase::TxIrq];
+        transmit();
+    }
+    std::string written;
+    written.swap(uart->written);
+    return written;
+}
+
+/*!
+ *  Send the pending command of a driver and acknowledge it
+ *
+ *  \param uart serial link of the driver
+ *  \param flag acknowledge flag
+ *
+ *  \return sent command, without checksum
+ */
+inline std::string l86_test_acknowledge(UnbufferedSerial *uart, int flag = MINMEA_PMTK_FLAG_SUCCESS)
+{
+    std::string command = l86_test_transmit(uart);
+    if (command.size() < 9) {
+        return std::string();
+    }
+    command = command.substr(1, command.find('*') - 1);
+    char ack[32];
+    snprintf(ack, sizeof(ack), "PMTK001,%s,%d", command.substr(4, 3).c_str(), flag);
+    l86_test_receive(uart, ack);
+    return command;
+}
+
+inline int l86_test_result()
+{
+    if (l86_test_failures != 0) {
+        printf("%d check(s) failed\n", l86_test_failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif /* CATIE_SIXTRON_L86_TESTS_L86_TEST_H_ */
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Replay of recorded NMEA logs through the driver, on the host:
+ *   replay [-i interval_ms] log.nmea...
+ *
+ * The logs are fed line by line to the driver serial link. Each RMC sentence starts a fix epoch:
+ * the driver timers are moved forward by the fix interval (1000 ms by default) before it, so
+ * that the reported timings follow the log and not the replay speed. The latency histograms
+ * are measured on the host, and compare changes to the reception and parsing path.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "l86.h"
+
+namespace {
+uint32_t fix_count = 0;
+
+void count_fix(const L86::Fix &fix)
+{
+    if (fix.fix_status != L86::FixStatusGGA::INVALID) {
+        fix_count++;
+    }
+}
+
+/* Feed a log, return the number of sentences or -1 if it cannot be read */
+long replay(UnbufferedSerial *uart, const char *path, std::chrono::milliseconds interval)
+{
+    FILE *log = fopen(path, "r");
+    if (!log) {
+        perror(path);
+        return -1;
+    }
+
+    long sentences = 0;
+    char line[MINMEA_MAX_LENGTH + 8];
+    while (fgets(line, sizeof(line), log)) {
+        size_t length = strcspn(line, "\r\n");
+        if (length == 0) {
+            continue;
+        }
+        if (line[0] == '$' && length > 6 && strncmp(line + 3, "RMC", 3) == 0) {
+            Timer::advance(interval);
+        }
+        uart->rx.append(line, length);
+        uart->rx += "\r\n";
+        uart->irq[SerialBase::RxIrq]();
+        sentences++;
+    }
+    fclose(log);
+    return sentences;
+}
+}
+
+int main(int argc, char **argv)
+{
+    std::chrono::milliseconds interval(1000);
+    int first_log = 1;
+    if (argc > 2 && strcmp(argv[1], "-i") == 0) {
+        interval = std::chrono::milliseconds(atoi(argv[2]));
+        first_log = 3;
+    }
+    if (first_log >= argc) {
+        fprintf(stderr, "usage: %s [-i interval_ms] log.nmea...\n", argv[0]);
+        return 2;
+    }
+
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+    l86.attach_fix_callback(count_fix);
+
+    long sentences = 0;
+    for (int i = first_log; i < argc; i++) {
+        long count = replay(&uart, argv[i], interval);
+        if (count < 0) {
+            return 1;
+        }
+        sentences += count;
+    }
+
+    printf("%ld sentences, %lu fixes\n", sentences, (unsigned long)fix_count);
+    l86.dump_ttff_report();
+    l86.dump_latency();
+    return 0;
+}
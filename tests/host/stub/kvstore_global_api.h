@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CATIE_SIXTRON_L86_TESTS_KVSTORE_GLOBAL_API_H_
+#define CATIE_SIXTRON_L86_TESTS_KVSTORE_GLOBAL_API_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+
+/* Keys are kept in memory, until kv_reset() */
+inline std::map<std::string, std::string> &kv_store()
+{
+    static std::map<std::string, std::string> store;
+    return store;
+}
+
+inline int kv_set(const char *key, const void *buffer, size_t size, uint32_t create_flags)
+{
+    kv_store()[key].assign(static_cast<const char *>(buffer), size);
+    return 0;
+}
+
+inline int kv_get(const char *key, void *buffer, size_t buffer_size, size_t *actual_size)
+{
+    auto entry = kv_store().find(key);
+    if (entry == kv_store().end()) {
+        return -1;
+    }
+    *actual_size = std::min(buffer_size, entry->second.size());
+    memcpy(buffer, entry->second.data(), *actual_size);
+    return 0;
+}
+
+inline int kv_reset(const char *kvstore_path)
+{
+    kv_store().clear();
+    return 0;
+}
+
+#endif /* CATIE_SIXTRON_L86_TESTS_KVSTORE_GLOBAL_API_H_ */
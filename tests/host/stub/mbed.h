@@ -0,0 +1,551 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Minimal host stand-in for the mbed OS API used by the driver, for the host tests only.
+ *
+ * Interrupts and the event queue do not run by themselves: a test fills UnbufferedSerial::rx
+ * and calls the attached RX handler, and reads what the driver sent in UnbufferedSerial::written.
+ * Timers follow the host clock, and can be moved forward with Timer::advance(). A blocking
+ * wait for a command runs EventFlags::waiting(), which can acknowledge it.
+ */
+
+#ifndef CATIE_SIXTRON_L86_TESTS_MBED_H_
+#define CATIE_SIXTRON_L86_TESTS_MBED_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <sys/types.h>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+typedef int PinName;
+constexpr PinName NC = -1;
+
+typedef int osPriority;
+constexpr osPriority osPriorityNormal = 24;
+constexpr osPriority osPriorityAboveNormal = 32;
+constexpr osPriority osPriorityHigh = 40;
+typedef int osStatus;
+constexpr osStatus osOK = 0;
+constexpr uint32_t osWaitForever = 0xFFFFFFFF;
+
+#define OS_STACK_SIZE 4096
+#define MBED_SUCCESS 0
+#define MBED_ASSERT(x)
+#define MBED_UNUSED
+#define MBED_FORCEINLINE inline
+#define MBED_NOINLINE
+
+namespace mbed {
+
+template <typename F> class Callback;
+
+template <typename R, typename... A> class Callback<R(A...)> {
+public:
+    Callback() = default;
+
+    Callback(std::nullptr_t)
+    {
+    }
+
+    template <typename T, typename M>
+    Callback(T *object, M method): _function([object, method](A... a) {
+        return (object->*method)(a...);
+    })
+    {
+    }
+
+    template <typename F, typename = decltype(std::declval<F>()(std::declval<A>()...))>
+    Callback(F function): _function(function)
+    {
+    }
+
+    R operator()(A... a) const
+    {
+        return _function(a...);
+    }
+
+    R call(A... a) const
+    {
+        return _function(a...);
+    }
+
+    explicit operator bool() const
+    {
+        return static_cast<bool>(_function);
+    }
+
+private:
+    std::function<R(A...)> _function;
+};
+
+template <typename T, typename R, typename... A>
+Callback<R(A...)> callback(T *object, R (T::*method)(A...))
+{
+    return Callback<R(A...)>(object, method);
+}
+
+class FileHandle {
+public:
+    virtual ~FileHandle() = default;
+    virtual ssize_t read(void *buffer, size_t size) = 0;
+    virtual ssize_t write(const void *buffer, size_t size) = 0;
+
+    virtual off_t seek(off_t offset, int whence = 0)
+    {
+        return 0;
+    }
+
+    virtual int close()
+    {
+        return 0;
+    }
+
+    virtual bool readable() const
+    {
+        return true;
+    }
+
+    virtual bool writable() const
+    {
+        return true;
+    }
+
+    virtual off_t size()
+    {
+        return 0;
+    }
+};
+
+class SerialBase {
+public:
+    enum IrqType {
+        RxIrq = 0,
+        TxIrq
+    };
+};
+
+class UnbufferedSerial: public SerialBase, public FileHandle {
+public:
+    UnbufferedSerial(PinName tx, PinName rx, int baud = 9600)
+    {
+    }
+
+    ssize_t read(void *buffer, size_t size) override
+    {
+        size_t length = 0;
+        while (length < size && rx_position < rx.size()) {
+            static_cast<char *>(buffer)[length++] = rx[rx_position++];
+        }
+        return length;
+    }
+
+    ssize_t write(const void *buffer, size_t size) override
+    {
+        written.append(static_cast<const char *>(buffer), size);
+        return size;
+    }
+
+    bool readable() const override
+    {
+        return rx_position < rx.size();
+    }
+
+    void attach(Callback<void()> func, IrqType type = RxIrq)
+    {
+        irq[type] = func;
+    }
+
+    int enable_output(bool enabled)
+    {
+        return 0;
+    }
+
+    int enable_input(bool enabled)
+    {
+        return 0;
+    }
+
+    void baud(int baudrate)
+    {
+    }
+
+    std::string rx; //!< Bytes received from the module
+    size_t rx_position = 0;
+    std::string written; //!< Bytes sent to the module
+    Callback<void()> irq[2];
+};
+
+class Timer {
+public:
+    void start()
+    {
+    }
+
+    void stop()
+    {
+    }
+
+    void reset()
+    {
+        _start = clock();
+    }
+
+    std::chrono::microseconds elapsed_time() const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(clock() - _start);
+    }
+
+    /*!
+     *  Move all timers forward, to replay a stream at its own pace
+     *
+     *  \param delay time added to the elapsed time of all timers
+     */
+    static void advance(std::chrono::microseconds delay)
+    {
+        offset() += delay;
+    }
+
+private:
+    std::chrono::steady_clock::time_point _start = clock();
+
+    static std::chrono::microseconds &offset()
+    {
+        static std::chrono::microseconds advanced(0);
+        return advanced;
+    }
+
+    static std::chrono::steady_clock::time_point clock()
+    {
+        return std::chrono::steady_clock::now() + offset();
+    }
+};
+
+class LowPowerTimer: public Timer {
+};
+
+/* Does not expire by itself: a test expires the attached timeouts with Timeout::expire() */
+class Timeout {
+public:
+    ~Timeout()
+    {
+        detach();
+    }
+
+    void attach(Callback<void()> func, std::chrono::microseconds delay)
+    {
+        detach();
+        _callback = func;
+        armed().push_back(this);
+    }
+
+    void detach()
+    {
+        std::vector<Timeout *> &timeouts = armed();
+        timeouts.erase(std::remove(timeouts.begin(), timeouts.end(), this), timeouts.end());
+    }
+
+    /*!
+     *  Expire all attached timeouts
+     */
+    static void expire()
+    {
+        std::vector<Timeout *> timeouts;
+        timeouts.swap(armed());
+        for (Timeout *timeout : timeouts) {
+            timeout->_callback();
+        }
+    }
+
+private:
+    Callback<void()> _callback;
+
+    static std::vector<Timeout *> &armed()
+    {
+        static std::vector<Timeout *> timeouts;
+        return timeouts;
+    }
+};
+
+class InterruptIn {
+public:
+    InterruptIn(PinName pin)
+    {
+    }
+
+    void rise(Callback<void()> func)
+    {
+    }
+
+    void fall(Callback<void()> func)
+    {
+    }
+};
+
+class CriticalSectionLock {
+public:
+    CriticalSectionLock()
+    {
+    }
+
+    ~CriticalSectionLock()
+    {
+    }
+};
+
+template <typename T, uint32_t BufferSize, typename CounterType = uint32_t> class CircularBuffer {
+public:
+    void push(const T &data)
+    {
+        _buffer[_head] = data;
+        _head = (_head + 1) % BufferSize;
+        if (_full) {
+            _tail = (_tail + 1) % BufferSize;
+        } else if (_head == _tail) {
+            _full = true;
+        }
+    }
+
+    bool pop(T &data)
+    {
+        if (empty()) {
+            return false;
+        }
+        data = _buffer[_tail];
+        _tail = (_tail + 1) % BufferSize;
+        _full = false;
+        return true;
+    }
+
+    bool empty() const
+    {
+        return _head == _tail && !_full;
+    }
+
+    bool full() const
+    {
+        return _full;
+    }
+
+    CounterType size() const
+    {
+        return _full ? BufferSize : (_head + BufferSize - _tail) % BufferSize;
+    }
+
+    void reset()
+    {
+        _head = 0;
+        _tail = 0;
+        _full = false;
+    }
+
+private:
+    T _buffer[BufferSize];
+    CounterType _head = 0;
+    CounterType _tail = 0;
+    bool _full = false;
+};
+
+class EventQueue {
+public:
+    EventQueue(unsigned size = 0, unsigned char *buffer = nullptr)
+    {
+    }
+
+    template <typename F> int call(F func)
+    {
+        return 1;
+    }
+
+    template <typename T, typename M, typename... A> int call(T *object, M method, A... args)
+    {
+        return 1;
+    }
+
+    template <typename D, typename F> int call_in(D delay, F func)
+    {
+        return 1;
+    }
+
+    template <typename D, typename T, typename M, typename... A>
+    int call_in(D delay, T *object, M method, A... args)
+    {
+        return 1;
+    }
+
+    void cancel(int id)
+    {
+    }
+
+    void dispatch_forever()
+    {
+    }
+};
+
+class BlockDevice {
+public:
+    virtual ~BlockDevice() = default;
+
+    virtual int read(void *buffer, uint64_t address, uint64_t size)
+    {
+        return 0;
+    }
+
+    virtual uint64_t get_read_size() const
+    {
+        return 1;
+    }
+
+    virtual uint64_t size() const
+    {
+        return 0;
+    }
+};
+
+typedef uint64_t bd_addr_t;
+typedef uint64_t bd_size_t;
+
+} // namespace mbed
+
+namespace rtos {
+
+class Thread {
+public:
+    Thread(osPriority priority = osPriorityNormal,
+            uint32_t stack_size = OS_STACK_SIZE,
+            unsigned char *stack_mem = nullptr,
+            const char *name = nullptr)
+    {
+    }
+
+    osStatus start(mbed::Callback<void()> task)
+    {
+        return osOK;
+    }
+};
+
+class EventFlags {
+public:
+    uint32_t set(uint32_t flags)
+    {
+        return flags;
+    }
+
+    uint32_t clear(uint32_t flags = 0x7fffffff)
+    {
+        return flags;
+    }
+
+    uint32_t get() const
+    {
+        return 0;
+    }
+
+    uint32_t wait_any(uint32_t flags, uint32_t millisec = osWaitForever, bool clear = true)
+    {
+        if (waiting()) {
+            waiting()();
+        }
+        return flags;
+    }
+
+    template <typename D> uint32_t wait_any_for(uint32_t flags, D timeout, bool clear = true)
+    {
+        return flags;
+    }
+
+    /*!
+     *  Function called by wait_any(), in place of the thread or interrupt which sets the flags
+     */
+    static mbed::Callback<void()> &waiting()
+    {
+        static mbed::Callback<void()> function;
+        return function;
+    }
+};
+
+class Mutex {
+public:
+    void lock()
+    {
+    }
+
+    void unlock()
+    {
+    }
+};
+
+class Semaphore {
+public:
+    Semaphore(int count = 0)
+    {
+    }
+
+    void release()
+    {
+    }
+
+    void acquire()
+    {
+    }
+
+    template <typename D> bool try_acquire_for(D timeout)
+    {
+        return true;
+    }
+};
+
+namespace Kernel {
+struct Clock {
+    typedef std::chrono::milliseconds duration;
+    typedef std::chrono::time_point<Clock> time_point;
+
+    static time_point now()
+    {
+        return time_point();
+    }
+};
+} // namespace Kernel
+
+namespace ThisThread {
+template <typename D> void sleep_for(D duration)
+{
+    std::this_thread::sleep_for(duration);
+}
+} // namespace ThisThread
+
+} // namespace rtos
+
+inline mbed::EventQueue *mbed_event_queue()
+{
+    static mbed::EventQueue queue;
+    return &queue;
+}
+
+inline void core_util_critical_section_enter()
+{
+}
+
+inline void core_util_critical_section_exit()
+{
+}
+
+inline bool core_util_is_isr_active()
+{
+    return false;
+}
+
+using namespace mbed;
+using namespace rtos;
+
+#endif /* CATIE_SIXTRON_L86_TESTS_MBED_H_ */
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_test.h"
+
+namespace {
+int completions = 0;
+L86::CommandStatus completed_status = L86::CommandStatus::UNKNOWN;
+
+void record(L86::CommandStatus status)
+{
+    completions++;
+    completed_status = status;
+}
+
+void test_invalid()
+{
+    L86::CommandFuture future;
+    CHECK(!future.valid());
+    CHECK(future.status() == L86::CommandStatus::UNKNOWN);
+    CHECK(future.get() == MINMEA_PMTK_FLAG_INVALID);
+    CHECK(!future.then(record));
+
+    // Full queue
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+    for (int i = 0; i < MBED_CONF_L86_COMMAND_QUEUE_SIZE; i++) {
+        CHECK(l86.set_position_fix_interval_async(1000).valid());
+    }
+    CHECK(!l86.set_position_fix_interval_async(1000).valid());
+}
+
+void test_completion()
+{
+    completions = 0;
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    L86::CommandFuture interval = l86.set_position_fix_interval_async(200);
+    L86::CommandFuture navigation
+            = l86.set_navigation_mode_async(L86::NavigationMode::NORMAL_MODE);
+    CHECK(interval.valid() && !interval.ready());
+    CHECK(interval.status() == L86::CommandStatus::PENDING);
+    CHECK(navigation.status() == L86::CommandStatus::QUEUED);
+    CHECK(navigation.then(record));
+
+    CHECK(l86_test_acknowledge(&uart) == "PMTK220,200");
+    CHECK(interval.ready());
+    CHECK(interval.get() == MINMEA_PMTK_FLAG_SUCCESS);
+    CHECK(!interval.then(record));
+    CHECK(completions == 0);
+
+    CHECK(l86_test_acknowledge(&uart, MINMEA_PMTK_FLAG_FAILURE) == "PMTK886,0");
+    CHECK(completions == 1 && completed_status == L86::CommandStatus::FAILED);
+    CHECK(navigation.get() == MINMEA_PMTK_FLAG_FAILURE);
+}
+
+void test_commands()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    L86::SatelliteSystems systems;
+    systems.set(static_cast<size_t>(L86::SatelliteSystem::GPS));
+    systems.set(static_cast<size_t>(L86::SatelliteSystem::GLONASS));
+    L86::CommandFuture future = l86.set_satellite_system_async(systems);
+    CHECK(l86_test_acknowledge(&uart) == "PMTK353,1,1,0,0,0");
+    CHECK(future.get() == MINMEA_PMTK_FLAG_SUCCESS);
+
+    // Not acknowledged by the module: completed once sent
+    future = l86.start_async(L86::StartMode::HOT_START);
+    CHECK(future.status() == L86::CommandStatus::PENDING);
+    CHECK(l86_test_transmit(&uart).compare(0, 8, "$PMTK101") == 0);
+    CHECK(future.get() == MINMEA_PMTK_FLAG_SUCCESS);
+
+    // Never acknowledged
+    future = l86.standby_mode_async(L86::StandbyMode::PERIODIC_STANDBY_MODE);
+    for (int i = 0; i < MBED_CONF_L86_PMTK_MAX_ATTEMPTS; i++) {
+        CHECK(l86_test_transmit(&uart).compare(0, 10, "$PMTK225,2") == 0);
+        Timeout::expire();
+    }
+    CHECK(future.status() == L86::CommandStatus::TIMEOUT);
+    CHECK(future.get() == MINMEA_PMTK_FLAG_INVALID);
+}
+}
+
+int main()
+{
+    test_invalid();
+    test_completion();
+    test_commands();
+    return l86_test_result();
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <vector>
+
+#include "l86_test.h"
+
+namespace {
+std::vector<L86::CommandStatus> completions;
+
+void record(L86::CommandStatus status)
+{
+    completions.push_back(status);
+}
+
+minmea_sentence_pmtk fix_interval(const char *interval)
+{
+    minmea_sentence_pmtk message = { MINMEA_PMTK_API_SET_POS_FIX, "", true, false, false };
+    strcpy(message.parameters, interval);
+    return message;
+}
+
+void test_order()
+{
+    completions.clear();
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    L86::CommandHandle first = l86.send_command(fix_interval("1000"), record);
+    L86::CommandHandle second = l86.send_command(fix_interval("2000"), record);
+    CHECK(first != 0 && second != 0 && first != second);
+    CHECK(l86.command_status(first) == L86::CommandStatus::PENDING);
+    CHECK(l86.command_status(second) == L86::CommandStatus::QUEUED);
+
+    // One command at a time: the second one is sent after the acknowledge of the first
+    CHECK(l86_test_acknowledge(&uart) == "PMTK220,1000");
+    CHECK(l86.command_status(first) == L86::CommandStatus::SUCCEEDED);
+    CHECK(l86.command_status(second) == L86::CommandStatus::PENDING);
+    CHECK(l86_test_acknowledge(&uart, MINMEA_PMTK_FLAG_FAILURE) == "PMTK220,2000");
+    CHECK(l86.command_status(second) == L86::CommandStatus::FAILED);
+    CHECK(l86_test_transmit(&uart).empty());
+
+    CHECK(completions.size() == 2);
+    CHECK(completions[0] == L86::CommandStatus::SUCCEEDED);
+    CHECK(completions[1] == L86::CommandStatus::FAILED);
+}
+
+void test_acknowledges()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    L86::CommandHandle handle = l86.send_command(fix_interval("1000"));
+    CHECK(l86_test_transmit(&uart).compare(0, 13, "$PMTK220,1000") == 0);
+
+    // Acknowledge of another command, then unsupported
+    l86_test_receive(&uart, "PMTK001,314,3");
+    CHECK(l86.command_status(handle) == L86::CommandStatus::PENDING);
+    l86_test_receive(&uart, "PMTK001,220,1");
+    CHECK(l86.command_status(handle) == L86::CommandStatus::UNSUPPORTED);
+
+    handle = l86.send_command(fix_interval("1000"));
+    CHECK(l86_test_acknowledge(&uart, MINMEA_PMTK_FLAG_INVALID) == "PMTK220,1000");
+    CHECK(l86.command_status(handle) == L86::CommandStatus::INVALID);
+
+    // Without expected acknowledge, the command completes once sent
+    minmea_sentence_pmtk hot_start = { MINMEA_PMTK_CMD_HOT_START, "", false, false, false };
+    handle = l86.send_command(hot_start);
+    CHECK(l86.command_status(handle) == L86::CommandStatus::PENDING);
+    CHECK(l86_test_transmit(&uart).compare(0, 8, "$PMTK101") == 0);
+    CHECK(l86.command_status(handle) == L86::CommandStatus::SUCCEEDED);
+}
+
+void test_full_queue()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    L86::CommandHandle handles[MBED_CONF_L86_COMMAND_QUEUE_SIZE];
+    for (int i = 0; i < MBED_CONF_L86_COMMAND_QUEUE_SIZE; i++) {
+        handles[i] = l86.send_command(fix_interval("1000"));
+        CHECK(handles[i] != 0);
+    }
+    CHECK(l86.send_command(fix_interval("1000")) == 0);
+
+    // A completed slot is reused with a new handle, the old one is no longer tracked
+    l86_test_acknowledge(&uart);
+    L86::CommandHandle handle = l86.send_command(fix_interval("2000"));
+    CHECK(handle != 0 && handle != handles[0]);
+    CHECK(l86.command_status(handles[0]) == L86::CommandStatus::UNKNOWN);
+    CHECK(l86.command_status(0) == L86::CommandStatus::UNKNOWN);
+
+    for (int i = 1; i < MBED_CONF_L86_COMMAND_QUEUE_SIZE; i++) {
+        CHECK(l86_test_acknowledge(&uart) == "PMTK220,1000");
+        CHECK(l86.command_status(handles[i]) == L86::CommandStatus::SUCCEEDED);
+    }
+    CHECK(l86_test_acknowledge(&uart) == "PMTK220,2000");
+    CHECK(l86.command_status(handle) == L86::CommandStatus::SUCCEEDED);
+}
+}
+
+int main()
+{
+    test_order();
+    test_acknowledges();
+    test_full_queue();
+    return l86_test_result();
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <vector>
+
+#include "l86_test.h"
+
+namespace {
+UnbufferedSerial *module_uart;
+int module_flag = MINMEA_PMTK_FLAG_SUCCESS;
+std::vector<std::string> sent;
+
+/* Acknowledge the commands apply() waits for, as the module would */
+void acknowledge()
+{
+    std::string command = l86_test_acknowledge(module_uart, module_flag);
+    if (!command.empty()) {
+        sent.push_back(command);
+    }
+}
+
+L86::Configuration configuration()
+{
+    L86::Configuration configuration = {};
+    configuration.satellite_systems.set(static_cast<size_t>(L86::SatelliteSystem::GPS));
+    configuration.nmea_output.frequencies[static_cast<size_t>(L86::NmeaCommandType::RMC)] = 1;
+    configuration.nmea_output.frequencies[static_cast<size_t>(L86::NmeaCommandType::GGA)] = 1;
+    configuration.navigation_mode = L86::NavigationMode::NORMAL_MODE;
+    configuration.fix_interval = 1000;
+    return configuration;
+}
+
+void test_diff()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+    module_uart = &uart;
+    module_flag = MINMEA_PMTK_FLAG_SUCCESS;
+    EventFlags::waiting() = acknowledge;
+
+    L86::Configuration known;
+    CHECK(l86.known_configuration(&known).none());
+
+    // Nothing known: every setting is sent
+    sent.clear();
+    L86::Configuration target = configuration();
+    CHECK(l86.apply(target));
+    CHECK(sent.size() == 4);
+    CHECK(sent[0] == "PMTK353,1,0,0,0,0");
+    CHECK(sent[1] == "PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0");
+    CHECK(sent[2] == "PMTK886,0");
+    CHECK(sent[3] == "PMTK220,1000");
+    CHECK(l86.known_configuration(&known).all());
+    CHECK(known.fix_interval == 1000);
+
+    // Unchanged: no command
+    sent.clear();
+    CHECK(l86.apply(target));
+    CHECK(sent.empty());
+
+    // Only the changed settings, and only the selected fields
+    target.fix_interval = 200;
+    target.navigation_mode = L86::NavigationMode::AVIATION_MODE;
+    L86::ConfigurationFields fields;
+    fields.set(static_cast<size_t>(L86::ConfigurationField::FIX_INTERVAL));
+    CHECK(l86.apply(target, fields));
+    CHECK(sent.size() == 1 && sent[0] == "PMTK220,200");
+    sent.clear();
+    CHECK(l86.apply(target));
+    CHECK(sent.size() == 1 && sent[0] == "PMTK886,2");
+
+    EventFlags::waiting() = nullptr;
+}
+
+void test_unconfirmed()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+    module_uart = &uart;
+    EventFlags::waiting() = acknowledge;
+    L86::Configuration target = configuration();
+    L86::Configuration known;
+
+    // A rejected setting stays unknown, and is sent again
+    module_flag = MINMEA_PMTK_FLAG_FAILURE;
+    CHECK(!l86.apply(target));
+    CHECK(l86.known_configuration(&known).none());
+    module_flag = MINMEA_PMTK_FLAG_SUCCESS;
+    sent.clear();
+    CHECK(l86.apply(target));
+    CHECK(sent.size() == 4);
+
+    // Module restart, or invalidation by the application: everything is sent again
+    l86_test_receive(&uart, "PMTK010,001");
+    CHECK(l86.known_configuration(&known).none());
+    sent.clear();
+    CHECK(l86.apply(target));
+    CHECK(sent.size() == 4);
+    l86.invalidate_configuration();
+    CHECK(l86.known_configuration(&known).none());
+
+    // A query reply is known configuration too
+    EventFlags::waiting() = nullptr;
+    uint16_t interval = 0;
+    L86::CommandFuture query = l86.position_fix_interval_async(&interval);
+    l86_test_transmit(&uart);
+    l86_test_receive(&uart, "PMTK500,1000,0,0,0.0,0.0");
+    CHECK(query.ready());
+    CHECK(l86.known_configuration(&known).count() == 1);
+    EventFlags::waiting() = acknowledge;
+    sent.clear();
+    CHECK(l86.apply(target));
+    CHECK(sent.size() == 3 && sent[2] == "PMTK886,0");
+
+    EventFlags::waiting() = nullptr;
+}
+}
+
+int main()
+{
+    test_diff();
+    test_unconfirmed();
+    return l86_test_result();
+}
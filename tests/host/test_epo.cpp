@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "l86_epo.h"
+#include "l86_test.h"
+
+namespace {
+constexpr uint16_t COMMAND_EPO_DATA = 722;
+constexpr uint16_t COMMAND_EPO_ACK = 723;
+constexpr uint16_t COMMAND_SET_OUTPUT_FORMAT = 253;
+constexpr uint16_t FINAL_SEQUENCE = 0xFFFF;
+constexpr int NO_DROP = -1;
+
+/*!
+ *  Scripted module answering the binary EPO packets
+ *
+ *  Packets are handled in order: a packet after a missing one is ignored without acknowledge,
+ *  as the module does, and an already received packet is acknowledged again.
+ */
+class FakeModule: public FileHandle {
+public:
+    FakeModule(int drop_sequence = NO_DROP, bool acknowledge = true):
+            _drop_sequence(drop_sequence), _acknowledge(acknowledge)
+    {
+    }
+
+    ssize_t read(void *buffer, size_t size) override
+    {
+        size_t length = 0;
+        while (length < size && !_output.empty()) {
+            static_cast<uint8_t *>(buffer)[length++] = _output.front();
+            _output.pop_front();
+        }
+        return length;
+    }
+
+    ssize_t write(const void *buffer, size_t size) override
+    {
+        _input.append(static_cast<const char *>(buffer), size);
+        parse();
+        return size;
+    }
+
+    bool readable() const override
+    {
+        return !_output.empty();
+    }
+
+    std::vector<uint8_t> data; //!< EPO data received in order
+    int data_packets = 0; //!< Data packets received, retransmissions included
+    bool finished = false; //!< End of transfer packet received
+    bool nmea_mode = false; //!< Switched back to NMEA
+
+private:
+    std::string _input;
+    std::deque<uint8_t> _output;
+    uint16_t _expected = 0;
+    int _drop_sequence;
+    bool _acknowledge;
+
+    static uint16_t get_uint16(const std::string &buffer, size_t position)
+    {
+        return static_cast<uint8_t>(buffer[position])
+                | (static_cast<uint8_t>(buffer[position + 1]) << 8);
+    }
+
+    void parse()
+    {
+        while (true) {
+            size_t start = _input.find("\x04\x24");
+            if (start == std::string::npos || _input.size() < start + 4) {
+                return;
+            }
+            _input.erase(0, start);
+            size_t length = get_uint16(_input, 2);
+            if (_input.size() < length) {
+                return;
+            }
+            handle(_input.substr(0, length));
+            _input.erase(0, length);
+        }
+    }
+
+    void handle(const std::string &packet)
+    {
+        uint8_t checksum = 0;
+        for (size_t i = 2; i < packet.size() - 3; i++) {
+            checksum ^= static_cast<uint8_t>(packet[i]);
+        }
+        CHECK(checksum == static_cast<uint8_t>(packet[packet.size() - 3]));
+        CHECK(packet.compare(packet.size() - 2, 2, "\r\n") == 0);
+
+        uint16_t command = get_uint16(packet, 4);
+        if (command == COMMAND_SET_OUTPUT_FORMAT) {
+            nmea_mode = true;
+            return;
+        }
+        CHECK(command == COMMAND_EPO_DATA);
+        CHECK(packet.size() == 9 + 2 + L86EpoUploader::PACKET_DATA_SIZE);
+        data_packets++;
+
+        uint16_t sequence = get_uint16(packet, 6);
+        if (sequence == _drop_sequence) {
+            _drop_sequence = NO_DROP; // lost once on the link
+            return;
+        }
+        if (!_acknowledge) {
+            return;
+        }
+        if (sequence == FINAL_SEQUENCE) {
+            finished = true;
+        } else if (sequence == _expected) {
+            for (size_t i = 8; i < 8 + L86EpoUploader::PACKET_DATA_SIZE; i++) {
+                data.push_back(static_cast<uint8_t>(packet[i]));
+            }
+            _expected++;
+        } else if (sequence > _expected) {
+            return; // out of order
+        }
+        acknowledge(sequence);
+    }
+
+    void acknowledge(uint16_t sequence)
+    {
+        uint8_t ack[12] = { 0x04,
+            0x24,
+            sizeof(ack),
+            0,
+            COMMAND_EPO_ACK & 0xFF,
+            COMMAND_EPO_ACK >> 8,
+            static_cast<uint8_t>(sequence & 0xFF),
+            static_cast<uint8_t>(sequence >> 8),
+            1,
+            0,
+            '\r',
+            '\n' };
+        for (size_t i = 2; i < sizeof(ack) - 3; i++) {
+            ack[9] ^= ack[i];
+        }
+        _output.insert(_output.end(), ack, ack + sizeof(ack));
+    }
+};
+
+/* EPO file in memory */
+class MemoryFile: public FileHandle {
+public:
+    MemoryFile(size_t size)
+    {
+        for (size_t i = 0; i < size; i++) {
+            content.push_back(static_cast<uint8_t>(i * 7 + i / 256));
+        }
+    }
+
+    ssize_t read(void *buffer, size_t size) override
+    {
+        size_t length = std::min(size, content.size() - _position);
+        memcpy(buffer, content.data() + _position, length);
+        _position += length;
+        return length;
+    }
+
+    ssize_t write(const void *, size_t) override
+    {
+        return -1;
+    }
+
+    std::vector<uint8_t> content;
+
+private:
+    size_t _position = 0;
+};
+
+constexpr size_t EPO_SIZE = 15 * L86EpoUploader::SV_RECORD_SIZE; // 5 packets
+
+void test_upload()
+{
+    FakeModule module;
+    MemoryFile file(EPO_SIZE);
+    L86EpoUploader uploader(&module);
+    L86EpoUploader::Report report;
+
+    CHECK(uploader.upload(&file, &report) == L86EpoUploader::Result::SUCCESS);
+    CHECK(module.finished && module.nmea_mode);
+    CHECK(module.data.size() == EPO_SIZE);
+    CHECK(module.data == file.content);
+    CHECK(report.bytes == EPO_SIZE);
+    CHECK(report.packets == 5);
+    CHECK(report.retransmissions == 0);
+}
+
+void test_retransmission()
+{
+    // Packet 2 is lost: packets 3 and 4 are ignored, and the window is sent again from 2
+    FakeModule module(2);
+    MemoryFile file(EPO_SIZE);
+    L86EpoUploader uploader(&module, 4);
+    L86EpoUploader::Report report;
+
+    CHECK(uploader.upload(&file, &report) == L86EpoUploader::Result::SUCCESS);
+    CHECK(module.finished);
+    CHECK(module.data == file.content);
+    CHECK(report.retransmissions == 3);
+    CHECK(report.packets == 8);
+    CHECK(module.data_packets == 9); // final packet included
+}
+
+void test_stop_and_wait()
+{
+    FakeModule module(1);
+    MemoryFile file(EPO_SIZE);
+    L86EpoUploader uploader(&module, 1);
+    L86EpoUploader::Report report;
+
+    CHECK(uploader.upload(&file, &report) == L86EpoUploader::Result::SUCCESS);
+    CHECK(module.data == file.content);
+    CHECK(report.retransmissions == 1);
+}
+
+void test_errors()
+{
+    // Not a whole number of records
+    FakeModule module;
+    MemoryFile partial(L86EpoUploader::SV_RECORD_SIZE + 1);
+    L86EpoUploader uploader(&module);
+    CHECK(uploader.upload(&partial) == L86EpoUploader::Result::SOURCE_ERROR);
+    CHECK(module.nmea_mode);
+
+    // No acknowledge at all
+    FakeModule silent(NO_DROP, false);
+    MemoryFile file(EPO_SIZE);
+    L86EpoUploader silent_uploader(&silent, 2);
+    L86EpoUploader::Report report;
+    CHECK(silent_uploader.upload(&file, &report) == L86EpoUploader::Result::TIMEOUT);
+    CHECK(report.retransmissions == 2 * MBED_CONF_L86_EPO_MAX_RETRIES);
+    CHECK(silent.nmea_mode);
+}
+}
+
+int main()
+{
+    test_upload();
+    test_retransmission();
+    test_stop_and_wait();
+    test_errors();
+    return l86_test_result();
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_fix_history.h"
+#include "l86_test.h"
+
+namespace {
+std::chrono::microseconds at(double seconds)
+{
+    return std::chrono::microseconds(static_cast<int64_t>(seconds * 1e6));
+}
+
+void test_interpolation()
+{
+    L86FixHistory<8> history;
+    L86::Fix fix;
+    CHECK(!history.latest(&fix));
+
+    L86::Fix first = l86_test_fix(10, 45.0f, 170.0f);
+    L86::Fix second = l86_test_fix(11, 45.001f, -170.0f);
+    first.course_over_ground = 350.0f;
+    second.course_over_ground = 10.0f;
+    second.altitude = 110.0f;
+    history.append(first);
+    history.append(second);
+    CHECK(history.size() == 2);
+
+    CHECK(history.at(at(10.5), &fix));
+    CHECK(fix.time == at(10.5));
+    CHECK_NEAR(fix.latitude, 45.0005, 1e-5);
+    CHECK_NEAR(fabsf(fix.longitude), 180.0, 1e-3); // across the antimeridian
+    CHECK_NEAR(fix.altitude, 105.0, 1e-3);
+    CHECK(fix.course_over_ground < 0.01f || fix.course_over_ground > 359.99f);
+
+    CHECK(history.at(at(10.5), &fix, L86FixHistory<8>::Interpolation::GREAT_CIRCLE));
+    CHECK_NEAR(fabsf(fix.longitude), 180.0, 1e-3);
+
+    CHECK(!history.at(at(9.9), &fix));
+    CHECK(!history.at(at(11.1), &fix));
+    CHECK(history.latest(&fix));
+    CHECK(fix.time == at(11));
+}
+
+void test_ring()
+{
+    L86FixHistory<4> history;
+    for (int i = 0; i < 10; i++) {
+        history.append(l86_test_fix(i, 45.0f + i * 0.001f, 0.0f));
+    }
+    // Out of order and duplicate times
+    history.append(l86_test_fix(3, 0.0f, 0.0f));
+    L86::Fix replaced = l86_test_fix(9, 46.0f, 0.0f);
+    history.append(replaced);
+    CHECK(history.size() == 4);
+
+    L86::Fix fix;
+    CHECK(!history.at(at(5.5), &fix));
+    CHECK(history.at(at(6.0), &fix));
+    CHECK_NEAR(fix.latitude, 45.006, 1e-5);
+    CHECK(history.latest(&fix));
+    CHECK_NEAR(fix.latitude, 46.0, 1e-5);
+
+    history.clear();
+    CHECK(history.size() == 0);
+    CHECK(!history.at(at(9.0), &fix));
+}
+
+void test_outage()
+{
+    L86FixHistory<8> history;
+    history.append(l86_test_fix(1, 45.0f, 1.0f));
+    history.append(l86_test_fix(2, 45.001f, 1.0f));
+    history.append(l86_test_no_fix(3));
+    L86::Fix no_status = l86_test_fix(4, NAN, 1.0f);
+    history.append(no_status);
+    history.append(l86_test_fix(5, 45.004f, 1.0f));
+    history.append(l86_test_fix(6, 45.005f, 1.0f));
+    CHECK(history.size() == 4);
+
+    // Gaps are not interpolated across, their ends still are available
+    L86::Fix fix;
+    CHECK(history.at(at(1.5), &fix));
+    CHECK(!history.at(at(3.0), &fix));
+    CHECK(!history.at(at(4.5), &fix));
+    CHECK(history.at(at(2.0), &fix));
+    CHECK(history.at(at(5.0), &fix));
+    CHECK_NEAR(fix.latitude, 45.004, 1e-5);
+    CHECK(history.at(at(5.5), &fix));
+}
+}
+
+int main()
+{
+    test_interpolation();
+    test_ring();
+    test_outage();
+    return l86_test_result();
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_test.h"
+
+namespace {
+void test_position_only()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    l86_test_receive(&uart, "GPRMC,120000.000,A,4448.0000,N,00036.0000,W,0.0,0.0,010121,,,A");
+    l86_test_receive(&uart, "GPGGA,120000.000,4448.0000,N,00036.0000,W,1,8,1.0,50.0,M,0,M,,");
+    L86::Fix fix = l86.fix();
+    CHECK(fix.fix_status == L86::FixStatusGGA::GNSS_FIX);
+    CHECK_NEAR(fix.latitude, 44.8, 1e-4);
+    CHECK_NEAR(fix.longitude, -0.6, 1e-4);
+
+    // Disabled decoders: the sentences are counted as unknown and change nothing
+    l86_test_receive(&uart, "GPGSA,A,3,05,,,,,,,,,,,,2.0,1.0,1.7");
+    l86_test_receive(&uart, "GPGSV,1,1,01,05,45,120,40");
+    l86_test_receive(&uart, "GPVTG,90.0,T,,M,10.0,N,18.5,K,A");
+    l86_test_receive(&uart, "GPGLL,4500.0000,N,00100.0000,W,120001.000,A,A");
+    CHECK(l86.stats().unknown_sentences == 4);
+    CHECK(l86.satellites()[0].id == 0);
+    CHECK_NEAR(l86.latitude(), 44.8, 1e-4);
+}
+}
+
+int main()
+{
+    test_position_only();
+    return l86_test_result();
+}
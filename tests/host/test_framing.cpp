@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_test.h"
+
+namespace {
+const char RMC[] = "$GPRMC,120000.000,A,4448.0000,N,00036.0000,W,0.0,0.0,010121,,,A*75\r\n";
+const char GGA[] = "$GPGGA,120001.000,4500.0000,N,00036.0000,W,1,8,1.0,50.0,M,0,M,,*6A\r\n";
+
+uint32_t rmc_count(L86 &l86)
+{
+    return l86.stats().sentences[static_cast<size_t>(L86::NmeaCommandType::RMC)];
+}
+
+/* Feed raw bytes, as received by one serial interrupt */
+void feed(UnbufferedSerial *uart, const std::string &bytes)
+{
+    uart->rx += bytes;
+    uart->irq[SerialBase::RxIrq]();
+}
+
+void test_split_sentence()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    // Line noise before the first '$' is skipped, the checksum is computed byte after byte
+    feed(&uart, std::string("\xff\x00garbage", 9));
+    for (const char *c = RMC; *c; c++) {
+        feed(&uart, std::string(1, *c));
+    }
+    CHECK(rmc_count(l86) == 1);
+    CHECK_NEAR(l86.latitude(), 44.8, 1e-4);
+
+    L86::Stats stats = l86.stats();
+    CHECK(stats.framing_errors == 0);
+    CHECK(stats.checksum_failures == 0);
+    CHECK(stats.resynchronizations == 0);
+}
+
+void test_checksum()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    // Lower case hex digits, and sentences without checksum are accepted
+    feed(&uart, "$GPGGA,120001.000,4500.0000,N,00036.0000,W,1,8,1.0,50.0,M,0,M,,*6a\r\n");
+    feed(&uart, "$GPRMC,120000.000,A,4448.0000,N,00036.0000,W,0.0,0.0,010121,,,A\r\n");
+    CHECK(l86.stats().sentences[static_cast<size_t>(L86::NmeaCommandType::GGA)] == 1);
+    CHECK(rmc_count(l86) == 1);
+
+    feed(&uart, "$GPRMC,120000.000,A,4448.0000,N,00036.0000,W,0.0,0.0,010121,,,A*76\r\n");
+    CHECK(rmc_count(l86) == 1);
+    CHECK(l86.stats().checksum_failures == 1);
+}
+
+void test_framing_errors()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    // Non-printable byte, bad checksum digit, and byte after the checksum
+    feed(&uart, "$GPRMC,120000.000,A,4448.0000,N\x01,00036.0000,W,0.0,0.0,010121,,,A*75\r\n");
+    feed(&uart, "$GPRMC,120000.000,A,4448.0000,N,00036.0000,W,0.0,0.0,010121,,,A*7G\r\n");
+    feed(&uart, "$GPRMC,120000.000,A,4448.0000,N,00036.0000,W,0.0,0.0,010121,,,A*75x\r\n");
+    CHECK(rmc_count(l86) == 0);
+    CHECK(l86.stats().framing_errors == 3);
+
+    // The framing is back in sync on the next '$'
+    feed(&uart, RMC);
+    CHECK(rmc_count(l86) == 1);
+}
+
+void test_resynchronization()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    // End of line lost: the interrupted sentence is dropped, the new one is kept
+    feed(&uart, "$GPGGA,120000.000,4448.00");
+    feed(&uart, GGA);
+    feed(&uart, "$GPRMC,120000.000,A,4448.0000,N,0003");
+    feed(&uart, RMC);
+    L86::Stats stats = l86.stats();
+    CHECK(stats.resynchronizations == 2);
+    CHECK(stats.recovered_sentences == 2);
+    CHECK(stats.sentences[static_cast<size_t>(L86::NmeaCommandType::GGA)] == 1);
+    CHECK(rmc_count(l86) == 1);
+    CHECK(stats.framing_errors == 0);
+
+    // Sentence longer than the framing buffer
+    feed(&uart, "$GPGGA," + std::string(MINMEA_MAX_LENGTH, '0') + "\r\n");
+    CHECK(l86.stats().framing_overflows == 1);
+    feed(&uart, GGA);
+    CHECK(l86.stats().sentences[static_cast<size_t>(L86::NmeaCommandType::GGA)] == 2);
+}
+}
+
+int main()
+{
+    test_split_sentence();
+    test_checksum();
+    test_framing_errors();
+    test_resynchronization();
+    return l86_test_result();
+}
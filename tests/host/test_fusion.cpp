@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <vector>
+
+#include "l86_fusion.h"
+#include "l86_test.h"
+
+namespace {
+std::vector<L86::Fix> fused;
+
+void output(const L86::Fix &fix)
+{
+    fused.push_back(fix);
+}
+
+L86::Fix receiver_fix(double seconds, float latitude, float hdop)
+{
+    L86::Fix fix = l86_test_fix(seconds, latitude, 0.5f);
+    fix.dilution_of_precision.horizontal = hdop;
+    return fix;
+}
+
+void test_receivers()
+{
+    L86FixFusion fusion;
+    for (int i = 0; i < L86FixFusion::MAX_RECEIVERS; i++) {
+        CHECK(fusion.add_receiver() == i);
+    }
+    CHECK(fusion.add_receiver() == -1);
+    CHECK(fusion.health(0).health == L86FixFusion::Health::UNKNOWN);
+}
+
+void test_weighting()
+{
+    fused.clear();
+    L86FixFusion fusion;
+    fusion.add_receiver();
+    fusion.add_receiver();
+    fusion.add_receiver();
+    fusion.attach(output);
+
+    // Receiver 1 is twice as precise: four times the weight of each other receiver
+    fusion.process(0, receiver_fix(100.0, 45.0f, 2.0f));
+    fusion.process(1, receiver_fix(100.0, 45.00003f, 1.0f));
+    fusion.process(2, receiver_fix(100.02, 45.0f, 2.0f));
+    CHECK(fused.empty());
+
+    fusion.process(0, receiver_fix(101.0, 45.0f, 2.0f));
+    CHECK(fused.size() == 1);
+    CHECK(fused[0].time == std::chrono::seconds(100));
+    CHECK_NEAR(fused[0].latitude, 45.00002, 1e-5);
+    CHECK(fused[0].dilution_of_precision.horizontal < 1.0f);
+    CHECK_NEAR(fusion.health(1).weight, 2.0 / 3.0, 1e-3);
+    CHECK(fusion.health(0).health == L86FixFusion::Health::USED);
+    CHECK(fusion.health(2).health == L86FixFusion::Health::USED);
+}
+
+void test_outlier_and_missing()
+{
+    fused.clear();
+    L86FixFusion fusion;
+    fusion.add_receiver();
+    fusion.add_receiver();
+    fusion.add_receiver();
+    fusion.attach(output);
+
+    // Receiver 2 is 110 m away, receiver 1 lost its fix
+    fusion.process(0, receiver_fix(200.0, 45.0f, 1.0f));
+    fusion.process(1, receiver_fix(200.0, 45.00001f, 1.0f));
+    fusion.process(2, receiver_fix(200.0, 45.001f, 1.0f));
+    fusion.process(0, receiver_fix(201.0, 45.0f, 1.0f));
+    fusion.process(1, l86_test_no_fix(201.0));
+    fusion.flush();
+
+    CHECK(fused.size() == 2);
+    CHECK_NEAR(fused[0].latitude, 45.000005, 1e-5);
+    CHECK(fusion.health(0).health == L86FixFusion::Health::USED);
+    CHECK(fusion.health(1).health == L86FixFusion::Health::NO_FIX);
+    CHECK(fusion.health(2).health == L86FixFusion::Health::MISSING);
+    CHECK(fusion.health(2).rejected == 1);
+    CHECK(fusion.health(0).used == 2);
+    CHECK_NEAR(fusion.health(0).weight, 1.0, 1e-3);
+
+    // Nothing usable: the fused fix is invalid
+    fusion.process(1, l86_test_no_fix(202.0));
+    fusion.flush();
+    CHECK(fused.size() == 3);
+    CHECK(fused[2].fix_status == L86::FixStatusGGA::INVALID);
+}
+}
+
+int main()
+{
+    test_receivers();
+    test_weighting();
+    test_outlier_and_missing();
+    return l86_test_result();
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <vector>
+
+#include "l86_geofence.h"
+#include "l86_test.h"
+
+namespace {
+// A 0.01 degree square, and a triangle overlapping its east side
+const L86Geofence::Vertex SQUARE[] = {
+    { 45000000, 5000000 },
+    { 45000000, 5010000 },
+    { 45010000, 5010000 },
+    { 45010000, 5000000 },
+};
+const L86Geofence::Vertex TRIANGLE[] = {
+    { 45000000, 5008000 },
+    { 45000000, 5020000 },
+    { 45010000, 5014000 },
+};
+const L86Geofence::Polygon POLYGONS[] = {
+    { SQUARE, 4, 10 },
+    { TRIANGLE, 3, 0 },
+};
+
+uint32_t cell_offsets[8 * 8 + 1];
+L86Geofence::CellEntry entries[256];
+uint16_t edges[512];
+
+std::vector<L86Geofence::Event> events;
+
+void record(const L86Geofence::Event &event)
+{
+    events.push_back(event);
+}
+
+bool has_event(L86Geofence::EventType type, uint16_t fence)
+{
+    for (const L86Geofence::Event &event : events) {
+        if (event.type == type && event.fence == fence) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void test_compile()
+{
+    L86Geofence::Index index;
+    L86Geofence::Buffers small = { cell_offsets, entries, 1, edges, 1 };
+    CHECK(!L86Geofence::compile(POLYGONS, 2, 8, 8, small, &index));
+    CHECK(index.entry_count > 1);
+
+    L86Geofence::Buffers buffers = { cell_offsets, entries, 256, edges, 512 };
+    CHECK(L86Geofence::compile(POLYGONS, 2, 8, 8, buffers, &index));
+    CHECK(index.polygon_count == 2);
+}
+
+void test_events()
+{
+    L86Geofence::Index index;
+    L86Geofence::Buffers buffers = { cell_offsets, entries, 256, edges, 512 };
+    CHECK(L86Geofence::compile(POLYGONS, 2, 8, 8, buffers, &index));
+    L86Geofence geofence(&index);
+    geofence.attach(record);
+
+    // Outside of both
+    geofence.process(l86_test_fix(0, 45.005f, 4.99f));
+    CHECK(!geofence.inside(0) && !geofence.inside(1));
+    CHECK(events.empty());
+
+    // Into the square only
+    geofence.process(l86_test_fix(1, 45.005f, 5.002f));
+    CHECK(geofence.inside(0) && !geofence.inside(1));
+    CHECK(events.size() == 1 && has_event(L86Geofence::EventType::ENTER, 0));
+
+    // Into the overlap, then dwelling in the square
+    geofence.process(l86_test_fix(2, 45.002f, 5.0095f));
+    CHECK(geofence.inside(0) && geofence.inside(1));
+    CHECK(has_event(L86Geofence::EventType::ENTER, 1));
+    geofence.process(l86_test_fix(11, 45.002f, 5.0095f));
+    CHECK(has_event(L86Geofence::EventType::DWELL, 0));
+
+    // A lost fix does not move out of the fences
+    events.clear();
+    geofence.process(l86_test_no_fix(12));
+    CHECK(geofence.inside(0) && geofence.inside(1));
+    CHECK(events.empty());
+
+    // Out of the square, still in the triangle
+    geofence.process(l86_test_fix(13, 45.002f, 5.012f));
+    CHECK(!geofence.inside(0) && geofence.inside(1));
+    CHECK(events.size() == 1 && has_event(L86Geofence::EventType::EXIT, 0));
+
+    // Out of the grid
+    geofence.process(l86_test_fix(14, 46.0f, 5.0f));
+    CHECK(!geofence.inside(0) && !geofence.inside(1));
+    CHECK(has_event(L86Geofence::EventType::EXIT, 1));
+    CHECK(geofence.overflows() == 0);
+}
+}
+
+int main()
+{
+    test_compile();
+    test_events();
+    return l86_test_result();
+}
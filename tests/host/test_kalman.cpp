@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_kalman.h"
+#include "l86_test.h"
+
+namespace {
+template <typename T> void test_axis()
+{
+    // Noisy positions of a 2 m/s constant-velocity track
+    L86KalmanAxis<T> axis;
+    axis.reset(T(0.0f), T(25.0f), T(0.0f), T(100.0f));
+    for (int i = 1; i <= 60; i++) {
+        axis.predict(T(1.0f), T(0.5f));
+        axis.update_position(T(2.0f * i + ((i % 2) ? 3.0f : -3.0f)), T(25.0f));
+    }
+    CHECK_NEAR(l86_to_float(axis.position()), 120.0f, 2.0f);
+    CHECK_NEAR(l86_to_float(axis.velocity()), 2.0f, 0.3f);
+    CHECK(l86_to_float(axis.position_variance()) < 25.0f);
+
+    axis.update_velocity(T(2.0f), T(0.01f));
+    CHECK_NEAR(l86_to_float(axis.velocity()), 2.0f, 0.05f);
+    axis.shift(T(100.0f));
+    CHECK_NEAR(l86_to_float(axis.position()), 20.0f, 2.0f);
+}
+
+void test_fixed_point()
+{
+    CHECK_NEAR(L86Fixed(1.5f).to_float(), 1.5f, 1e-4);
+    CHECK_NEAR((L86Fixed(1.5f) * L86Fixed(-2.0f)).to_float(), -3.0f, 1e-4);
+    CHECK_NEAR((L86Fixed(3.0f) / L86Fixed(4.0f)).to_float(), 0.75f, 1e-4);
+    CHECK((L86Fixed(3.0f) / L86Fixed(0.0f)).to_float() == 0.0f);
+    // Out of range values saturate, NaN is zero
+    CHECK(L86Fixed(1e6f).to_float() == L86Fixed::MAX);
+    CHECK(L86Fixed(-1e6f).to_float() == -L86Fixed::MAX);
+    CHECK(L86Fixed(NAN).to_float() == 0.0f);
+}
+
+void test_driver()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    // No fix yet: no estimate
+    l86_test_receive(&uart, "GPGGA,120000.000,,,,,0,0,99.99,,M,,M,,");
+    CHECK(isnan(l86.smoothed_latitude()));
+
+    for (int i = 1; i <= 5; i++) {
+        char body[MINMEA_MAX_LENGTH];
+        snprintf(body,
+                sizeof(body),
+                "GPGGA,1200%02d.000,4448.0000,N,00036.0000,W,1,8,1.0,50.0,M,0,M,,",
+                i);
+        l86_test_receive(&uart, body);
+    }
+    CHECK_NEAR(l86.smoothed_latitude(), 44.8, 1e-5);
+    CHECK_NEAR(l86.smoothed_longitude(), -0.6, 1e-5);
+    CHECK(l86.smoothed_covariance().north > 0.0f);
+
+    // An outage keeps the estimate, and the next fix restarts the filter on it
+    l86_test_receive(&uart, "GPGGA,120006.000,,,,,0,0,99.99,,M,,M,,");
+    CHECK_NEAR(l86.smoothed_latitude(), 44.8, 1e-5);
+    l86_test_receive(&uart, "GPGGA,120007.000,4500.0000,N,00036.0000,W,1,8,1.0,50.0,M,0,M,,");
+    CHECK_NEAR(l86.smoothed_latitude(), 45.0, 1e-5);
+    CHECK_NEAR(l86.smoothed_longitude(), -0.6, 1e-5);
+
+    // A jump out of the fixed-point range restarts the filter too
+    l86_test_receive(&uart, "GPGGA,120008.000,4600.0000,N,00036.0000,W,1,8,1.0,50.0,M,0,M,,");
+    CHECK_NEAR(l86.smoothed_latitude(), 46.0, 1e-5);
+}
+}
+
+int main()
+{
+    test_axis<float>();
+    test_axis<L86Fixed>();
+    test_fixed_point();
+    test_driver();
+    return l86_test_result();
+}
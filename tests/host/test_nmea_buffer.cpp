@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_nmea_buffer.h"
+#include "l86_test.h"
+
+namespace {
+const char RMC[] = "$GPRMC,120000.000,A,4448.0000,N,00036.0000,W,0.0,0.0,010121,,,A*6E\r\n";
+const char GGA[] = "$GPGGA,120000.000,4448.0000,N,00036.0000,W,1,8,1.0,50.0,M,0,M,,*6B\r\n";
+const size_t RMC_LENGTH = sizeof(RMC) - 1;
+const size_t GGA_LENGTH = sizeof(GGA) - 1;
+constexpr size_t BUFFER_SIZE = 160; // two sentences, not three
+
+int notifications = 0;
+
+void notify()
+{
+    notifications++;
+}
+
+void test_whole_sentences()
+{
+    L86NmeaBuffer<BUFFER_SIZE> buffer(L86NmeaBuffer<BUFFER_SIZE>::Policy::DROP_NEWEST, notify);
+    CHECK(buffer.empty());
+    CHECK(buffer.write(RMC, RMC_LENGTH));
+    CHECK(buffer.write(GGA, GGA_LENGTH));
+    CHECK(notifications == 2);
+
+    // A read too short for the second sentence only returns the first one
+    char data[BUFFER_SIZE];
+    CHECK(buffer.read(data, RMC_LENGTH + 10) == RMC_LENGTH);
+    CHECK(memcmp(data, RMC, RMC_LENGTH) == 0);
+    CHECK(buffer.read(data, 10) == 0);
+    CHECK(buffer.read(data, sizeof(data)) == GGA_LENGTH);
+    CHECK(memcmp(data, GGA, GGA_LENGTH) == 0);
+    CHECK(buffer.empty());
+}
+
+void test_wrap_around()
+{
+    L86NmeaBuffer<BUFFER_SIZE> buffer;
+    char data[BUFFER_SIZE];
+    for (int i = 0; i < 10; i++) {
+        CHECK(buffer.write(RMC, RMC_LENGTH));
+        CHECK(buffer.write(GGA, GGA_LENGTH));
+        CHECK(buffer.read(data, sizeof(data)) == RMC_LENGTH + GGA_LENGTH);
+        CHECK(memcmp(data, RMC, RMC_LENGTH) == 0);
+        CHECK(memcmp(data + RMC_LENGTH, GGA, GGA_LENGTH) == 0);
+    }
+    CHECK(buffer.dropped() == 0);
+}
+
+void test_drop_newest()
+{
+    L86NmeaBuffer<BUFFER_SIZE> buffer(L86NmeaBuffer<BUFFER_SIZE>::Policy::DROP_NEWEST);
+    CHECK(buffer.write(RMC, RMC_LENGTH));
+    CHECK(buffer.write(RMC, RMC_LENGTH));
+    CHECK(!buffer.write(GGA, GGA_LENGTH));
+    CHECK(buffer.dropped() == 1);
+
+    char data[BUFFER_SIZE];
+    CHECK(buffer.read(data, sizeof(data)) == 2 * RMC_LENGTH);
+    CHECK(memcmp(data + RMC_LENGTH, RMC, RMC_LENGTH) == 0);
+}
+
+void test_drop_oldest()
+{
+    L86NmeaBuffer<BUFFER_SIZE> buffer(L86NmeaBuffer<BUFFER_SIZE>::Policy::DROP_OLDEST);
+    CHECK(buffer.write(RMC, RMC_LENGTH));
+    CHECK(buffer.write(RMC, RMC_LENGTH));
+    CHECK(buffer.write(GGA, GGA_LENGTH));
+    CHECK(buffer.dropped() == 1);
+
+    char data[BUFFER_SIZE];
+    CHECK(buffer.read(data, sizeof(data)) == RMC_LENGTH + GGA_LENGTH);
+    CHECK(memcmp(data, RMC, RMC_LENGTH) == 0);
+    CHECK(memcmp(data + RMC_LENGTH, GGA, GGA_LENGTH) == 0);
+}
+}
+
+int main()
+{
+    test_whole_sentences();
+    test_wrap_around();
+    test_drop_newest();
+    test_drop_oldest();
+    return l86_test_result();
+}
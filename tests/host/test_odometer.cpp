@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_odometer.h"
+#include "l86_test.h"
+
+namespace {
+void test_distance()
+{
+    // 0.01 degree along a meridian, and along the equator
+    CHECK_NEAR(L86Odometer::distance(45000000, 0, 45010000, 0), 1111950, 10);
+    CHECK_NEAR(L86Odometer::distance(0, 0, 0, 10000), 1111950, 150);
+    // 0.01 degree of longitude at 60 degrees of latitude
+    CHECK_NEAR(L86Odometer::distance(60000000, 0, 60000000, 10000), 555975, 100);
+    // Across the antimeridian
+    CHECK_NEAR(L86Odometer::distance(0, 179995000, 0, -179995000), 1111950, 150);
+    CHECK(L86Odometer::distance(45000000, 5000000, 45000000, 5000000) == 0);
+}
+
+void test_accumulation()
+{
+    L86Odometer odometer;
+    CHECK(odometer.total_distance() == 0);
+
+    // 10 steps of about 11 m to the north
+    for (int i = 0; i <= 10; i++) {
+        odometer.process(l86_test_fix(i, 45.0f + i * 0.0001f, 0.5f));
+    }
+    CHECK_NEAR(odometer.total_distance(), 111, 2);
+    CHECK(odometer.trip_distance() == odometer.total_distance());
+
+    // Parked: jitter is not accumulated
+    for (int i = 0; i < 10; i++) {
+        L86::Fix fix = l86_test_fix(20 + i, 45.001f + (i % 2) * 0.00005f, 0.5f);
+        fix.speed_knots = 0.2f;
+        odometer.process(fix);
+    }
+    CHECK_NEAR(odometer.total_distance(), 111, 2);
+
+    // Fixes without position or with a large HDOP are ignored
+    odometer.reset_trip();
+    odometer.process(l86_test_no_fix(30));
+    L86::Fix imprecise = l86_test_fix(31, 46.0f, 0.5f);
+    imprecise.dilution_of_precision.horizontal = 20.0f;
+    odometer.process(imprecise);
+    CHECK(odometer.trip_distance() == 0);
+
+    odometer.process(l86_test_fix(32, 45.0011f, 0.5f));
+    CHECK_NEAR(odometer.trip_distance(), 11, 1);
+    CHECK_NEAR(odometer.total_distance(), 122, 2);
+}
+}
+
+int main()
+{
+    test_distance();
+    test_accumulation();
+    return l86_test_result();
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "kvstore_global_api.h"
+#include "l86_test.h"
+
+namespace {
+constexpr time_t SAVED_TIME = 1609502400; // 2021-01-01 12:00:00
+
+void test_no_state()
+{
+    kv_reset("/kv/");
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    CHECK(!l86.save_state());
+    CHECK(l86.restore_state(SAVED_TIME) == L86::RestoreResult::NO_STATE);
+}
+
+void test_restore_time()
+{
+    kv_reset("/kv/");
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    l86_test_receive(&uart, "GPRMC,120000.000,A,4448.0000,N,00036.0000,W,0.0,0.0,010121,,,A");
+    l86_test_receive(&uart, "GPGGA,120000.000,4448.0000,N,00036.0000,W,1,8,1.0,50.0,M,0,M,,");
+    CHECK(l86.save_state());
+
+    // Unset RTC: -1, or seconds since the power cycle
+    CHECK(l86.restore_state(-1) == L86::RestoreResult::UNKNOWN_TIME);
+    CHECK(l86.restore_state(42) == L86::RestoreResult::UNKNOWN_TIME);
+    CHECK(l86.restore_state(SAVED_TIME + MBED_CONF_L86_PERSISTENCE_MAX_AGE + 1)
+            == L86::RestoreResult::TOO_OLD);
+    CHECK(l86_test_transmit(&uart).empty());
+}
+}
+
+int main()
+{
+    test_no_state();
+    test_restore_time();
+    return l86_test_result();
+}
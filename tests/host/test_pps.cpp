@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_test.h"
+
+namespace {
+/* 2021-01-01 12:00:00 UTC */
+constexpr int64_t START_TIME = 1609502400;
+
+void rmc(UnbufferedSerial *uart, int second, int milliseconds = 0)
+{
+    char sentence[MINMEA_MAX_LENGTH];
+    snprintf(sentence,
+            sizeof(sentence),
+            "GPRMC,1200%02d.%03d,A,4448.0000,N,00036.0000,W,0.0,0.0,010121,,,A",
+            second,
+            milliseconds);
+    l86_test_receive(uart, sentence);
+}
+
+double utc_seconds(L86 &l86)
+{
+    return l86.utc_now().count() / 1e6 - START_TIME;
+}
+
+void test_pairing()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    // No edge, no sync
+    rmc(&uart, 0);
+    CHECK(l86.utc_now().count() == 0);
+    CHECK(!l86.pps_synchronized());
+
+    // The edge is paired with the whole second of the next RMC
+    l86.pps_edge(l86.now());
+    Timer::advance(100ms);
+    rmc(&uart, 1, 500);
+    CHECK(!l86.pps_synchronized());
+    rmc(&uart, 1);
+    CHECK(l86.pps_synchronized());
+    CHECK_NEAR(utc_seconds(l86), 1.1, 0.01);
+
+    Timer::advance(2s);
+    CHECK_NEAR(utc_seconds(l86), 3.1, 0.01);
+
+    // An edge older than a second is not paired
+    std::chrono::microseconds edge = l86.now();
+    l86.pps_edge(edge);
+    Timer::advance(1500ms);
+    rmc(&uart, 4);
+    CHECK_NEAR(utc_seconds(l86), 4.6, 0.01);
+
+    // Holdover: the clock keeps running, but is no longer synchronized
+    Timer::advance(std::chrono::seconds(MBED_CONF_L86_PPS_HOLDOVER));
+    CHECK(!l86.pps_synchronized());
+    CHECK_NEAR(utc_seconds(l86), 14.6, 0.01);
+}
+
+void test_drift()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    // Edges 10 s apart in UTC, 10.001 s apart in the driver clock: 100 ppm fast
+    std::chrono::microseconds edge = l86.now();
+    l86.pps_edge(edge);
+    rmc(&uart, 0);
+    CHECK(l86.pps_synchronized());
+    CHECK_NEAR(l86.clock_drift_ppm(), 0.0, 1e-3);
+
+    for (int second = 10; second <= 50; second += 10) {
+        Timer::advance(10001ms);
+        edge += 10001ms;
+        l86.pps_edge(edge);
+        rmc(&uart, second);
+    }
+    // The estimation converges towards 100 ppm
+    CHECK(l86.clock_drift_ppm() > 40.0f && l86.clock_drift_ppm() < 100.0f);
+
+    // A larger drift is a missed edge, and is not averaged
+    float drift = l86.clock_drift_ppm();
+    Timer::advance(11s);
+    edge += 11s;
+    l86.pps_edge(edge);
+    rmc(&uart, 59);
+    CHECK_NEAR(l86.clock_drift_ppm(), drift, 1e-3);
+    CHECK_NEAR(utc_seconds(l86), 59.0, 0.01);
+}
+}
+
+int main()
+{
+    test_pairing();
+    test_drift();
+    return l86_test_result();
+}
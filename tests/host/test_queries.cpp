@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_test.h"
+
+namespace {
+uint8_t frequency(const L86::NmeaOutput &output, L86::NmeaCommandType type)
+{
+    return output.frequencies[static_cast<size_t>(type)];
+}
+
+void test_replies()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    L86::FirmwareRelease release = {};
+    L86::CommandFuture future = l86.firmware_release_async(&release);
+    CHECK(l86_test_transmit(&uart).compare(0, 8, "$PMTK605") == 0);
+    l86_test_receive(&uart, "PMTK705,AXN_3.8_3333_1703091820,0001,L86-M33,1.0");
+    CHECK(future.get() == MINMEA_PMTK_FLAG_SUCCESS);
+    CHECK(strcmp(release.release, "AXN_3.8_3333_1703091820") == 0);
+    CHECK(strcmp(release.build_id, "0001") == 0);
+    CHECK(strcmp(release.product_model, "L86-M33") == 0);
+
+    // The acknowledge of a query does not complete it, its reply does
+    L86::NmeaOutput output = {};
+    future = l86.nmea_output_async(&output);
+    CHECK(l86_test_acknowledge(&uart) == "PMTK414");
+    CHECK(!future.ready());
+    l86_test_receive(&uart, "PMTK514,0,1,0,1,1,5,0,0,0,0,0,0,0,0,0,0,0,0,0");
+    CHECK(future.get() == MINMEA_PMTK_FLAG_SUCCESS);
+    CHECK(frequency(output, L86::NmeaCommandType::GLL) == 0);
+    CHECK(frequency(output, L86::NmeaCommandType::RMC) == 1);
+    CHECK(frequency(output, L86::NmeaCommandType::GGA) == 1);
+    CHECK(frequency(output, L86::NmeaCommandType::GSV) == 5);
+
+    uint16_t interval = 0;
+    future = l86.position_fix_interval_async(&interval);
+    CHECK(l86_test_transmit(&uart).compare(0, 8, "$PMTK400") == 0);
+    l86_test_receive(&uart, "PMTK500,1000,0,0,0.0,0.0");
+    CHECK(future.get() == MINMEA_PMTK_FLAG_SUCCESS);
+    CHECK(interval == 1000);
+
+    L86::EpoInfo info = {};
+    future = l86.epo_info_async(&info);
+    CHECK(l86_test_transmit(&uart).compare(0, 8, "$PMTK607") == 0);
+    l86_test_receive(&uart, "PMTK707,56,1468,172800,1470,151200,1468,259200,1468,259200");
+    CHECK(future.get() == MINMEA_PMTK_FLAG_SUCCESS);
+    CHECK(info.sets == 56);
+    CHECK(info.first_week == 1468 && info.first_tow == 172800);
+    CHECK(info.last_week == 1470 && info.last_tow == 151200);
+}
+
+void test_unanswered()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    // Unsolicited reply
+    l86_test_receive(&uart, "PMTK500,200,0,0,0.0,0.0");
+
+    // Rejected by the module
+    L86::FirmwareRelease release = {};
+    L86::CommandFuture future = l86.firmware_release_async(&release);
+    CHECK(l86_test_acknowledge(&uart, MINMEA_PMTK_FLAG_UNSUPPORTED) == "PMTK605");
+    CHECK(future.status() == L86::CommandStatus::UNSUPPORTED);
+
+    // Without reply, a late reply does not write the result any more
+    uint16_t interval = 0;
+    future = l86.position_fix_interval_async(&interval);
+    for (int i = 0; i < MBED_CONF_L86_PMTK_MAX_ATTEMPTS; i++) {
+        CHECK(l86_test_transmit(&uart).compare(0, 8, "$PMTK400") == 0);
+        Timeout::expire();
+    }
+    CHECK(future.status() == L86::CommandStatus::TIMEOUT);
+    l86_test_receive(&uart, "PMTK500,1000,0,0,0.0,0.0");
+    CHECK(interval == 0);
+}
+}
+
+int main()
+{
+    test_replies();
+    test_unanswered();
+    return l86_test_result();
+}
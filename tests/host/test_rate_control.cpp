@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_rate_control.h"
+#include "l86_test.h"
+
+namespace {
+L86::NmeaOutput full_output()
+{
+    L86::NmeaOutput output = {};
+    output.frequencies[static_cast<size_t>(L86::NmeaCommandType::RMC)] = 1;
+    output.frequencies[static_cast<size_t>(L86::NmeaCommandType::GGA)] = 1;
+    output.frequencies[static_cast<size_t>(L86::NmeaCommandType::GSA)] = 1;
+    output.frequencies[static_cast<size_t>(L86::NmeaCommandType::GSV)] = 1;
+    return output;
+}
+
+L86::Fix moving_fix(double seconds, float speed)
+{
+    L86::Fix fix = l86_test_fix(seconds, 45.0f, 0.5f);
+    fix.speed_knots = speed;
+    return fix;
+}
+
+void test_fast_interval()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+    CHECK(L86RateController(&l86, full_output(), 9600).fast_interval() == 300);
+    CHECK(L86RateController(&l86, full_output(), 38400).fast_interval() == 100);
+}
+
+void test_switch()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+    L86RateController controller(&l86, full_output(), 38400);
+
+    // Sentences of a same epoch are evaluated once
+    controller.process(moving_fix(1, 12.0f));
+    controller.process(moving_fix(1, 12.0f));
+    CHECK(l86_test_acknowledge(&uart) == "PMTK314,0,1,0,1,5,5,0,0,0,0,0,0,0,0,0,0,0,0,0");
+    CHECK(l86_test_acknowledge(&uart) == "PMTK220,100");
+    CHECK(l86_test_transmit(&uart).empty());
+
+    controller.process(moving_fix(1.1, 12.0f));
+    CHECK(controller.level() == L86RateController::Level::FAST);
+    CHECK(controller.switches() == 1);
+    CHECK(l86_test_transmit(&uart).empty());
+}
+
+void test_partial_failure()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+    L86RateController controller(&l86, full_output(), 38400);
+
+    // The throttled output is applied, the fast interval is not
+    controller.process(moving_fix(1, 12.0f));
+    CHECK(l86_test_acknowledge(&uart).compare(0, 7, "PMTK314") == 0);
+    CHECK(l86_test_acknowledge(&uart, MINMEA_PMTK_FLAG_FAILURE) == "PMTK220,100");
+
+    // Back to the normal level, which the module partly left: both settings are sent again
+    controller.process(moving_fix(2, 4.0f));
+    CHECK(controller.level() == L86RateController::Level::NORMAL);
+    CHECK(l86_test_acknowledge(&uart) == "PMTK220,1000");
+    CHECK(l86_test_acknowledge(&uart) == "PMTK314,0,1,0,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0");
+
+    controller.process(moving_fix(3, 4.0f));
+    controller.process(moving_fix(4, 4.0f));
+    CHECK(controller.level() == L86RateController::Level::NORMAL);
+    CHECK(l86_test_transmit(&uart).empty());
+}
+}
+
+int main()
+{
+    test_fast_interval();
+    test_switch();
+    test_partial_failure();
+    return l86_test_result();
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_test.h"
+
+namespace {
+void test_counters()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    l86_test_receive(&uart, "GPRMC,120000.000,A,4448.0000,N,00036.0000,W,0.0,0.0,010121,,,A");
+    l86_test_receive(&uart, "GPGGA,120000.000,4448.0000,N,00036.0000,W,1,8,1.0,50.0,M,0,M,,");
+    l86_test_receive(&uart, "GPGGA,120001.000,4448.0000,N,00036.0000,W,1,8,1.0,50.0,M,0,M,,");
+    l86_test_receive(&uart, "GPXYZ,1,2,3");
+    uart.rx += "$GPGGA,120002.000,4448.0000,N,00036.0000,W,1,8,1.0,50.0,M,0,M,,*00\r\n";
+    uart.rx += "$GPGGA," + std::string(MINMEA_MAX_LENGTH, '0') + "\r\n";
+    uart.irq[SerialBase::RxIrq]();
+
+    L86::Stats stats = l86.stats();
+    CHECK(stats.sentences[static_cast<size_t>(L86::NmeaCommandType::RMC)] == 1);
+    CHECK(stats.sentences[static_cast<size_t>(L86::NmeaCommandType::GGA)] == 2);
+    CHECK(stats.unknown_sentences == 1);
+    CHECK(stats.checksum_failures == 1);
+    CHECK(stats.framing_overflows == 1);
+    CHECK(stats.receive_cycles > 0);
+    CHECK(stats.parse_cycles > 0);
+
+    l86.reset_stats();
+    stats = l86.stats();
+    CHECK(stats.sentences[static_cast<size_t>(L86::NmeaCommandType::GGA)] == 0);
+    CHECK(stats.receive_cycles == 0);
+}
+
+void test_command_retries()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    L86::CommandFuture future = l86.set_position_fix_interval_async(1000);
+    for (int i = 0; i < MBED_CONF_L86_PMTK_MAX_ATTEMPTS; i++) {
+        CHECK(l86_test_transmit(&uart).compare(0, 12, "$PMTK220,100") == 0);
+        Timeout::expire();
+    }
+    CHECK(future.status() == L86::CommandStatus::TIMEOUT);
+
+    L86::Stats stats = l86.stats();
+    CHECK(stats.pmtk_retries == MBED_CONF_L86_PMTK_MAX_ATTEMPTS - 1);
+    CHECK(stats.pmtk_timeouts == 1);
+}
+}
+
+int main()
+{
+    test_counters();
+    test_command_retries();
+    return l86_test_result();
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <vector>
+
+#include "l86_test.h"
+#include "l86_trajectory.h"
+
+namespace {
+constexpr float METERS_PER_DEGREE = 111195.0f;
+
+std::vector<L86::Fix> kept;
+
+void keep(const L86::Fix &fix)
+{
+    kept.push_back(fix);
+}
+
+/* Fix at a distance from (45N, 0E), in m, the east distance at the equator scale */
+L86::Fix fix_at(double seconds, float north, float east, float course)
+{
+    L86::Fix fix = l86_test_fix(
+            seconds, 45.0f + north / METERS_PER_DEGREE, east / METERS_PER_DEGREE);
+    fix.course_over_ground = course;
+    return fix;
+}
+
+void test_straight_line()
+{
+    kept.clear();
+    L86TrajectoryCompressor compressor(5.0f, 30.0f, 5.0f);
+    compressor.attach(keep);
+
+    // 100 fixes along a meridian, with 2 m of lateral noise
+    for (int i = 0; i < 100; i++) {
+        compressor.process(fix_at(i, i * 10.0f, (i % 2) ? 2.0f : -2.0f, 0.0f));
+    }
+    compressor.flush();
+    CHECK(compressor.processed_count() == 100);
+    CHECK(kept.size() == 2);
+    CHECK(compressor.kept_count() == kept.size());
+    CHECK(kept.front().time == std::chrono::seconds(0));
+    CHECK(kept.back().time == std::chrono::seconds(99));
+}
+
+void test_turn()
+{
+    kept.clear();
+    L86TrajectoryCompressor compressor(5.0f, 30.0f, 5.0f);
+    compressor.attach(keep);
+
+    // North for 50 fixes, then east: the corner is kept
+    for (int i = 0; i <= 50; i++) {
+        compressor.process(fix_at(i, i * 10.0f, 0.0f, 0.0f));
+    }
+    for (int i = 1; i <= 50; i++) {
+        compressor.process(fix_at(50 + i, 500.0f, i * 10.0f, 90.0f));
+    }
+    compressor.process(l86_test_no_fix(101));
+    compressor.flush();
+    CHECK(compressor.processed_count() == 101);
+    CHECK(kept.size() >= 3 && kept.size() <= 4);
+
+    // Every dropped fix is within the max error of the kept track
+    bool corner_kept = false;
+    for (const L86::Fix &fix : kept) {
+        float north = (fix.latitude - 45.0f) * METERS_PER_DEGREE;
+        float east = fix.longitude * METERS_PER_DEGREE;
+        if (fabsf(north - 500.0f) < 11.0f && fabsf(east) < 11.0f) {
+            corner_kept = true;
+        }
+    }
+    CHECK(corner_kept);
+}
+
+void test_speed_change()
+{
+    kept.clear();
+    L86TrajectoryCompressor compressor(5.0f, 30.0f, 5.0f);
+    compressor.attach(keep);
+    for (int i = 0; i < 20; i++) {
+        L86::Fix fix = fix_at(i, i * 10.0f, 0.0f, 0.0f);
+        fix.speed_knots = i < 10 ? 5.0f : 20.0f;
+        compressor.process(fix);
+    }
+    compressor.flush();
+    // Both ends of the speed change are kept
+    CHECK(kept.size() == 4);
+    CHECK(kept.size() == 4 && kept[1].time == std::chrono::seconds(9)
+            && kept[2].time == std::chrono::seconds(10));
+}
+}
+
+int main()
+{
+    test_straight_line();
+    test_turn();
+    test_speed_change();
+    return l86_test_result();
+}
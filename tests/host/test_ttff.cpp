@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_test.h"
+
+namespace {
+/* One fix epoch, 1 s after the previous one */
+void epoch(UnbufferedSerial *uart, int second, int gsa_mode)
+{
+    char sentence[MINMEA_MAX_LENGTH];
+    Timer::advance(std::chrono::seconds(1));
+    bool fixed = gsa_mode > 1;
+    snprintf(sentence,
+            sizeof(sentence),
+            fixed ? "GPRMC,1200%02d.000,A,4448.0000,N,00036.0000,W,0.0,0.0,010121,,,A"
+                  : "GPRMC,1200%02d.000,V,,,,,0.00,0.00,010121,,,N",
+            second);
+    l86_test_receive(uart, sentence);
+    snprintf(sentence,
+            sizeof(sentence),
+            fixed ? "GPGGA,1200%02d.000,4448.0000,N,00036.0000,W,1,8,1.0,50.0,M,0,M,,"
+                  : "GPGGA,1200%02d.000,,,,,0,0,,,M,,M,,",
+            second);
+    l86_test_receive(uart, sentence);
+    snprintf(sentence, sizeof(sentence), "GPGSA,A,%d,,,,,,,,,,,,,,,", gsa_mode);
+    l86_test_receive(uart, sentence);
+}
+
+void test_start()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+    EventFlags::waiting() = [&uart]() { l86_test_transmit(&uart); };
+    CHECK(l86.start(L86::StartMode::WARM_START));
+    EventFlags::waiting() = nullptr;
+
+    // Fix after 5 s (2D), 3D 2 s later
+    int second = 0;
+    while (second < 4) {
+        epoch(&uart, second++, 1);
+    }
+    epoch(&uart, second++, 2);
+    epoch(&uart, second++, 2);
+    epoch(&uart, second++, 3);
+
+    L86::TtffReport report = l86.ttff_report();
+    CHECK(report.started && report.start_mode == L86::StartMode::WARM_START);
+    CHECK(report.first_sentence.count() / 1000 == 1);
+    CHECK(report.first_valid_rmc.count() / 1000 == 5);
+    CHECK(report.first_fix_2d.count() / 1000 == 5);
+    CHECK(report.first_fix_3d.count() / 1000 == 7);
+    CHECK(l86.time_to_first_fix(L86::StartMode::WARM_START).count() / 1000 == 5);
+    CHECK(l86.time_to_first_fix(L86::StartMode::HOT_START).count() == 0);
+
+    // Two losses of 2 and 4 s
+    epoch(&uart, second++, 1);
+    epoch(&uart, second++, 1);
+    epoch(&uart, second++, 3);
+    for (int i = 0; i < 4; i++) {
+        epoch(&uart, second++, 1);
+    }
+    epoch(&uart, second++, 3);
+    report = l86.ttff_report();
+    CHECK(report.fix_losses == 2);
+    CHECK(report.reacquisitions == 2);
+    CHECK(report.last_reacquisition.count() / 1000 == 4);
+    CHECK(report.max_reacquisition.count() / 1000 == 4);
+    CHECK(report.total_reacquisition.count() / 1000 == 6);
+
+    // A new start resets the report
+    EventFlags::waiting() = [&uart]() { l86_test_transmit(&uart); };
+    CHECK(l86.start(L86::StartMode::HOT_START));
+    EventFlags::waiting() = nullptr;
+    report = l86.ttff_report();
+    CHECK(report.start_mode == L86::StartMode::HOT_START);
+    CHECK(report.first_fix_2d.count() == 0 && report.fix_losses == 0);
+}
+}
+
+int main()
+{
+    test_start();
+    return l86_test_result();
+}
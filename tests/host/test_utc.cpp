@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2020-2021, CATIE
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "l86_test.h"
+
+namespace {
+void test_days_from_civil()
+{
+    CHECK(minmea_days_from_civil(1970, 1, 1) == 0);
+    CHECK(minmea_days_from_civil(2000, 3, 1) == 11017);
+    CHECK(minmea_days_from_civil(2021, 12, 31) == 18992);
+    CHECK(minmea_days_from_civil(1969, 12, 31) == -1);
+}
+
+void test_utc_time()
+{
+    UnbufferedSerial uart(NC, NC);
+    L86 l86(&uart);
+
+    l86_test_receive(&uart, "GPRMC,120000.000,A,4448.0000,N,00036.0000,W,0.0,0.0,010121,,,A");
+    CHECK(l86.time() == 1609502400);
+
+    // GGA only has the time of day, the date of the last RMC is kept
+    l86_test_receive(&uart, "GPGGA,120001.000,4448.0000,N,00036.0000,W,1,8,1.0,50.0,M,0,M,,");
+    CHECK(l86.time() == 1609502401);
+
+    l86_test_receive(&uart, "GPRMC,235959.000,A,4448.0000,N,00036.0000,W,0.0,0.0,290224,,,A");
+    CHECK(l86.time() == 1709251199);
+    l86_test_receive(&uart, "GPRMC,000000.000,A,4448.0000,N,00036.0000,W,0.0,0.0,010324,,,A");
+    CHECK(l86.time() == 1709251200);
+}
+}
+
+int main()
+{
+    test_days_from_civil();
+    test_utc_time();
+    return l86_test_result();
+}